@@ -0,0 +1,602 @@
+#include <iostream>
+
+#include <refx_colourselector/refx_colourselector.h>
+
+/*
+    Headless microbenchmarks for the colour selector's hot paths.
+
+    Usage: ColourSelectorBenchmarks [--filter <text>] [--output <file.json>]
+
+    Every benchmark reports the median of several samples in nanoseconds per
+    operation, plus pixels (or colours) per second where that makes sense. The
+    results are written as JSON, to stdout unless --output is given, so runs
+    from different builds can be diffed or compared by a script.
+*/
+
+namespace
+{
+
+using Params = reFX::ColourSelector::Params;
+
+//==============================================================================
+struct Result
+{
+    juce::String name;
+    double nsPerOp = 0.0;
+    double pixelsPerOp = 0.0;
+    juce::int64 iterations = 0;
+};
+
+constexpr int numSamples = 7;
+constexpr double targetSampleSeconds = 0.02;
+
+volatile juce::uint32 sink = 0;
+
+template <typename Fn>
+double timeIterations (Fn& fn, juce::int64 iterations)
+{
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (juce::int64 i = 0; i < iterations; ++i)
+        fn();
+
+    return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+}
+
+/** Finds an iteration count that takes about targetSampleSeconds, then returns the
+    median of numSamples samples.
+*/
+template <typename Fn>
+Result measure (const juce::String& name, double pixelsPerOp, Fn&& fn)
+{
+    fn();
+
+    juce::int64 iterations = 1;
+
+    while (timeIterations (fn, iterations) < targetSampleSeconds && iterations < (juce::int64 (1) << 30))
+        iterations *= 2;
+
+    std::vector<double> samples;
+
+    for (int i = 0; i < numSamples; ++i)
+        samples.push_back (timeIterations (fn, iterations) * 1.0e9 / (double) iterations);
+
+    std::sort (samples.begin(), samples.end());
+
+    return { name, samples[samples.size() / 2], pixelsPerOp, iterations };
+}
+
+struct Runner
+{
+    /** Returns true if the filter lets a benchmark run. */
+    bool wants (const juce::String& name) const
+    {
+        return filter.isEmpty() || name.containsIgnoreCase (filter);
+    }
+
+    template <typename Fn>
+    void run (const juce::String& name, double pixelsPerOp, Fn&& fn)
+    {
+        if (wants (name))
+            results.push_back (measure (name, pixelsPerOp, std::forward<Fn> (fn)));
+    }
+
+    /** Like run(), but calls prepare first, which builds whatever data the benchmark needs.
+        It's only called if the benchmark runs, so a filtered run doesn't pay for the large
+        images and palettes of the benchmarks it skips.
+    */
+    template <typename Prepare, typename Fn>
+    void run (const juce::String& name, double pixelsPerOp, Prepare&& prepare, Fn&& fn)
+    {
+        if (wants (name))
+        {
+            prepare();
+            results.push_back (measure (name, pixelsPerOp, std::forward<Fn> (fn)));
+        }
+    }
+
+    juce::String filter;
+    std::vector<Result> results;
+};
+
+//==============================================================================
+struct Channels
+{
+    explicit Channels (size_t num)
+        : a (num), b (num), c (num), x (num), y (num), z (num), argb (num)
+    {
+        juce::Random random (0x5eed);
+
+        for (size_t i = 0; i < num; ++i)
+        {
+            a[i] = random.nextFloat();
+            b[i] = random.nextFloat();
+            c[i] = random.nextFloat();
+        }
+    }
+
+    std::vector<float> a, b, c, x, y, z;
+    std::vector<juce::uint32> argb;
+};
+
+constexpr size_t batchSize = 4096;
+
+void addConversionBenchmarks (Runner& runner)
+{
+    Channels ch (batchSize);
+
+    runner.run ("ColourConversion::hsbToRgb", batchSize, [&]
+    {
+        reFX::ColourConversion::hsbToRgb (ch.a, ch.b, ch.c, ch.x, ch.y, ch.z);
+    });
+
+    runner.run ("ColourConversion::rgbToHsb", batchSize, [&]
+    {
+        reFX::ColourConversion::rgbToHsb (ch.a, ch.b, ch.c, ch.x, ch.y, ch.z);
+    });
+
+    runner.run ("ColourConversion::hsbToARGB", batchSize, [&]
+    {
+        reFX::ColourConversion::hsbToARGB (ch.a, ch.b, ch.c, 1.0f, ch.argb);
+    });
+
+    runner.run ("hsbToRgb (scalar)", batchSize, [&]
+    {
+        for (size_t i = 0; i < batchSize; ++i)
+        {
+            auto rgb = reFX::hsbToRgb ({ ch.a[i], ch.b[i], ch.c[i] });
+            ch.x[i] = rgb.r;
+            ch.y[i] = rgb.g;
+            ch.z[i] = rgb.b;
+        }
+    });
+
+    runner.run ("rgbToHsb (scalar)", batchSize, [&]
+    {
+        for (size_t i = 0; i < batchSize; ++i)
+        {
+            auto hsb = reFX::rgbToHsb ({ ch.a[i], ch.b[i], ch.c[i] });
+            ch.x[i] = hsb.h;
+            ch.y[i] = hsb.s;
+            ch.z[i] = hsb.b;
+        }
+    });
+
+    runner.run ("DeepColour::getColour (from HSB)", batchSize, [&]
+    {
+        for (size_t i = 0; i < batchSize; ++i)
+            sink = sink + reFX::DeepColour::fromHSB (ch.a[i], ch.b[i], ch.c[i], 1.0f).getColour().getARGB();
+    });
+
+    runner.run ("DeepColour::getColour (from RGB)", batchSize, [&]
+    {
+        for (size_t i = 0; i < batchSize; ++i)
+            sink = sink + reFX::DeepColour::fromRGBA (ch.a[i], ch.b[i], ch.c[i], 1.0f).getColour().getARGB();
+    });
+
+    const std::string_view texts[] = { "#ff8800", "rgb(255 136 0 / 50%)", "hsl(32deg, 100%, 50%)", "oklch(0.744 0.181 56.5)", "RebeccaPurple" };
+
+    runner.run ("ColourText::parse", (double) std::size (texts), [&]
+    {
+        for (auto text : texts)
+            sink = sink + (juce::uint32) reFX::ColourText::parse (text).has_value();
+    });
+
+    runner.run ("ColourText::format (hex)", batchSize, [&]
+    {
+        reFX::ColourText::Buffer buffer;
+
+        for (size_t i = 0; i < batchSize; ++i)
+            sink = sink + (juce::uint32) reFX::ColourText::format (reFX::DeepColour::fromRGBA (ch.a[i], ch.b[i], ch.c[i], 1.0f),
+                                                                   reFX::ColourText::Format::hex, true, buffer).size();
+    });
+}
+
+//==============================================================================
+struct Layout
+{
+    const char* name;
+    Params xParam, yParam, stripParam;
+};
+
+/** The plane and strip pairs that ColourSelector::updateParameters() uses. */
+const Layout layouts[] =
+{
+    { "hue",        Params::saturation, Params::brightness, Params::hue },
+    { "saturation", Params::hue,        Params::brightness, Params::saturation },
+    { "brightness", Params::hue,        Params::saturation, Params::brightness },
+    { "red",        Params::blue,       Params::green,      Params::red },
+    { "green",      Params::blue,       Params::red,        Params::green },
+    { "blue",       Params::red,        Params::green,      Params::blue },
+};
+
+void addPlaneBenchmarks (Runner& runner)
+{
+    auto colour = reFX::DeepColour::fromRGBA (0.8f, 0.4f, 0.2f, 1.0f);
+
+    for (auto size : { 256, 512, 1024 })
+    {
+        for (auto& layout : layouts)
+        {
+            auto name = juce::String ("Parameter2D::updateImage (") + layout.name + ", "
+                      + juce::String (size) + "x" + juce::String (size) + ")";
+
+            runner.run (name, double (size * size), [&]
+            {
+                auto image = reFX::ColourPlane::render (layout.xParam, layout.yParam, colour, size, size);
+                sink = sink + (juce::uint32) image.getWidth();
+            });
+        }
+    }
+
+    // perceptual planes go through the models' batch kernels and the gamut mask
+    const reFX::ColourModel* models[] = { &reFX::ColourModel::getHSL(),   &reFX::ColourModel::getOKLab(),
+                                          &reFX::ColourModel::getOKLCH(), &reFX::ColourModel::getCIELab() };
+
+    for (auto* model : models)
+    {
+        auto values = model->fromColour (colour);
+        auto name = "ColourPlane::render (" + model->getName() + ", 512x512)";
+
+        runner.run (name, 512.0 * 512.0, [&]
+        {
+            auto image = reFX::ColourPlane::render (*model, 1, 0, values, 0, 512, 512);
+            sink = sink + (juce::uint32) image.getWidth();
+        });
+    }
+
+    // what Parameter1D::paint costs when its cached strip is invalid
+    juce::Image target (juce::Image::ARGB, 48, 512, true);
+
+    for (auto& layout : layouts)
+    {
+        auto name = juce::String ("Parameter1D::paint (") + layout.name + ", 48x512)";
+
+        runner.run (name, 48.0 * 512.0, [&]
+        {
+            juce::Graphics g (target);
+            g.drawImage (reFX::ColourPlane::renderStrip (layout.stripParam, colour, 48, 512),
+                         target.getBounds().toFloat());
+        });
+    }
+
+    // what a slider track costs when one of the channels it depends on has changed
+    juce::Image track (juce::Image::ARGB, 256, 12, false);
+
+    for (auto& layout : layouts)
+    {
+        auto name = juce::String ("ColourPlane::renderTrack (") + layout.name + ", 256x12)";
+
+        runner.run (name, 256.0 * 12.0, [&]
+        {
+            juce::Image::BitmapData pixels (track, juce::Image::BitmapData::writeOnly);
+            reFX::ColourPlane::renderTrack (layout.stripParam, colour, pixels);
+        });
+    }
+
+    // the polar views re-render from their per-pixel tables; the first call builds them
+    reFX::PolarPlane::Wheel wheel;
+    reFX::PolarPlane::Triangle triangle;
+    float brightness = 0.0f;
+
+    runner.run ("PolarPlane::Wheel::render (512x512)", 512.0 * 512.0, [&]
+    {
+        brightness = brightness > 0.9f ? 0.1f : brightness + 0.1f;
+        sink = sink + (juce::uint32) wheel.render (brightness, 512).getWidth();
+    });
+
+    runner.run ("PolarPlane::Triangle::render (512x512)", 512.0 * 512.0, [&]
+    {
+        brightness = brightness > 0.9f ? 0.1f : brightness + 0.1f;
+        sink = sink + (juce::uint32) triangle.render (brightness, 512).getWidth();
+    });
+
+    // what a reopened popup pays for its plane when the cache already has it
+    auto* cache = reFX::ColourPlane::Cache::getInstance();
+    reFX::ColourPlane::Cache::Key key;
+    key.xChannel = (int) reFX::ColourSelector::Params::saturation;
+    key.yChannel = (int) reFX::ColourSelector::Params::brightness;
+    key.values[0] = 0.3f;
+    key.width = key.height = 512;
+
+    cache->add (key, reFX::ColourPlane::render (reFX::ColourSelector::Params::saturation, reFX::ColourSelector::Params::brightness,
+                                                colour, 512, 512));
+
+    runner.run ("ColourPlane::Cache::find (512x512)", 512.0 * 512.0, [&]
+    {
+        sink = sink + (juce::uint32) cache->find (key).getWidth();
+    });
+
+    runner.run ("ColourPlane::renderAlphaTrack (256x12)", 256.0 * 12.0, [&]
+    {
+        juce::Image::BitmapData pixels (track, juce::Image::BitmapData::writeOnly);
+        reFX::ColourPlane::renderAlphaTrack (colour, 6, juce::Colours::white, juce::Colour (0xffdddddd), pixels);
+    });
+}
+
+//==============================================================================
+void addSelectorBenchmarks (Runner& runner)
+{
+    using CS = reFX::ColourSelector;
+
+    // a headless selector isn't showing, so this is the synchronous fan-out even
+    // for selectors that would coalesce their updates on screen
+    CS selector (CS::showAlphaChannel | CS::showColourAtTop | CS::showRGBSliders | CS::showHSBSliders
+                  | CS::showColourspace | CS::showHexEdit | CS::showToggle);
+    selector.setSize (400, 600);
+
+    const reFX::DeepColour colours[] = { reFX::DeepColour::fromRGBA (0.8f, 0.4f, 0.2f, 1.0f),
+                                         reFX::DeepColour::fromRGBA (0.2f, 0.5f, 0.9f, 0.5f) };
+    int index = 0;
+
+    runner.run ("ColourSelector::update", 0.0, [&]
+    {
+        selector.setCurrentColour (colours[index ^= 1], juce::dontSendNotification);
+    });
+
+    // a theme editor's worth of selectors, built eagerly and lightweight
+    const auto fullFlags = CS::showAlphaChannel | CS::showColourAtTop | CS::showRGBSliders | CS::showHSBSliders
+                         | CS::showColourspace | CS::showHexEdit | CS::showToggle;
+
+    for (auto extraFlags : { 0, (int) CS::lightweight })
+    {
+        auto name = juce::String ("ColourSelector::ColourSelector (x100") + (extraFlags != 0 ? ", lightweight)" : ")");
+
+        runner.run (name, 100.0, [&]
+        {
+            std::vector<std::unique_ptr<CS>> selectors;
+
+            for (int i = 0; i < 100; ++i)
+                selectors.push_back (std::make_unique<CS> (fullFlags | extraFlags));
+
+            sink = sink + (juce::uint32) selectors.size();
+        });
+    }
+}
+
+//==============================================================================
+void addPaletteBenchmarks (Runner& runner)
+{
+    using Format = reFX::SwatchPalette::Format;
+
+    constexpr int numColours = 50000;
+
+    reFX::SwatchPalette palette;
+
+    auto createPalette = [&]
+    {
+        if (! palette.isEmpty())
+            return;
+
+        palette.reserve (numColours, numColours * 12);
+
+        juce::Random random (0x5eed);
+
+        for (int i = 0; i < numColours; ++i)
+            palette.add (juce::Colour (random.nextInt() | 0xff000000), ("Colour " + juce::String (i)).toStdString());
+    };
+
+    for (auto [name, format] : { std::pair ("gpl", Format::gimp), std::pair ("ase", Format::ase), std::pair ("binary", Format::binary) })
+    {
+        juce::MemoryOutputStream data;
+
+        auto createData = [&]
+        {
+            createPalette();
+
+            if (data.getDataSize() == 0)
+                palette.writeTo (data, format);
+        };
+
+        runner.run (juce::String ("SwatchPalette::writeTo (") + name + ")", numColours, createData, [&]
+        {
+            juce::MemoryOutputStream out (data.getDataSize());
+            palette.writeTo (out, format);
+            sink = sink + (juce::uint32) out.getDataSize();
+        });
+
+        runner.run (juce::String ("SwatchPalette::loadFrom (") + name + ")", numColours, createData, [&]
+        {
+            reFX::SwatchPalette loaded;
+            juce::MemoryInputStream in (data.getData(), data.getDataSize(), false);
+            loaded.loadFrom (in, format);
+            sink = sink + (juce::uint32) loaded.size();
+        });
+    }
+
+    reFX::NearestColourIndex rebuilt;
+
+    runner.run ("NearestColourIndex::build", numColours, createPalette, [&]
+    {
+        rebuilt.build (palette.getColours());
+    });
+
+    // the queries get an index of their own, so they measure a full index even when
+    // a filter skips the build benchmark
+    reFX::NearestColourIndex index;
+
+    auto createIndex = [&]
+    {
+        createPalette();
+
+        if (index.size() == 0)
+            index.build (palette.getColours());
+    };
+
+    Channels queries (batchSize);
+
+    runner.run ("NearestColourIndex::findNearest", batchSize, createIndex, [&]
+    {
+        for (size_t i = 0; i < batchSize; ++i)
+            sink = sink + (juce::uint32) index.findNearest (reFX::DeepColour::fromRGBA (queries.a[i], queries.b[i], queries.c[i], 1.0f));
+    });
+
+    std::array<reFX::NearestColourIndex::Match, 8> nearest;
+
+    runner.run ("NearestColourIndex::findNearest (k = 8)", batchSize, createIndex, [&]
+    {
+        for (size_t i = 0; i < batchSize; ++i)
+            sink = sink + (juce::uint32) index.findNearest (reFX::DeepColour::fromRGBA (queries.a[i], queries.b[i], queries.c[i], 1.0f), nearest);
+    });
+}
+
+//==============================================================================
+void addSamplerBenchmarks (Runner& runner)
+{
+    // an 8K frame, which is what the eyedropper captures from a full-screen source on a 4K display at 2x
+    juce::Image image;
+
+    auto createImage = [&]
+    {
+        if (image.isValid())
+            return;
+
+        image = juce::Image (juce::Image::ARGB, 7680, 4320, false);
+
+        juce::Image::BitmapData pixels (image, juce::Image::BitmapData::writeOnly);
+        juce::Random random (0x5eed);
+
+        for (int y = 0; y < pixels.height; ++y)
+        {
+            auto* line = reinterpret_cast<juce::uint32*> (pixels.getLinePointer (y));
+
+            for (int x = 0; x < pixels.width; ++x)
+                line[x] = (juce::uint32) random.nextInt() | 0xff000000;
+        }
+    };
+
+    reFX::ImageSampler rebuilt;
+
+    runner.run ("ImageSampler::setImage (7680x4320)", 7680.0 * 4320.0, createImage, [&]
+    {
+        rebuilt.setImage (image);
+    });
+
+    // the queries get a sampler of their own, so they measure real averages even when
+    // a filter skips the setImage benchmark
+    reFX::ImageSampler sampler;
+
+    auto createSampler = [&]
+    {
+        createImage();
+
+        if (sampler.isEmpty())
+            sampler.setImage (image);
+    };
+
+    juce::Random random (0x5eed);
+
+    for (int size : { 1, 11 })
+    {
+        runner.run ("ImageSampler::getAverage (" + juce::String (size) + "x" + juce::String (size) + ")", batchSize, createSampler, [&]
+        {
+            for (size_t i = 0; i < batchSize; ++i)
+                if (auto c = sampler.getAverage ({ random.nextInt (7680), random.nextInt (4320) }, size))
+                    sink = sink + c->getColour().getARGB();
+        });
+    }
+}
+
+//==============================================================================
+void addExtractorBenchmarks (Runner& runner)
+{
+    // a 50 megapixel photo-sized image, with smooth gradients and some noise so
+    // that most of the histogram's bins are hit
+    constexpr int width = 8192, height = 6144;
+    juce::Image image;
+
+    auto createImage = [&]
+    {
+        if (image.isValid())
+            return;
+
+        image = juce::Image (juce::Image::ARGB, width, height, false);
+
+        juce::Image::BitmapData pixels (image, juce::Image::BitmapData::writeOnly);
+        juce::Random random (0x5eed);
+
+        for (int y = 0; y < height; ++y)
+        {
+            auto* line = reinterpret_cast<juce::uint32*> (pixels.getLinePointer (y));
+
+            for (int x = 0; x < width; ++x)
+            {
+                auto noise = (juce::uint32) random.nextInt (16);
+                auto red   = (juce::uint32) (x * 240 / width) + noise;
+                auto green = (juce::uint32) (y * 240 / height) + noise;
+                auto blue  = (juce::uint32) ((x + y) * 120 / height) % 240 + noise;
+                line[x] = 0xff000000 | (red << 16) | (green << 8) | blue;
+            }
+        }
+    };
+
+    for (int numColours : { 8, 64 })
+    {
+        runner.run ("PaletteExtractor::extractColours (50 MP, " + juce::String (numColours) + " colours)", (double) width * height, createImage, [&]
+        {
+            sink = sink + (juce::uint32) reFX::PaletteExtractor::extractColours (image, numColours).size();
+        });
+    }
+}
+
+//==============================================================================
+juce::var toJSON (const std::vector<Result>& results)
+{
+    juce::Array<juce::var> list;
+
+    for (auto& r : results)
+    {
+        auto* item = new juce::DynamicObject();
+        item->setProperty ("name", r.name);
+        item->setProperty ("nsPerOp", r.nsPerOp);
+        item->setProperty ("pixelsPerSecond", r.pixelsPerOp > 0.0 ? r.pixelsPerOp * 1.0e9 / r.nsPerOp : 0.0);
+        item->setProperty ("iterations", r.iterations);
+        list.add (juce::var (item));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("instructionSet", juce::String (reFX::ColourConversion::getInstructionSetName()));
+    root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty ("results", list);
+
+    return juce::var (root);
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    Runner runner;
+    juce::File output;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        juce::String option (argv[i]);
+
+        if (option == "--filter")
+            runner.filter = argv[i + 1];
+        else if (option == "--output")
+            output = juce::File::getCurrentWorkingDirectory().getChildFile (argv[i + 1]);
+    }
+
+    addConversionBenchmarks (runner);
+    addPlaneBenchmarks (runner);
+    addSelectorBenchmarks (runner);
+    addPaletteBenchmarks (runner);
+    addSamplerBenchmarks (runner);
+    addExtractorBenchmarks (runner);
+
+    auto json = juce::JSON::toString (toJSON (runner.results));
+
+    if (output == juce::File())
+    {
+        std::cout << json << std::endl;
+        return 0;
+    }
+
+    return output.replaceWithText (json) ? 0 : 1;
+}
@@ -0,0 +1,1157 @@
+#include <iostream>
+
+#include <refx_colourselector/refx_colourselector.h>
+
+/*
+    Headless correctness checks for the parts of the module whose fast paths are
+    easy to get subtly wrong.
+
+    Usage: ColourSelectorChecks [--filter <text>]
+
+    Every check compares a fast path with a slow, obviously correct one or with
+    values written out by hand, and prints the first few mismatches it finds. The exit code is non-zero
+    if any check failed, so the checks can be run by a script next to the benchmarks.
+*/
+
+namespace
+{
+
+using Values = reFX::ColourModel::Values;
+
+//==============================================================================
+struct Checker
+{
+    template <typename Fn>
+    void run (const juce::String& name, Fn&& fn)
+    {
+        if (filter.isNotEmpty() && ! name.containsIgnoreCase (filter))
+            return;
+
+        numFailures = 0;
+        fn();
+
+        std::cout << (numFailures == 0 ? "pass  " : "FAIL  ") << name;
+
+        if (numFailures > 0)
+        {
+            std::cout << " (" << numFailures << " mismatches)";
+            ++numFailedChecks;
+        }
+
+        std::cout << std::endl;
+    }
+
+    void expect (bool condition, const juce::String& description)
+    {
+        if (! condition && numFailures++ < maxReportedFailures)
+            std::cout << "      " << description << std::endl;
+    }
+
+    static constexpr int maxReportedFailures = 5;
+
+    juce::String filter;
+    int numFailures = 0;
+    int numFailedChecks = 0;
+};
+
+//==============================================================================
+juce::String toHex (juce::uint32 value, int numDigits)
+{
+    return juce::String::toHexString ((juce::int64) value).paddedLeft ('0', numDigits);
+}
+
+//==============================================================================
+/** Three planes of components, such as red, green and blue, in the layout the
+    ColourConversion kernels take.
+*/
+using Planes = std::array<std::vector<float>, 3>;
+
+/** Hues on and either side of the sector boundaries, no saturation, no brightness and
+    everything in between, followed by random colours up to an odd number in total.
+*/
+Planes createHSBInputs (juce::Random& random)
+{
+    Planes planes;
+
+    auto add = [&planes] (float h, float s, float b)
+    {
+        planes[0].push_back (h);
+        planes[1].push_back (s);
+        planes[2].push_back (b);
+    };
+
+    for (auto h : { 0.0f, 1.0f / 6.0f, 2.0f / 6.0f, 0.5f, 4.0f / 6.0f, 5.0f / 6.0f, 1.0f,
+                    std::nextafter (1.0f, 0.0f), -0.25f, 1.25f, 7.5f })
+        for (auto s : { 0.0f, 0.3f, 1.0f })
+            for (auto b : { 0.0f, 0.7f, 1.0f })
+                add (h, s, b);
+
+    while (planes[0].size() < 1001)
+        add (random.nextFloat(), random.nextFloat(), random.nextFloat());
+
+    return planes;
+}
+
+/** Greys, black, white, ties between the largest components and random colours, with
+    the random ones spread outside 0.0 to 1.0 so that clipping and the gamut mask are
+    exercised.
+*/
+Planes createRGBInputs (juce::Random& random)
+{
+    Planes planes;
+
+    auto add = [&planes] (float r, float g, float b)
+    {
+        planes[0].push_back (r);
+        planes[1].push_back (g);
+        planes[2].push_back (b);
+    };
+
+    for (auto r : { 0.0f, 1.0e-6f, 0.5f, 1.0f })
+        for (auto g : { 0.0f, 1.0e-6f, 0.5f, 1.0f })
+            for (auto b : { 0.0f, 1.0e-6f, 0.5f, 1.0f })
+                add (r, g, b);
+
+    auto component = [&random] { return random.nextFloat() * 1.2f - 0.1f; };
+
+    while (planes[0].size() < 1001)
+        add (component(), component(), component());
+
+    return planes;
+}
+
+/** Calls fn (offset, length) for the whole of the inputs and for short runs starting at
+    odd offsets, so that the vector loops, their scalar tails and unaligned loads are all
+    covered.
+*/
+template <typename Fn>
+void forEachRun (size_t size, Fn&& fn)
+{
+    fn ((size_t) 0, size);
+
+    for (size_t offset : { 0, 1, 3 })
+        for (size_t length : { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33 })
+            fn (offset, length);
+}
+
+/** The premultiplied pixel the ARGB kernels should write for a colour, packed one
+    channel at a time.
+*/
+juce::uint32 toPremultipliedARGB (const reFX::RGB& rgb, float alpha)
+{
+    auto scale = alpha * 255.0f;
+
+    auto level = [scale] (float c)
+    {
+        return (juce::uint32) juce::roundToInt (juce::jlimit (0.0f, 1.0f, c) * scale);
+    };
+
+    return ((juce::uint32) juce::roundToInt (scale) << 24) | (level (rgb.r) << 16) | (level (rgb.g) << 8) | level (rgb.b);
+}
+
+/** True if no channel of the two pixels differs by more than the given number of levels. */
+bool isWithinLevels (juce::uint32 a, juce::uint32 b, int levels)
+{
+    for (int shift = 0; shift < 32; shift += 8)
+        if (std::abs ((int) ((a >> shift) & 0xff) - (int) ((b >> shift) & 0xff)) > levels)
+            return false;
+
+    return true;
+}
+
+void addConversionChecks (Checker& checker)
+{
+    namespace Conversion = reFX::ColourConversion;
+
+    // the documented agreement with the scalar conversions in DeepColour.h
+    constexpr float tolerance = 1.0e-6f;
+    constexpr float unwritten = -123.0f;
+    constexpr juce::uint32 unwrittenPixel = 0xdeadbeef;
+    constexpr juce::uint32 outOfGamutPixel = 0x12345678;
+    constexpr float gamutSlack = 1.0e-4f;
+
+    auto describe = [] (const Planes& in, size_t i, size_t offset, size_t length)
+    {
+        return "(" + juce::String (in[0][i], 8) + ", " + juce::String (in[1][i], 8) + ", " + juce::String (in[2][i], 8)
+                 + ") at " + juce::String ((int) i) + " of a run of " + juce::String ((int) length)
+                 + " from " + juce::String ((int) offset);
+    };
+
+    auto isOutside = [] (size_t i, size_t offset, size_t length)
+    {
+        return i < offset || i >= offset + length;
+    };
+
+    juce::Random random (0xc0c0);
+    auto hsbInputs = createHSBInputs (random);
+    auto rgbInputs = createRGBInputs (random);
+    auto size = hsbInputs[0].size();
+
+    checker.run ("ColourConversion hsbToRgb (" + juce::String (Conversion::getInstructionSetName()) + ")", [&]
+    {
+        auto& in = hsbInputs;
+
+        forEachRun (size, [&] (size_t offset, size_t length)
+        {
+            Planes out;
+            out.fill (std::vector<float> (size, unwritten));
+
+            auto run = [offset, length] (auto& plane) { return std::span (plane).subspan (offset, length); };
+            Conversion::hsbToRgb (run (in[0]), run (in[1]), run (in[2]), run (out[0]), run (out[1]), run (out[2]));
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                if (isOutside (i, offset, length))
+                {
+                    checker.expect (out[0][i] == unwritten && out[1][i] == unwritten && out[2][i] == unwritten,
+                                    describe (in, i, offset, length) + " was written");
+                    continue;
+                }
+
+                auto expected = reFX::hsbToRgb ({ in[0][i], in[1][i], in[2][i] });
+
+                checker.expect (std::abs (out[0][i] - expected.r) <= tolerance
+                                  && std::abs (out[1][i] - expected.g) <= tolerance
+                                  && std::abs (out[2][i] - expected.b) <= tolerance,
+                                describe (in, i, offset, length) + " is (" + juce::String (out[0][i], 8) + ", "
+                                  + juce::String (out[1][i], 8) + ", " + juce::String (out[2][i], 8) + ")");
+            }
+        });
+    });
+
+    checker.run ("ColourConversion rgbToHsb", [&]
+    {
+        auto& in = rgbInputs;
+
+        forEachRun (size, [&] (size_t offset, size_t length)
+        {
+            Planes out;
+            out.fill (std::vector<float> (size, unwritten));
+
+            auto run = [offset, length] (auto& plane) { return std::span (plane).subspan (offset, length); };
+            Conversion::rgbToHsb (run (in[0]), run (in[1]), run (in[2]), run (out[0]), run (out[1]), run (out[2]));
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                if (isOutside (i, offset, length))
+                {
+                    checker.expect (out[0][i] == unwritten && out[1][i] == unwritten && out[2][i] == unwritten,
+                                    describe (in, i, offset, length) + " was written");
+                    continue;
+                }
+
+                auto expected = reFX::rgbToHsb ({ in[0][i], in[1][i], in[2][i] });
+
+                // hue is circular, so 0.0 and 1.0 are the same hue
+                auto hueDistance = std::abs (out[0][i] - expected.h);
+                hueDistance = std::min (hueDistance, std::abs (1.0f - hueDistance));
+
+                checker.expect (out[0][i] >= 0.0f && out[0][i] <= 1.0f
+                                  && hueDistance <= tolerance
+                                  && std::abs (out[1][i] - expected.s) <= tolerance
+                                  && std::abs (out[2][i] - expected.b) <= tolerance,
+                                describe (in, i, offset, length) + " is (" + juce::String (out[0][i], 8) + ", "
+                                  + juce::String (out[1][i], 8) + ", " + juce::String (out[2][i], 8) + ")");
+            }
+        });
+    });
+
+    // the edge inputs include 0.5, which is a half level at full alpha, so rounding is covered too
+    for (auto alpha : { 1.0f, 0.5f, 0.3f })
+    {
+        auto name = " (alpha " + juce::String (alpha) + ")";
+
+        auto checkPixels = [&] (const Planes& in, const std::vector<juce::uint32>& pixels, size_t offset, size_t length,
+                                int levels, auto&& getExpected)
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                if (isOutside (i, offset, length))
+                {
+                    checker.expect (pixels[i] == unwrittenPixel, describe (in, i, offset, length) + " was written");
+                    continue;
+                }
+
+                auto expected = getExpected (i);
+
+                checker.expect (isWithinLevels (pixels[i], expected, levels),
+                                describe (in, i, offset, length) + " is " + toHex (pixels[i], 8) + ", not " + toHex (expected, 8));
+            }
+        };
+
+        checker.run ("ColourConversion rgbToARGB" + name, [&]
+        {
+            auto& in = rgbInputs;
+
+            forEachRun (size, [&] (size_t offset, size_t length)
+            {
+                std::vector<juce::uint32> pixels (size, unwrittenPixel);
+
+                auto run = [offset, length] (auto& plane) { return std::span (plane).subspan (offset, length); };
+                Conversion::rgbToARGB (run (in[0]), run (in[1]), run (in[2]), alpha, run (pixels));
+
+                // packing is a multiply and a rounding per channel, so it's exact
+                checkPixels (in, pixels, offset, length, 0, [&] (size_t i)
+                {
+                    return toPremultipliedARGB ({ in[0][i], in[1][i], in[2][i] }, alpha);
+                });
+            });
+        });
+
+        checker.run ("ColourConversion rgbToARGB with gamut mask" + name, [&]
+        {
+            auto& in = rgbInputs;
+
+            forEachRun (size, [&] (size_t offset, size_t length)
+            {
+                std::vector<juce::uint32> pixels (size, unwrittenPixel);
+
+                auto run = [offset, length] (auto& plane) { return std::span (plane).subspan (offset, length); };
+                Conversion::rgbToARGB (run (in[0]), run (in[1]), run (in[2]), alpha, run (pixels), outOfGamutPixel);
+
+                checkPixels (in, pixels, offset, length, 0, [&] (size_t i)
+                {
+                    auto isInside = [&] (float slack)
+                    {
+                        return std::all_of (in.begin(), in.end(), [&] (auto& plane) { return plane[i] >= -slack && plane[i] <= 1.0f + slack; });
+                    };
+
+                    auto clipped = toPremultipliedARGB ({ in[0][i], in[1][i], in[2][i] }, alpha);
+
+                    if (isInside (0.0f))
+                        return clipped;
+
+                    if (! isInside (gamutSlack))
+                        return outOfGamutPixel;
+
+                    // within the slack for rounding errors, either pixel is right
+                    return pixels[i] == outOfGamutPixel ? outOfGamutPixel : clipped;
+                });
+            });
+        });
+
+        checker.run ("ColourConversion hsbToARGB" + name, [&]
+        {
+            auto& in = hsbInputs;
+
+            forEachRun (size, [&] (size_t offset, size_t length)
+            {
+                std::vector<juce::uint32> pixels (size, unwrittenPixel);
+
+                auto run = [offset, length] (auto& plane) { return std::span (plane).subspan (offset, length); };
+                Conversion::hsbToARGB (run (in[0]), run (in[1]), run (in[2]), alpha, run (pixels));
+
+                // within tolerance, a component can still land on the other side of a rounding boundary
+                checkPixels (in, pixels, offset, length, 1, [&] (size_t i)
+                {
+                    return toPremultipliedARGB (reFX::hsbToRgb ({ in[0][i], in[1][i], in[2][i] }), alpha);
+                });
+            });
+        });
+    }
+
+    checker.run ("ColourConversion sRGB transfer functions", [&]
+    {
+        // the lookup tables are interpolated, so they only come close to the exact curves
+        constexpr double transferTolerance = 5.0e-5;
+
+        auto toSRGB = [] (double v) { return v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow (v, 1.0 / 2.4) - 0.055; };
+        auto toLinear = [] (double v) { return v <= 0.04045 ? v / 12.92 : std::pow ((v + 0.055) / 1.055, 2.4); };
+
+        // the curves are extended symmetrically below 0.0, and continue above 1.0
+        auto mirrored = [] (auto fn, float v) { return v < 0.0f ? -fn (-(double) v) : fn ((double) v); };
+
+        std::vector<float> in { 0.0f, 0.0031308f, 0.04045f, 1.0f, std::nextafter (1.0f, 0.0f), -1.0f, 1.5f };
+
+        while (in.size() < size)
+            in.push_back (random.nextFloat() * 3.0f - 1.0f);
+
+        forEachRun (size, [&] (size_t offset, size_t length)
+        {
+            auto run = [offset, length] (auto& plane) { return std::span (plane).subspan (offset, length); };
+
+            std::vector<float> encoded (size, unwritten), linear (size, unwritten);
+            Conversion::linearToSRGB (run (in), run (encoded));
+            Conversion::srgbToLinear (run (in), run (linear));
+
+            // converting in place, which the kernels allow
+            auto inPlace = in;
+            Conversion::linearToSRGB (run (inPlace), run (inPlace));
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                auto description = juce::String (in[i], 8) + " at " + juce::String ((int) i) + " of a run of "
+                                     + juce::String ((int) length) + " from " + juce::String ((int) offset);
+
+                if (isOutside (i, offset, length))
+                {
+                    checker.expect (encoded[i] == unwritten && linear[i] == unwritten && inPlace[i] == in[i],
+                                    description + " was written");
+                    continue;
+                }
+
+                checker.expect (std::abs (encoded[i] - mirrored (toSRGB, in[i])) <= transferTolerance,
+                                description + " is encoded as " + juce::String (encoded[i], 8));
+                checker.expect (std::abs (linear[i] - mirrored (toLinear, in[i])) <= transferTolerance,
+                                description + " is decoded as " + juce::String (linear[i], 8));
+                checker.expect (inPlace[i] == encoded[i], description + " is encoded differently in place");
+            }
+        });
+    });
+}
+
+//==============================================================================
+/** The pixel at (x, y) of a plane, converted on its own: the two channels are set on
+    the colour and the result goes through the scalar hsbToRgb().
+*/
+juce::uint32 getPlanePixel (reFX::ColourSelector::Params xParam, reFX::ColourSelector::Params yParam,
+                            const reFX::DeepColour& colour, int x, int y, int width, int height)
+{
+    using Params = reFX::ColourSelector::Params;
+
+    auto xValue = (float) x / (float) width;
+    auto yValue = 1.0f - (float) y / (float) height;
+
+    auto isHSB = [] (Params p) { return p == Params::hue || p == Params::saturation || p == Params::brightness; };
+
+    if (isHSB (xParam))
+    {
+        auto hsb = colour.getHSB();
+        float* channels[] = { &hsb.h, &hsb.s, &hsb.b };
+
+        *channels[(int) xParam] = xValue;
+        *channels[(int) yParam] = yValue;
+
+        return toPremultipliedARGB (reFX::hsbToRgb (hsb), 1.0f);
+    }
+
+    auto rgb = colour.getRGB();
+    float* channels[] = { &rgb.r, &rgb.g, &rgb.b };
+
+    *channels[(int) xParam - (int) Params::red] = xValue;
+    *channels[(int) yParam - (int) Params::red] = yValue;
+
+    return toPremultipliedARGB (rgb, 1.0f);
+}
+
+void addPlaneChecks (Checker& checker)
+{
+    using Params = reFX::ColourSelector::Params;
+
+    // the closed forms round differently from a conversion per pixel, but never by a whole level
+    constexpr int levels = 1;
+
+    const std::pair<Params, Params> layouts[] =
+    {
+        // the six that ColourSelector shows
+        { Params::saturation, Params::brightness }, { Params::hue, Params::brightness }, { Params::hue, Params::saturation },
+        { Params::blue, Params::green },            { Params::blue, Params::red },       { Params::red, Params::green },
+
+        // and the rest of the pairs within HSB and RGB, which take the other batch paths
+        { Params::brightness, Params::saturation }, { Params::brightness, Params::hue }, { Params::saturation, Params::hue },
+        { Params::green, Params::blue },            { Params::red, Params::blue },       { Params::green, Params::red },
+    };
+
+    const std::pair<int, int> sizes[] = { { 1, 1 }, { 7, 3 }, { 33, 17 }, { 256, 256 }, { 301, 97 } };
+
+    juce::Random random (0x91a4e);
+
+    std::vector<reFX::DeepColour> colours
+    {
+        reFX::DeepColour (reFX::HSB (0.0f, 1.0f, 1.0f)),
+        reFX::DeepColour (reFX::HSB (std::nextafter (1.0f, 0.0f), 1.0f, 1.0f)),
+        reFX::DeepColour (reFX::HSB (0.5f, 0.0f, 0.5f)),
+        reFX::DeepColour (reFX::HSB (1.0f / 3.0f, 0.6f, 0.0f)),
+        reFX::DeepColour::fromRGB (1.0f, 1.0f, 1.0f),
+    };
+
+    for (int i = 0; i < 3; ++i)
+        colours.push_back (reFX::DeepColour::fromRGB (random.nextFloat(), random.nextFloat(), random.nextFloat()));
+
+    auto paramNames = [] (Params p)
+    {
+        const char* names[] = { "hue", "saturation", "brightness", "red", "green", "blue" };
+        return juce::String (names[(int) p]);
+    };
+
+    for (auto [xParam, yParam] : layouts)
+    {
+        checker.run ("ColourPlane (" + paramNames (xParam) + ", " + paramNames (yParam) + ")", [&]
+        {
+            for (auto& colour : colours)
+            {
+                for (auto [width, height] : sizes)
+                {
+                    auto whole = reFX::ColourPlane::render (xParam, yParam, colour, width, height);
+
+                    // the background renderer fills a plane a few rows at a time
+                    juce::Image tiled (juce::Image::ARGB, width, height, false);
+
+                    {
+                        juce::Image::BitmapData dest (tiled, juce::Image::BitmapData::writeOnly);
+
+                        for (int startRow = 0; startRow < height; startRow += 5)
+                            reFX::ColourPlane::renderRows (xParam, yParam, colour, dest, startRow, startRow + 5);
+                    }
+
+                    juce::Image::BitmapData wholePixels (whole, juce::Image::BitmapData::readOnly);
+                    juce::Image::BitmapData tiledPixels (tiled, juce::Image::BitmapData::readOnly);
+
+                    for (int y = 0; y < height; ++y)
+                    {
+                        auto wholeLine = reinterpret_cast<const juce::uint32*> (wholePixels.getLinePointer (y));
+                        auto tiledLine = reinterpret_cast<const juce::uint32*> (tiledPixels.getLinePointer (y));
+
+                        for (int x = 0; x < width; ++x)
+                        {
+                            auto expected = getPlanePixel (xParam, yParam, colour, x, y, width, height);
+
+                            if (isWithinLevels (wholeLine[x], expected, levels) && tiledLine[x] == wholeLine[x])
+                                continue;
+
+                            auto description = colour.getColour().toDisplayString (false) + " at (" + juce::String (x) + ", "
+                                                 + juce::String (y) + ") of " + juce::String (width) + "x" + juce::String (height);
+
+                            checker.expect (isWithinLevels (wholeLine[x], expected, levels),
+                                            description + " is " + toHex (wholeLine[x], 8) + ", not " + toHex (expected, 8));
+                            checker.expect (tiledLine[x] == wholeLine[x],
+                                            description + " is " + toHex (tiledLine[x], 8) + " when rendered in tiles");
+                        }
+                    }
+                }
+            }
+        });
+    }
+}
+
+//==============================================================================
+/** Reads from memory without telling the reader how long the data is, as a network
+    or pipe stream would, so that a reader can't size anything from getTotalLength().
+*/
+class UnknownLengthStream  : public juce::InputStream
+{
+public:
+    UnknownLengthStream (const void* data, size_t numBytes)  : source (data, numBytes, false) {}
+
+    juce::int64 getTotalLength() override               { return -1; }
+    bool isExhausted() override                         { return source.isExhausted(); }
+    int read (void* dest, int numBytes) override        { return source.read (dest, numBytes); }
+    juce::int64 getPosition() override                  { return source.getPosition(); }
+    bool setPosition (juce::int64 position) override    { return source.setPosition (position); }
+
+private:
+    juce::MemoryInputStream source;
+};
+
+/** Random colours, some of them translucent, with names that need every length of
+    UTF-8 sequence and, in ASE files, a UTF-16 surrogate pair.
+*/
+void fillPalette (reFX::SwatchPalette& palette, int numColours, juce::Random& random)
+{
+    const char* names[] = { "", "Red", "\xc3\x9c" "nic" "\xc3\xb6" "de", "\xe8\x89\xb2",
+                            "\xf0\x9f\x8e\xa8" " palette", "a longer name, with spaces and punctuation!" };
+
+    palette.clear();
+
+    for (int i = 0; i < numColours; ++i)
+        palette.add (juce::Colour ((juce::uint32) random.nextInt()), names[(size_t) i % std::size (names)]);
+}
+
+juce::MemoryBlock writePalette (const reFX::SwatchPalette& palette, reFX::SwatchPalette::Format format)
+{
+    juce::MemoryOutputStream stream;
+    palette.writeTo (stream, format);
+    return stream.getMemoryBlock();
+}
+
+/** A copy of some data with a 32-bit value written over it. */
+juce::MemoryBlock withValue (const juce::MemoryBlock& data, size_t offset, juce::uint32 value, bool bigEndian)
+{
+    auto copy = data;
+    value = bigEndian ? juce::ByteOrder::swapIfLittleEndian (value) : juce::ByteOrder::swapIfBigEndian (value);
+    std::memcpy (static_cast<char*> (copy.getData()) + offset, &value, sizeof (value));
+    return copy;
+}
+
+void addPaletteChecks (Checker& checker)
+{
+    using Format = reFX::SwatchPalette::Format;
+
+    const std::pair<Format, juce::String> formats[] = { { Format::gimp, "gpl" }, { Format::ase, "ase" }, { Format::binary, "rfxpal" } };
+
+    juce::Random random (0x9a1e);
+
+    auto expectSame = [&checker] (const reFX::SwatchPalette& loaded, const reFX::SwatchPalette& original,
+                                  bool keepsAlpha, const juce::String& stage)
+    {
+        checker.expect (loaded.size() == original.size(),
+                        stage + ": " + juce::String (loaded.size()) + " colours instead of " + juce::String (original.size()));
+
+        for (int i = 0; i < juce::jmin (loaded.size(), original.size()); ++i)
+        {
+            auto colour = loaded.getColours()[(size_t) i];
+            auto expected = original.getColours()[(size_t) i] | (keepsAlpha ? 0u : 0xff000000u);
+
+            checker.expect (colour == expected,
+                            stage + ": colour " + juce::String (i) + " is " + toHex (colour, 8) + ", not " + toHex (expected, 8));
+            checker.expect (loaded.getNameUTF8 (i) == original.getNameUTF8 (i),
+                            stage + ": colour " + juce::String (i) + " is called \"" + loaded.getName (i)
+                              + "\", not \"" + original.getName (i) + "\"");
+        }
+    };
+
+    // a failed load must leave the palette as it was, so loads go into one that isn't empty
+    auto fillPrevious = [] (reFX::SwatchPalette& palette)
+    {
+        palette.clear();
+        palette.add (juce::Colour (0x80123456), "kept");
+        palette.add (juce::Colour (0xff654321), "also kept");
+    };
+
+    reFX::SwatchPalette previous;
+    fillPrevious (previous);
+
+    auto expectLoadFails = [&] (juce::InputStream& stream, Format format, const juce::String& description)
+    {
+        reFX::SwatchPalette palette;
+        fillPrevious (palette);
+
+        checker.expect (palette.loadFrom (stream, format).failed(), description + " was read");
+        expectSame (palette, previous, true, description);
+    };
+
+    // binary palettes are mapped from files rather than read, which has checks of its own
+    auto expectFileLoadFails = [&] (const juce::MemoryBlock& data, const juce::String& extension, const juce::String& description)
+    {
+        juce::TemporaryFile file ("." + extension);
+        file.getFile().replaceWithData (data.getData(), data.getSize());
+
+        reFX::SwatchPalette palette;
+        fillPrevious (palette);
+
+        checker.expect (palette.loadFrom (file.getFile()).failed(), description + " was read from a file");
+        expectSame (palette, previous, true, description + " in a file");
+    };
+
+    for (auto& [format, extension] : formats)
+    {
+        // GIMP and ASE palettes have no alpha, so they load as opaque colours
+        auto keepsAlpha = format == Format::binary;
+
+        checker.run ("SwatchPalette " + extension + " round trip", [&]
+        {
+            for (int numColours : { 0, 1, 7, 1000 })
+            {
+                reFX::SwatchPalette original, loaded;
+                fillPalette (original, numColours, random);
+
+                auto data = writePalette (original, format);
+                juce::MemoryInputStream stream (data, false);
+
+                auto stage = juce::String (numColours) + " colours";
+                auto result = loaded.loadFrom (stream, format);
+
+                checker.expect (result.wasOk(), stage + ": " + result.getErrorMessage());
+                expectSame (loaded, original, keepsAlpha, stage);
+            }
+
+            reFX::SwatchPalette original, loaded;
+            fillPalette (original, 1000, random);
+
+            juce::TemporaryFile file ("." + extension);
+            auto result = original.saveTo (file.getFile());
+            checker.expect (result.wasOk(), "saving: " + result.getErrorMessage());
+
+            result = loaded.loadFrom (file.getFile());
+            checker.expect (result.wasOk(), "loading: " + result.getErrorMessage());
+            expectSame (loaded, original, keepsAlpha, "through a file");
+        });
+    }
+
+    checker.run ("SwatchPalette gpl parsing", [&]
+    {
+        auto load = [] (reFX::SwatchPalette& palette, const std::string& text)
+        {
+            juce::MemoryInputStream stream (text.data(), text.size(), false);
+            return palette.loadFrom (stream, Format::gimp);
+        };
+
+        reFX::SwatchPalette expected, loaded;
+        expected.add (juce::Colour (0xff0080ff), "Blue-ish");
+        expected.add (juce::Colour (0xffff0007), "Clamped");
+        expected.add (juce::Colour (0xff010203));
+
+        // Windows line endings, headers, comments, blank lines, components out of range
+        // and a last line without a line ending
+        auto result = load (loaded, "GIMP Palette\r\nName: Test\r\nColumns: 4\r\n#\r\n# a comment\r\n\r\n"
+                                    "  0 128 255\tBlue-ish\r\n300 -5 7   Clamped  \r\n1 2 3");
+        checker.expect (result.wasOk(), result.getErrorMessage());
+        expectSame (loaded, expected, true, "a hand-written palette");
+
+        // a line longer than the reader's buffer is cut short, without losing the next one
+        result = load (loaded, "GIMP Palette\n1 2 3 " + std::string (100000, 'x') + "\n4 5 6 after\n");
+        checker.expect (result.wasOk() && loaded.size() == 2 && loaded.getColours()[1] == 0xff040506
+                          && loaded.getNameUTF8 (1) == "after",
+                        "an overlong line isn't skipped correctly");
+
+        for (auto text : { "", "JASC-PAL\n0100\n", "GIMP Palette\n255 0\n", "GIMP Palette\nred 0 0\n",
+                           "GIMP Palette\n1 2 3\n4 5 x\n" })
+        {
+            juce::MemoryInputStream stream (text, std::strlen (text), false);
+            expectLoadFails (stream, Format::gimp, "\"" + juce::String (text).replaceCharacter ('\n', ' ') + "\"");
+        }
+    });
+
+    checker.run ("SwatchPalette truncated files", [&]
+    {
+        reFX::SwatchPalette original;
+        fillPalette (original, 6, random);
+
+        for (auto& [format, extension] : formats)
+        {
+            // a text palette cut short between two lines is still a valid palette
+            if (format == Format::gimp)
+                continue;
+
+            auto data = writePalette (original, format);
+
+            for (size_t length = 0; length < data.getSize(); ++length)
+            {
+                auto description = extension + " cut short to " + juce::String ((int) length)
+                                     + " of " + juce::String ((int) data.getSize()) + " bytes";
+
+                juce::MemoryInputStream stream (data.getData(), length, false);
+                expectLoadFails (stream, format, description);
+
+                UnknownLengthStream unknownLength (data.getData(), length);
+                expectLoadFails (unknownLength, format, description + ", from a stream of unknown length");
+
+                expectFileLoadFails (juce::MemoryBlock (data.getData(), length), extension, description);
+            }
+        }
+    });
+
+    checker.run ("SwatchPalette corrupt files", [&]
+    {
+        reFX::SwatchPalette original;
+        fillPalette (original, 6, random);
+
+        auto ase = writePalette (original, Format::ase);
+        auto binary = writePalette (original, Format::binary);
+
+        // the binary layout: a 16-byte header, the colours, then numColours + 1 name offsets
+        auto numColours = (size_t) original.size();
+        auto offsetsStart = 16 + numColours * 4;
+        auto numNameBytes = juce::ByteOrder::littleEndianInt (static_cast<const char*> (binary.getData()) + 12);
+
+        struct CorruptFile
+        {
+            Format format;
+            juce::String extension;
+            juce::MemoryBlock data;
+            juce::String description;
+        };
+
+        const CorruptFile corruptFiles[] =
+        {
+            { Format::ase,    "ase",    withValue (ase, 0, 0x41534547, true),                         "the wrong magic number" },
+            { Format::ase,    "ase",    withValue (ase, 8, 0xffffffff, true),                         "a huge number of blocks" },
+            { Format::ase,    "ase",    withValue (ase, 14, 0xffffffff, true),                        "a huge block" },
+            { Format::binary, "rfxpal", withValue (binary, 0, 0, false),                              "no magic number" },
+            { Format::binary, "rfxpal", withValue (binary, 4, 2, false),                              "a newer version" },
+            { Format::binary, "rfxpal", withValue (binary, 8, 0xffffffff, false),                     "a huge number of colours" },
+            { Format::binary, "rfxpal", withValue (binary, 12, 0xffffffff, false),                    "a huge number of name bytes" },
+            { Format::binary, "rfxpal", withValue (binary, offsetsStart, 1, false),                   "a first name that doesn't start at 0" },
+            { Format::binary, "rfxpal", withValue (binary, offsetsStart + 8, 0xffffff, false),        "a name that runs past the names" },
+            { Format::binary, "rfxpal", withValue (binary, offsetsStart + numColours * 4, numNameBytes - 1, false),
+                                                                                                      "names that end early" },
+        };
+
+        for (auto& corrupt : corruptFiles)
+        {
+            auto description = corrupt.extension + " with " + corrupt.description;
+
+            juce::MemoryInputStream stream (corrupt.data, false);
+            expectLoadFails (stream, corrupt.format, description);
+
+            UnknownLengthStream unknownLength (corrupt.data.getData(), corrupt.data.getSize());
+            expectLoadFails (unknownLength, corrupt.format, description + ", from a stream of unknown length");
+
+            expectFileLoadFails (corrupt.data, corrupt.extension, description);
+        }
+    });
+}
+
+//==============================================================================
+/** The distance that NearestColourIndex measures, computed directly. ColourModel::getOKLab()
+    maps a and b from -0.4 to 0.4 onto 0 to 1, so they're scaled back first.
+*/
+float getOKLabDistance (const Values& x, const Values& y)
+{
+    return std::sqrt (juce::square (x[0] - y[0])
+                    + juce::square ((x[1] - y[1]) * 0.8f)
+                    + juce::square ((x[2] - y[2]) * 0.8f));
+}
+
+void addIndexChecks (Checker& checker)
+{
+    using Match = reFX::NearestColourIndex::Match;
+
+    constexpr float tolerance = 1.0e-4f;
+    auto& oklab = reFX::ColourModel::getOKLab();
+
+    checker.run ("NearestColourIndex (empty)", [&]
+    {
+        reFX::NearestColourIndex index;
+        std::array<Match, 4> nearest;
+
+        checker.expect (index.findNearest (reFX::DeepColour::fromRGB (0.5f, 0.5f, 0.5f)) == -1, "found a colour in an empty index");
+        checker.expect (index.findNearest (reFX::DeepColour::fromRGB (0.5f, 0.5f, 0.5f), nearest) == 0, "found colours in an empty index");
+    });
+
+    for (int numColours : { 1, 2, 7, 100, 1000, 50000 })
+    {
+        checker.run ("NearestColourIndex (" + juce::String (numColours) + " colours)", [&]
+        {
+            juce::Random random (0x5eed + numColours);
+
+            auto randomColour = [&random]
+            {
+                return juce::Colour ((juce::uint32) random.nextInt() | 0xff000000);
+            };
+
+            // some queries lie outside sRGB, so outside the grid, and land in its face cells
+            auto randomQuery = [&random]
+            {
+                auto component = [&random] { return random.nextFloat() * 1.6f - 0.3f; };
+                return reFX::DeepColour::fromRGB (component(), component(), component());
+            };
+
+            std::vector<juce::uint32> colours;
+
+            for (int i = 0; i < numColours; ++i)
+            {
+                // a few duplicates, so that ties between equally distant colours are covered
+                if (i > 0 && random.nextInt (10) == 0)
+                    colours.push_back (colours[(size_t) random.nextInt (i)]);
+                else
+                    colours.push_back (randomColour().getARGB());
+            }
+
+            reFX::NearestColourIndex index;
+            index.build (colours);
+
+            std::vector<Values> points;
+
+            for (auto c : colours)
+                points.push_back (oklab.fromColour (juce::Colour (c)));
+
+            auto checkQueries = [&] (const juce::String& stage)
+            {
+                std::array<Match, 8> nearest;
+                std::vector<float> distances (points.size());
+
+                for (int q = 0; q < 200; ++q)
+                {
+                    auto query = randomQuery();
+                    auto queryValues = oklab.fromColour (query);
+
+                    for (size_t i = 0; i < points.size(); ++i)
+                        distances[i] = getOKLabDistance (points[i], queryValues);
+
+                    auto sorted = distances;
+                    auto numExpected = std::min (nearest.size(), sorted.size());
+                    std::partial_sort (sorted.begin(), sorted.begin() + (ptrdiff_t) numExpected, sorted.end());
+
+                    auto describe = [&] { return stage + ", query " + juce::String (q) + " " + query.getColour().toDisplayString (false); };
+
+                    auto found = index.findNearest (query);
+                    checker.expect (juce::isPositiveAndBelow (found, numColours)
+                                      && std::abs (distances[(size_t) found] - sorted[0]) <= tolerance,
+                                    describe() + ": nearest is not the closest colour");
+
+                    auto numFound = index.findNearest (query, nearest);
+                    checker.expect ((size_t) numFound == numExpected, describe() + ": found " + juce::String (numFound) + " colours");
+
+                    for (size_t i = 0; i < std::min ((size_t) numFound, numExpected); ++i)
+                        checker.expect (std::abs (nearest[i].distance - sorted[i]) <= tolerance
+                                          && std::abs (distances[(size_t) nearest[i].index] - sorted[i]) <= tolerance,
+                                        describe() + ": match " + juce::String ((int) i) + " is out of order");
+                }
+            };
+
+            checkQueries ("after build");
+
+            // edits move colours between cells without rebuilding the index
+            for (int i = 0; i < numColours / 10 + 1; ++i)
+            {
+                auto edited = random.nextInt (numColours);
+                auto colour = randomColour();
+
+                index.update (edited, colour);
+                points[(size_t) edited] = oklab.fromColour (colour);
+            }
+
+            checkQueries ("after edits");
+        });
+    }
+}
+
+//==============================================================================
+/** The CSS named colours, written out again here rather than taken from the module,
+    so that a mistake in its table or its hash doesn't hide itself.
+*/
+struct NamedColour
+{
+    const char* name;
+    juce::uint32 rgb;
+};
+
+constexpr NamedColour namedColours[] =
+{
+    { "aliceblue", 0xf0f8ff },              { "antiquewhite", 0xfaebd7 },           { "aqua", 0x00ffff },
+    { "aquamarine", 0x7fffd4 },             { "azure", 0xf0ffff },                  { "beige", 0xf5f5dc },
+    { "bisque", 0xffe4c4 },                 { "black", 0x000000 },                  { "blanchedalmond", 0xffebcd },
+    { "blue", 0x0000ff },                   { "blueviolet", 0x8a2be2 },             { "brown", 0xa52a2a },
+    { "burlywood", 0xdeb887 },              { "cadetblue", 0x5f9ea0 },              { "chartreuse", 0x7fff00 },
+    { "chocolate", 0xd2691e },              { "coral", 0xff7f50 },                  { "cornflowerblue", 0x6495ed },
+    { "cornsilk", 0xfff8dc },               { "crimson", 0xdc143c },                { "cyan", 0x00ffff },
+    { "darkblue", 0x00008b },               { "darkcyan", 0x008b8b },               { "darkgoldenrod", 0xb8860b },
+    { "darkgray", 0xa9a9a9 },               { "darkgreen", 0x006400 },              { "darkgrey", 0xa9a9a9 },
+    { "darkkhaki", 0xbdb76b },              { "darkmagenta", 0x8b008b },            { "darkolivegreen", 0x556b2f },
+    { "darkorange", 0xff8c00 },             { "darkorchid", 0x9932cc },             { "darkred", 0x8b0000 },
+    { "darksalmon", 0xe9967a },             { "darkseagreen", 0x8fbc8f },           { "darkslateblue", 0x483d8b },
+    { "darkslategray", 0x2f4f4f },          { "darkslategrey", 0x2f4f4f },          { "darkturquoise", 0x00ced1 },
+    { "darkviolet", 0x9400d3 },             { "deeppink", 0xff1493 },               { "deepskyblue", 0x00bfff },
+    { "dimgray", 0x696969 },                { "dimgrey", 0x696969 },                { "dodgerblue", 0x1e90ff },
+    { "firebrick", 0xb22222 },              { "floralwhite", 0xfffaf0 },            { "forestgreen", 0x228b22 },
+    { "fuchsia", 0xff00ff },                { "gainsboro", 0xdcdcdc },              { "ghostwhite", 0xf8f8ff },
+    { "gold", 0xffd700 },                   { "goldenrod", 0xdaa520 },              { "gray", 0x808080 },
+    { "green", 0x008000 },                  { "greenyellow", 0xadff2f },            { "grey", 0x808080 },
+    { "honeydew", 0xf0fff0 },               { "hotpink", 0xff69b4 },                { "indianred", 0xcd5c5c },
+    { "indigo", 0x4b0082 },                 { "ivory", 0xfffff0 },                  { "khaki", 0xf0e68c },
+    { "lavender", 0xe6e6fa },               { "lavenderblush", 0xfff0f5 },          { "lawngreen", 0x7cfc00 },
+    { "lemonchiffon", 0xfffacd },           { "lightblue", 0xadd8e6 },              { "lightcoral", 0xf08080 },
+    { "lightcyan", 0xe0ffff },              { "lightgoldenrodyellow", 0xfafad2 },   { "lightgray", 0xd3d3d3 },
+    { "lightgreen", 0x90ee90 },             { "lightgrey", 0xd3d3d3 },              { "lightpink", 0xffb6c1 },
+    { "lightsalmon", 0xffa07a },            { "lightseagreen", 0x20b2aa },          { "lightskyblue", 0x87cefa },
+    { "lightslategray", 0x778899 },         { "lightslategrey", 0x778899 },         { "lightsteelblue", 0xb0c4de },
+    { "lightyellow", 0xffffe0 },            { "lime", 0x00ff00 },                   { "limegreen", 0x32cd32 },
+    { "linen", 0xfaf0e6 },                  { "magenta", 0xff00ff },                { "maroon", 0x800000 },
+    { "mediumaquamarine", 0x66cdaa },       { "mediumblue", 0x0000cd },             { "mediumorchid", 0xba55d3 },
+    { "mediumpurple", 0x9370db },           { "mediumseagreen", 0x3cb371 },         { "mediumslateblue", 0x7b68ee },
+    { "mediumspringgreen", 0x00fa9a },      { "mediumturquoise", 0x48d1cc },        { "mediumvioletred", 0xc71585 },
+    { "midnightblue", 0x191970 },           { "mintcream", 0xf5fffa },              { "mistyrose", 0xffe4e1 },
+    { "moccasin", 0xffe4b5 },               { "navajowhite", 0xffdead },            { "navy", 0x000080 },
+    { "oldlace", 0xfdf5e6 },                { "olive", 0x808000 },                  { "olivedrab", 0x6b8e23 },
+    { "orange", 0xffa500 },                 { "orangered", 0xff4500 },              { "orchid", 0xda70d6 },
+    { "palegoldenrod", 0xeee8aa },          { "palegreen", 0x98fb98 },              { "paleturquoise", 0xafeeee },
+    { "palevioletred", 0xdb7093 },          { "papayawhip", 0xffefd5 },             { "peachpuff", 0xffdab9 },
+    { "peru", 0xcd853f },                   { "pink", 0xffc0cb },                   { "plum", 0xdda0dd },
+    { "powderblue", 0xb0e0e6 },             { "purple", 0x800080 },                 { "rebeccapurple", 0x663399 },
+    { "red", 0xff0000 },                    { "rosybrown", 0xbc8f8f },              { "royalblue", 0x4169e1 },
+    { "saddlebrown", 0x8b4513 },            { "salmon", 0xfa8072 },                 { "sandybrown", 0xf4a460 },
+    { "seagreen", 0x2e8b57 },               { "seashell", 0xfff5ee },               { "sienna", 0xa0522d },
+    { "silver", 0xc0c0c0 },                 { "skyblue", 0x87ceeb },                { "slateblue", 0x6a5acd },
+    { "slategray", 0x708090 },              { "slategrey", 0x708090 },              { "snow", 0xfffafa },
+    { "springgreen", 0x00ff7f },            { "steelblue", 0x4682b4 },              { "tan", 0xd2b48c },
+    { "teal", 0x008080 },                   { "thistle", 0xd8bfd8 },                { "tomato", 0xff6347 },
+    { "turquoise", 0x40e0d0 },              { "violet", 0xee82ee },                 { "wheat", 0xf5deb3 },
+    { "white", 0xffffff },                  { "whitesmoke", 0xf5f5f5 },             { "yellow", 0xffff00 },
+    { "yellowgreen", 0x9acd32 },
+};
+
+/** Rounds a colour to 8 bits per channel. */
+juce::uint32 toARGB (const reFX::DeepColour& colour)
+{
+    return colour.getColour().getARGB();
+}
+
+void addTextChecks (Checker& checker)
+{
+    using reFX::ColourText::Format;
+
+    auto expectParsesTo = [&checker] (const juce::String& text, juce::uint32 expected)
+    {
+        auto parsed = reFX::ColourText::parse (text.toStdString());
+
+        checker.expect (parsed.has_value() && toARGB (*parsed) == expected,
+                        "\"" + text + "\" should be " + toHex (expected, 8)
+                          + (parsed.has_value() ? " but is " + toHex (toARGB (*parsed), 8) : " but isn't a colour"));
+    };
+
+    auto expectRejected = [&checker] (const juce::String& text)
+    {
+        checker.expect (! reFX::ColourText::parse (text.toStdString()).has_value(), "\"" + text + "\" shouldn't be a colour");
+    };
+
+    checker.run ("ColourText named colours", [&]
+    {
+        for (auto& named : namedColours)
+        {
+            expectParsesTo (named.name, 0xff000000 | named.rgb);
+            expectParsesTo (juce::String (named.name).toUpperCase(), 0xff000000 | named.rgb);
+
+            // cut short, a name must either be rejected or be another name
+            auto prefix = juce::String (named.name).dropLastCharacters (1);
+
+            if (std::none_of (std::begin (namedColours), std::end (namedColours), [&] (auto& n) { return prefix == n.name; }))
+                expectRejected (prefix);
+        }
+
+        expectParsesTo ("transparent", 0x00000000);
+        expectParsesTo ("  Transparent\t", 0x00000000);
+        expectParsesTo (" RebeccaPurple ", 0xff663399);
+
+        for (auto text : { "", "notacolour", "reds", "grey grey", "blue(0 0 255)" })
+            expectRejected (text);
+    });
+
+    checker.run ("ColourText hex", [&]
+    {
+        juce::Random random (0x4e8);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto argb = (juce::uint32) random.nextInt();
+            auto rrggbb = toHex (argb & 0xffffff, 6);
+            auto rrggbbaa = rrggbb + toHex (argb >> 24, 2);
+
+            expectParsesTo (rrggbb, argb | 0xff000000);
+            expectParsesTo ("#" + rrggbb.toUpperCase(), argb | 0xff000000);
+            expectParsesTo (rrggbbaa.toUpperCase(), argb);
+            expectParsesTo ("#" + rrggbbaa, argb);
+
+            // the short forms repeat every digit
+            auto nibbles = argb & 0x0f0f0f0f;
+            auto expanded = nibbles * 0x11;
+            auto rgb = juce::String::toHexString ((int) ((nibbles >> 16) & 0xf))
+                     + juce::String::toHexString ((int) ((nibbles >> 8) & 0xf))
+                     + juce::String::toHexString ((int) (nibbles & 0xf));
+            auto rgba = rgb + juce::String::toHexString ((int) (nibbles >> 24));
+
+            expectParsesTo (rgb, expanded | 0xff000000);
+            expectParsesTo ("#" + rgb.toUpperCase(), expanded | 0xff000000);
+            expectParsesTo (rgba, expanded);
+            expectParsesTo ("#" + rgba.toUpperCase(), expanded);
+        }
+
+        // the text field writes alpha last, as CSS does, not first like juce::Colour
+        reFX::ColourText::Buffer buffer;
+        auto orange = reFX::DeepColour (juce::uint32 (0x80ff8800));
+
+        checker.expect (reFX::ColourText::format (orange, Format::hex, false, buffer) == "FF8800", "hex without alpha isn't RRGGBB");
+        checker.expect (reFX::ColourText::format (orange, Format::hex, true, buffer) == "FF880080", "hex with alpha isn't RRGGBBAA");
+
+        for (auto text : { "#", "#12", "#12345", "#1234567", "#123456789", "#ggg", "##123", "12 34 56" })
+            expectRejected (text);
+    });
+
+    checker.run ("ColourText CSS syntax", [&]
+    {
+        // commas, spaces and '/' alpha
+        expectParsesTo ("rgb(255, 136, 0)",                 0xffff8800);
+        expectParsesTo ("rgb(255 136 0)",                   0xffff8800);
+        expectParsesTo ("rgba(255, 136, 0, 0.6)",           0x99ff8800);
+        expectParsesTo ("rgb(255 136 0 / 0.6)",             0x99ff8800);
+        expectParsesTo ("rgba(255 136 0 / 60%)",            0x99ff8800);
+        expectParsesTo ("rgb(100%, 0%, 0%, 60%)",           0x99ff0000);
+        expectParsesTo ("  RGB( 255 ,0,  0 )\t",            0xffff0000);
+        expectParsesTo ("rgb(300 -20 0)",                   0xffff0000);
+        expectParsesTo ("hsl(120, 100%, 50%)",              0xff00ff00);
+        expectParsesTo ("hsl(120 100% 50%)",                0xff00ff00);
+        expectParsesTo ("hsla(240deg 100% 50% / 0.6)",      0x990000ff);
+        expectParsesTo ("hsl(-120deg, 100%, 50%, 0.6)",     0x990000ff);
+        expectParsesTo ("hsl(0.5turn 100% 50%)",            0xff00ffff);
+        expectParsesTo ("hsl(200grad 100% 50%)",            0xff00ffff);
+        expectParsesTo ("hsl(3.14159265rad 100% 50%)",      0xff00ffff);
+        expectParsesTo ("hsl(0 0% 100%)",                   0xffffffff);
+        expectParsesTo ("oklch(0.62796 0.25768 29.234)",    0xffff0000);
+        expectParsesTo ("oklch(62.796% 64.42% 29.234deg)",  0xffff0000);
+        expectParsesTo ("oklch(1 0 0 / 0.6)",               0x99ffffff);
+
+        // numbers with exponents, and the other forms the scanner reads
+        expectParsesTo ("rgb(2.55e2 1.36E2 0e0)",           0xffff8800);
+        expectParsesTo ("rgb(25500e-2, +136, .0)",          0xffff8800);
+        expectParsesTo ("rgb(255 136 0 / 6e-1)",            0x99ff8800);
+        expectParsesTo ("rgb(255 136 0 / 6E+1%)",           0x99ff8800);
+        expectParsesTo ("hsl(1.2e2 1e2% 5e1%)",             0xff00ff00);
+        expectParsesTo ("rgb(1e999 0 0)",                   0xffff0000);
+        expectParsesTo ("rgb(1e-999 0 0)",                  0xff000000);
+
+        for (auto text : { "rgb(1 2)", "rgb(1, 2 3)", "rgb(1 2, 3)", "rgb(1, 2, 3 / 0.5)", "rgb(1 2 3, 0.5)",
+                           "rgb(1 2 3) x", "rgb(1 2 3", "rgb(1e 2 3)", "rgb(. 2 3)", "rgb(- 2 3)",
+                           "rgb()", "hsl(1 2 3 4)", "oklab(0.5 0 0)", "colour(1 2 3)" })
+            expectRejected (text);
+    });
+
+    checker.run ("ColourText format and parse", [&]
+    {
+        juce::Random random (0xf04a);
+
+        for (int i = 0; i < 5000; ++i)
+        {
+            auto argb = (juce::uint32) random.nextInt();
+            auto colour = reFX::DeepColour (argb);
+
+            for (auto format : { Format::hex, Format::rgb, Format::hsl, Format::oklch })
+            {
+                for (auto includeAlpha : { false, true })
+                {
+                    reFX::ColourText::Buffer buffer, again;
+                    auto text = reFX::ColourText::format (colour, format, includeAlpha, buffer);
+                    auto parsed = reFX::ColourText::parse (text);
+                    auto expected = includeAlpha ? argb : (argb | 0xff000000);
+
+                    auto description = toHex (argb, 8) + " as \"" + juce::String (std::string (text)) + "\"";
+
+                    if (! parsed.has_value())
+                    {
+                        checker.expect (false, description + " isn't a colour");
+                        continue;
+                    }
+
+                    if (format == Format::oklch)
+                    {
+                        // rounding to thousandths and tenths of a degree moves the colour by
+                        // less than 0.001 in OKLab, but often by more than a level in sRGB
+                        auto& oklab = reFX::ColourModel::getOKLab();
+                        auto distance = getOKLabDistance (oklab.fromColour (colour), oklab.fromColour (*parsed));
+
+                        checker.expect (distance < 0.001f && (toARGB (*parsed) >> 24) == (expected >> 24),
+                                        description + " reads back as " + toHex (toARGB (*parsed), 8));
+                        continue;
+                    }
+
+                    // the other formats are exact to 8 bits, so the text survives a second round trip
+                    checker.expect (toARGB (*parsed) == expected, description + " reads back as " + toHex (toARGB (*parsed), 8));
+
+                    auto textAgain = reFX::ColourText::format (*parsed, format, includeAlpha, again);
+                    checker.expect (textAgain == text, description + " is written again as \"" + juce::String (std::string (textAgain)) + "\"");
+                }
+            }
+        }
+    });
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    Checker checker;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+        if (juce::String (argv[i]) == "--filter")
+            checker.filter = argv[i + 1];
+
+    addConversionChecks (checker);
+    addPlaneChecks (checker);
+    addPaletteChecks (checker);
+    addIndexChecks (checker);
+    addTextChecks (checker);
+
+    return checker.numFailedChecks == 0 ? 0 : 1;
+}
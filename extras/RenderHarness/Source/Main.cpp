@@ -0,0 +1,333 @@
+#include <iostream>
+
+#include <refx_colourselector/refx_colourselector.h>
+
+/*
+    Offscreen render harness for ColourSelector.
+
+    Usage: ColourSelectorRenderHarness [--references <dir>] [--update-references]
+                                       [--tolerance <levels>] [--output <file.json>]
+
+    Every case builds a ColourSelector with one combination of options, size and
+    scale factor and paints it into an offscreen image with paintEntireComponent,
+    so no display is needed. The cold frame is everything up to the first frame
+    with the full-resolution plane: the first paint, which draws the coarse plane
+    and starts the full one in the background, the wait for that render, and the
+    paint that shows it. The warm frame is the median of further repaints of the
+    same component, which is what the user sees while interacting with it.
+
+    The rendered image is compared with <references>/<case>.png. A pixel matches
+    when none of its channels differs by more than the tolerance (default 2
+    levels). Run with --update-references once on a known-good build to create
+    or refresh the references; afterwards any mismatch makes the harness fail,
+    so renderer optimisations can be checked for visible changes.
+*/
+
+namespace
+{
+
+using CS = reFX::ColourSelector;
+
+//==============================================================================
+struct Options
+{
+    const char* name;
+    int flags;
+    CS::Params activeParam;
+    CS::PlaneShape shape = CS::PlaneShape::square;
+
+    /** The colour model of the colourspace, or nullptr for the HSB and RGB layouts. */
+    const reFX::ColourModel& (*model)() = nullptr;
+    int activeModelChannel = 0;
+};
+
+const Options optionSets[] =
+{
+    { "default",    CS::showAlphaChannel | CS::showColourAtTop | CS::showRGBSliders | CS::showColourspace,      CS::Params::hue },
+    { "full",       CS::showAlphaChannel | CS::showColourAtTop | CS::editableColour | CS::showRGBSliders
+                      | CS::showHSBSliders | CS::showToggle | CS::showReset | CS::showOriginalColour
+                      | CS::showColourspace | CS::showHexEdit,                                                  CS::Params::hue },
+    { "saturation", CS::showColourAtTop | CS::showHSBSliders | CS::showRGBSliders | CS::showToggle
+                      | CS::showColourspace,                                                                    CS::Params::saturation },
+    { "brightness", CS::showHSBSliders | CS::showRGBSliders | CS::showToggle | CS::showColourspace,             CS::Params::brightness },
+    { "red",        CS::showHSBSliders | CS::showRGBSliders | CS::showToggle | CS::showColourspace,             CS::Params::red },
+    { "green",      CS::showHSBSliders | CS::showRGBSliders | CS::showToggle | CS::showColourspace,             CS::Params::green },
+    { "blue",       CS::showHSBSliders | CS::showRGBSliders | CS::showToggle | CS::showColourspace,             CS::Params::blue },
+    { "spaceOnly",  CS::showColourspace,                                                                        CS::Params::hue },
+
+    // the colour model planes, which go through the models' batch kernels and the gamut mask
+    { "hsl",        CS::showHSBSliders | CS::showColourspace,   CS::Params::hue, CS::PlaneShape::square, &reFX::ColourModel::getHSL,    0 },
+    { "oklab",      CS::showHSBSliders | CS::showColourspace,   CS::Params::hue, CS::PlaneShape::square, &reFX::ColourModel::getOKLab,  0 },
+    { "oklch",      CS::showHSBSliders | CS::showColourspace,   CS::Params::hue, CS::PlaneShape::square, &reFX::ColourModel::getOKLCH,  2 },
+    { "cielab",     CS::showHSBSliders | CS::showColourspace,   CS::Params::hue, CS::PlaneShape::square, &reFX::ColourModel::getCIELab, 1 },
+
+    // the polar views
+    { "wheel",      CS::showHSBSliders | CS::showColourspace,   CS::Params::hue, CS::PlaneShape::wheel },
+    { "triangle",   CS::showHSBSliders | CS::showColourspace,   CS::Params::hue, CS::PlaneShape::triangle },
+
+    // only creates its components once it's showing, so its cold frame includes that
+    { "lightweight", CS::showAlphaChannel | CS::showColourAtTop | CS::showRGBSliders | CS::showHSBSliders
+                      | CS::showToggle | CS::showColourspace | CS::showHexEdit | CS::lightweight,              CS::Params::hue },
+};
+
+const juce::Point<int> sizes[] = { { 300, 400 }, { 640, 800 } };
+const float scales[] = { 1.0f, 2.0f };
+
+constexpr int numWarmFrames = 15;
+
+//==============================================================================
+struct CaseResult
+{
+    juce::String name;
+    double coldMs = 0.0;
+    double warmMs = 0.0;
+    int mismatchedPixels = 0;
+    int maxDifference = 0;
+    bool hasReference = false;
+    bool skipped = false;
+    juce::String error;
+};
+
+double paintInto (CS& selector, juce::Image& image, float scale)
+{
+    auto start = juce::Time::getHighResolutionTicks();
+
+    {
+        juce::Graphics g (image);
+        g.addTransform (juce::AffineTransform::scale (scale));
+        selector.paintEntireComponent (g, false);
+    }
+
+    return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1000.0;
+}
+
+/** Counts pixels whose channels differ by more than the tolerance, and the largest difference seen. */
+std::pair<int, int> compareImages (const juce::Image& a, const juce::Image& b, int tolerance)
+{
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight())
+        return { a.getWidth() * a.getHeight(), 255 };
+
+    juce::Image::BitmapData da (a, juce::Image::BitmapData::readOnly);
+    juce::Image::BitmapData db (b, juce::Image::BitmapData::readOnly);
+
+    int mismatches = 0;
+    int maxDiff = 0;
+
+    for (int y = 0; y < a.getHeight(); ++y)
+    {
+        for (int x = 0; x < a.getWidth(); ++x)
+        {
+            auto ca = da.getPixelColour (x, y);
+            auto cb = db.getPixelColour (x, y);
+
+            auto diff = juce::jmax (std::abs (ca.getRed()   - cb.getRed()),
+                                    std::abs (ca.getGreen() - cb.getGreen()),
+                                    std::abs (ca.getBlue()  - cb.getBlue()),
+                                    std::abs (ca.getAlpha() - cb.getAlpha()));
+
+            maxDiff = juce::jmax (maxDiff, diff);
+
+            if (diff > tolerance)
+                ++mismatches;
+        }
+    }
+
+    return { mismatches, maxDiff };
+}
+
+CaseResult runCase (const Options& options, juce::Point<int> size, float scale,
+                    const juce::File& references, bool updateReferences, int tolerance)
+{
+    CaseResult result;
+    result.name = juce::String (options.name) + "_" + juce::String (size.x) + "x" + juce::String (size.y)
+                + "@" + juce::String (scale, 1) + "x";
+
+    CS selector (options.flags);
+    selector.setSize (size.x, size.y);
+    selector.setActiveParam (options.activeParam);
+    selector.setPlaneShape (options.shape);
+
+    if (options.model != nullptr)
+    {
+        selector.setColourModel (&options.model());
+        selector.setActiveModelChannel (options.activeModelChannel);
+    }
+
+    selector.setCurrentColour (reFX::DeepColour::fromRGBA (0.85f, 0.45f, 0.2f, 0.8f), juce::dontSendNotification);
+
+    juce::Image image (juce::Image::ARGB, juce::roundToInt ((float) size.x * scale),
+                       juce::roundToInt ((float) size.y * scale), true);
+
+    // otherwise a case would find the planes of the cases before it in the cache
+    reFX::ColourPlane::Cache::getInstance()->clear();
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    // a lightweight selector stays empty until it's showing, which takes a window
+    if ((options.flags & CS::lightweight) != 0)
+    {
+        selector.addToDesktop (juce::ComponentPeer::windowIsTemporary);
+        selector.setVisible (true);
+
+        if (! selector.isShowing())
+        {
+            result.skipped = true;
+            return result;
+        }
+    }
+
+    result.coldMs = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1000.0;
+    result.coldMs += paintInto (selector, image, scale);
+
+    // there's no message loop to deliver the full-resolution plane, so wait for it here
+    start = juce::Time::getHighResolutionTicks();
+    selector.finishBackgroundRendering();
+    result.coldMs += juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1000.0;
+
+    image.clear (image.getBounds());
+    result.coldMs += paintInto (selector, image, scale);
+
+    std::vector<double> warm;
+
+    for (int i = 0; i < numWarmFrames; ++i)
+    {
+        image.clear (image.getBounds());
+        warm.push_back (paintInto (selector, image, scale));
+    }
+
+    std::sort (warm.begin(), warm.end());
+    result.warmMs = warm[warm.size() / 2];
+
+    auto referenceFile = references.getChildFile (result.name.replaceCharacter ('@', '_') + ".png");
+
+    if (updateReferences)
+    {
+        references.createDirectory();
+        referenceFile.deleteFile();
+
+        juce::FileOutputStream stream (referenceFile);
+        juce::PNGImageFormat png;
+
+        if (stream.openedOk() && png.writeImageToStream (image, stream))
+        {
+            stream.flush();
+            result.hasReference = stream.getStatus().wasOk();
+        }
+
+        if (! result.hasReference)
+            result.error = "couldn't write " + referenceFile.getFullPathName();
+    }
+    else if (referenceFile.existsAsFile())
+    {
+        auto reference = juce::ImageFileFormat::loadFrom (referenceFile);
+
+        if (reference.isValid())
+        {
+            std::tie (result.mismatchedPixels, result.maxDifference) = compareImages (image, reference.convertedToFormat (juce::Image::ARGB), tolerance);
+            result.hasReference = true;
+        }
+        else
+        {
+            result.error = "couldn't read " + referenceFile.getFullPathName();
+        }
+    }
+
+    return result;
+}
+
+juce::var toJSON (const std::vector<CaseResult>& results)
+{
+    juce::Array<juce::var> list;
+
+    for (auto& r : results)
+    {
+        auto* item = new juce::DynamicObject();
+        item->setProperty ("name", r.name);
+        item->setProperty ("coldFrameMs", r.coldMs);
+        item->setProperty ("warmFrameMs", r.warmMs);
+        item->setProperty ("hasReference", r.hasReference);
+        item->setProperty ("skipped", r.skipped);
+        item->setProperty ("error", r.error);
+        item->setProperty ("mismatchedPixels", r.mismatchedPixels);
+        item->setProperty ("maxDifference", r.maxDifference);
+        list.add (juce::var (item));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("instructionSet", juce::String (reFX::ColourConversion::getInstructionSetName()));
+    root->setProperty ("results", list);
+
+    return juce::var (root);
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    auto references = juce::File::getCurrentWorkingDirectory().getChildFile ("References");
+    auto updateReferences = false;
+    auto tolerance = 2;
+    juce::File output;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String option (argv[i]);
+        auto hasValue = i + 1 < argc;
+
+        if (option == "--update-references")
+            updateReferences = true;
+        else if (option == "--references" && hasValue)
+            references = juce::File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+        else if (option == "--tolerance" && hasValue)
+            tolerance = juce::String (argv[++i]).getIntValue();
+        else if (option == "--output" && hasValue)
+            output = juce::File::getCurrentWorkingDirectory().getChildFile (argv[++i]);
+    }
+
+    std::vector<CaseResult> results;
+    auto failed = false;
+
+    for (auto& options : optionSets)
+    {
+        for (auto size : sizes)
+        {
+            for (auto scale : scales)
+            {
+                auto r = runCase (options, size, scale, references, updateReferences, tolerance);
+
+                if (r.skipped)
+                {
+                    std::cerr << r.name << ": skipped, no window could be shown" << std::endl;
+                    results.push_back (r);
+                    continue;
+                }
+
+                std::cerr << r.name << ": cold " << r.coldMs << " ms, warm " << r.warmMs << " ms";
+
+                if (r.error.isNotEmpty())
+                    std::cerr << ", " << r.error;
+                else if (! r.hasReference)
+                    std::cerr << ", no reference";
+                else if (r.mismatchedPixels > 0)
+                    std::cerr << ", " << r.mismatchedPixels << " pixels differ (max " << r.maxDifference << ")";
+
+                std::cerr << std::endl;
+
+                failed = failed || r.mismatchedPixels > 0 || r.error.isNotEmpty();
+                results.push_back (r);
+            }
+        }
+    }
+
+    auto json = juce::JSON::toString (toJSON (results));
+
+    if (output == juce::File())
+        std::cout << json << std::endl;
+    else if (! output.replaceWithText (json))
+        return 1;
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,510 @@
+namespace reFX
+{
+
+namespace ColourConversion
+{
+
+namespace
+{
+
+constexpr float gamutTolerance = 1.0e-4f;
+
+//==============================================================================
+// Each backend exposes the same small set of operations, so the kernels below
+// are written once and instantiated per instruction set.
+struct ScalarOps
+{
+    using Type = float;
+    using Mask = bool;
+    static constexpr size_t width = 1;
+
+    static Type load (const float* p) noexcept                  { return *p; }
+    static void store (float* p, Type v) noexcept               { *p = v; }
+    static Type set (float v) noexcept                          { return v; }
+
+    static Type add (Type a, Type b) noexcept                   { return a + b; }
+    static Type sub (Type a, Type b) noexcept                   { return a - b; }
+    static Type mul (Type a, Type b) noexcept                   { return a * b; }
+    static Type div (Type a, Type b) noexcept                   { return a / b; }
+    static Type min (Type a, Type b) noexcept                   { return b < a ? b : a; }
+    static Type max (Type a, Type b) noexcept                   { return a < b ? b : a; }
+    static Type floor (Type a) noexcept                         { return std::floor (a); }
+
+    static Mask equal (Type a, Type b) noexcept                 { return a == b; }
+    static Mask greater (Type a, Type b) noexcept               { return a > b; }
+    static Mask greaterEqual (Type a, Type b) noexcept          { return a >= b; }
+    static Type select (Mask m, Type a, Type b) noexcept        { return m ? a : b; }
+    static Mask either (Mask a, Mask b) noexcept                { return a || b; }
+    static int toBits (Mask m) noexcept                         { return m ? 1 : 0; }
+
+    static void storeARGB (juce::uint32* p, Type a, Type r, Type g, Type b) noexcept
+    {
+        *p = (juce::uint32 (juce::roundToInt (a)) << 24)
+           | (juce::uint32 (juce::roundToInt (r)) << 16)
+           | (juce::uint32 (juce::roundToInt (g)) << 8)
+           |  juce::uint32 (juce::roundToInt (b));
+    }
+};
+
+#if REFX_COLOUR_USE_SSE2
+struct SSE2Ops
+{
+    using Type = __m128;
+    using Mask = __m128;
+    static constexpr size_t width = 4;
+
+    static Type load (const float* p) noexcept                  { return _mm_loadu_ps (p); }
+    static void store (float* p, Type v) noexcept               { _mm_storeu_ps (p, v); }
+    static Type set (float v) noexcept                          { return _mm_set1_ps (v); }
+
+    static Type add (Type a, Type b) noexcept                   { return _mm_add_ps (a, b); }
+    static Type sub (Type a, Type b) noexcept                   { return _mm_sub_ps (a, b); }
+    static Type mul (Type a, Type b) noexcept                   { return _mm_mul_ps (a, b); }
+    static Type div (Type a, Type b) noexcept                   { return _mm_div_ps (a, b); }
+    static Type min (Type a, Type b) noexcept                   { return _mm_min_ps (a, b); }
+    static Type max (Type a, Type b) noexcept                   { return _mm_max_ps (a, b); }
+
+    static Type floor (Type a) noexcept
+    {
+        // SSE2 has no floor, so truncate and step down where truncation rounded up
+        auto t = _mm_cvtepi32_ps (_mm_cvttps_epi32 (a));
+        return _mm_sub_ps (t, _mm_and_ps (_mm_cmpgt_ps (t, a), _mm_set1_ps (1.0f)));
+    }
+
+    static Mask equal (Type a, Type b) noexcept                 { return _mm_cmpeq_ps (a, b); }
+    static Mask greater (Type a, Type b) noexcept               { return _mm_cmpgt_ps (a, b); }
+    static Mask greaterEqual (Type a, Type b) noexcept          { return _mm_cmpge_ps (a, b); }
+    static Type select (Mask m, Type a, Type b) noexcept        { return _mm_or_ps (_mm_and_ps (m, a), _mm_andnot_ps (m, b)); }
+    static Mask either (Mask a, Mask b) noexcept                { return _mm_or_ps (a, b); }
+    static int toBits (Mask m) noexcept                         { return _mm_movemask_ps (m); }
+
+    static void storeARGB (juce::uint32* p, Type a, Type r, Type g, Type b) noexcept
+    {
+        auto argb = _mm_or_si128 (_mm_or_si128 (_mm_slli_epi32 (_mm_cvtps_epi32 (a), 24),
+                                                _mm_slli_epi32 (_mm_cvtps_epi32 (r), 16)),
+                                  _mm_or_si128 (_mm_slli_epi32 (_mm_cvtps_epi32 (g), 8),
+                                                _mm_cvtps_epi32 (b)));
+        _mm_storeu_si128 ((__m128i*) p, argb);
+    }
+};
+#endif
+
+#if REFX_COLOUR_USE_AVX2
+struct AVX2Ops
+{
+    using Type = __m256;
+    using Mask = __m256;
+    static constexpr size_t width = 8;
+
+    static Type load (const float* p) noexcept                  { return _mm256_loadu_ps (p); }
+    static void store (float* p, Type v) noexcept               { _mm256_storeu_ps (p, v); }
+    static Type set (float v) noexcept                          { return _mm256_set1_ps (v); }
+
+    static Type add (Type a, Type b) noexcept                   { return _mm256_add_ps (a, b); }
+    static Type sub (Type a, Type b) noexcept                   { return _mm256_sub_ps (a, b); }
+    static Type mul (Type a, Type b) noexcept                   { return _mm256_mul_ps (a, b); }
+    static Type div (Type a, Type b) noexcept                   { return _mm256_div_ps (a, b); }
+    static Type min (Type a, Type b) noexcept                   { return _mm256_min_ps (a, b); }
+    static Type max (Type a, Type b) noexcept                   { return _mm256_max_ps (a, b); }
+    static Type floor (Type a) noexcept                         { return _mm256_floor_ps (a); }
+
+    static Mask equal (Type a, Type b) noexcept                 { return _mm256_cmp_ps (a, b, _CMP_EQ_OQ); }
+    static Mask greater (Type a, Type b) noexcept               { return _mm256_cmp_ps (a, b, _CMP_GT_OQ); }
+    static Mask greaterEqual (Type a, Type b) noexcept          { return _mm256_cmp_ps (a, b, _CMP_GE_OQ); }
+    static Type select (Mask m, Type a, Type b) noexcept        { return _mm256_blendv_ps (b, a, m); }
+    static Mask either (Mask a, Mask b) noexcept                { return _mm256_or_ps (a, b); }
+    static int toBits (Mask m) noexcept                         { return _mm256_movemask_ps (m); }
+
+    static void storeARGB (juce::uint32* p, Type a, Type r, Type g, Type b) noexcept
+    {
+        auto argb = _mm256_or_si256 (_mm256_or_si256 (_mm256_slli_epi32 (_mm256_cvtps_epi32 (a), 24),
+                                                      _mm256_slli_epi32 (_mm256_cvtps_epi32 (r), 16)),
+                                     _mm256_or_si256 (_mm256_slli_epi32 (_mm256_cvtps_epi32 (g), 8),
+                                                      _mm256_cvtps_epi32 (b)));
+        _mm256_storeu_si256 ((__m256i*) p, argb);
+    }
+};
+#endif
+
+#if REFX_COLOUR_USE_NEON
+struct NeonOps
+{
+    using Type = float32x4_t;
+    using Mask = uint32x4_t;
+    static constexpr size_t width = 4;
+
+    static Type load (const float* p) noexcept                  { return vld1q_f32 (p); }
+    static void store (float* p, Type v) noexcept               { vst1q_f32 (p, v); }
+    static Type set (float v) noexcept                          { return vdupq_n_f32 (v); }
+
+    static Type add (Type a, Type b) noexcept                   { return vaddq_f32 (a, b); }
+    static Type sub (Type a, Type b) noexcept                   { return vsubq_f32 (a, b); }
+    static Type mul (Type a, Type b) noexcept                   { return vmulq_f32 (a, b); }
+    static Type div (Type a, Type b) noexcept                   { return vdivq_f32 (a, b); }
+    static Type min (Type a, Type b) noexcept                   { return vminq_f32 (a, b); }
+    static Type max (Type a, Type b) noexcept                   { return vmaxq_f32 (a, b); }
+    static Type floor (Type a) noexcept                         { return vrndmq_f32 (a); }
+
+    static Mask equal (Type a, Type b) noexcept                 { return vceqq_f32 (a, b); }
+    static Mask greater (Type a, Type b) noexcept               { return vcgtq_f32 (a, b); }
+    static Mask greaterEqual (Type a, Type b) noexcept          { return vcgeq_f32 (a, b); }
+    static Type select (Mask m, Type a, Type b) noexcept        { return vbslq_f32 (m, a, b); }
+    static Mask either (Mask a, Mask b) noexcept                { return vorrq_u32 (a, b); }
+
+    static int toBits (Mask m) noexcept
+    {
+        const uint32_t weights[] = { 1, 2, 4, 8 };
+        return (int) vaddvq_u32 (vandq_u32 (m, vld1q_u32 (weights)));
+    }
+
+    static void storeARGB (juce::uint32* p, Type a, Type r, Type g, Type b) noexcept
+    {
+        auto toInt = [] (Type v) { return vreinterpretq_u32_s32 (vcvtnq_s32_f32 (v)); };
+
+        auto argb = vorrq_u32 (vorrq_u32 (vshlq_n_u32 (toInt (a), 24), vshlq_n_u32 (toInt (r), 16)),
+                               vorrq_u32 (vshlq_n_u32 (toInt (g), 8),  toInt (b)));
+        vst1q_u32 (p, argb);
+    }
+};
+#endif
+
+#if REFX_COLOUR_USE_AVX2
+ using VectorOps = AVX2Ops;
+#elif REFX_COLOUR_USE_SSE2
+ using VectorOps = SSE2Ops;
+#elif REFX_COLOUR_USE_NEON
+ using VectorOps = NeonOps;
+#else
+ using VectorOps = ScalarOps;
+#endif
+
+//==============================================================================
+template <typename V>
+inline void hsbToRgb (typename V::Type h, typename V::Type s, typename V::Type v,
+                      typename V::Type& r, typename V::Type& g, typename V::Type& b) noexcept
+{
+    // Branch-free form of the sector switch in reFX::hsbToRgb():
+    // channel(n) = v - v * s * clamp (min (k, 4 - k), 0, 1), where k = (n + 6h) mod 6
+    auto six = V::set (6.0f);
+    auto h6 = V::mul (V::sub (h, V::floor (h)), six);
+    auto vs = V::mul (v, s);
+
+    auto channel = [&] (float n)
+    {
+        auto k = V::add (V::set (n), h6);
+        k = V::select (V::greaterEqual (k, six), V::sub (k, six), k);
+
+        auto t = V::min (V::min (k, V::sub (V::set (4.0f), k)), V::set (1.0f));
+        return V::sub (v, V::mul (vs, V::max (t, V::set (0.0f))));
+    };
+
+    r = channel (5.0f);
+    g = channel (3.0f);
+    b = channel (1.0f);
+}
+
+template <typename V>
+inline void rgbToHsb (typename V::Type r, typename V::Type g, typename V::Type b,
+                      typename V::Type& h, typename V::Type& s, typename V::Type& v) noexcept
+{
+    auto zero = V::set (0.0f);
+    auto one = V::set (1.0f);
+
+    auto maxVal = V::max (r, V::max (g, b));
+    auto minVal = V::min (r, V::min (g, b));
+    auto delta = V::sub (maxVal, minVal);
+
+    auto chromatic = V::greater (delta, zero);
+    auto safeDelta = V::select (chromatic, delta, one);
+    auto safeMax = V::select (chromatic, maxVal, one);
+
+    auto hr = V::div (V::sub (g, b), safeDelta);
+    auto hg = V::add (V::set (2.0f), V::div (V::sub (b, r), safeDelta));
+    auto hb = V::add (V::set (4.0f), V::div (V::sub (r, g), safeDelta));
+
+    auto hue = V::select (V::equal (maxVal, r), hr, V::select (V::equal (maxVal, g), hg, hb));
+    hue = V::mul (hue, V::set (1.0f / 6.0f));
+    hue = V::select (V::greater (zero, hue), V::add (hue, one), hue);
+
+    h = V::select (chromatic, hue, zero);
+    s = V::select (chromatic, V::div (delta, safeMax), zero);
+    v = maxVal;
+}
+
+template <typename V>
+inline void storeARGB (juce::uint32* dest, typename V::Type alpha,
+                       typename V::Type r, typename V::Type g, typename V::Type b) noexcept
+{
+    auto zero = V::set (0.0f);
+    auto one = V::set (1.0f);
+    auto scale = V::mul (alpha, V::set (255.0f));
+
+    auto premultiply = [&] (typename V::Type c)
+    {
+        return V::mul (V::max (V::min (c, one), zero), scale);
+    };
+
+    V::storeARGB (dest, scale, premultiply (r), premultiply (g), premultiply (b));
+}
+
+template <typename V>
+inline typename V::Mask isOutOfGamut (typename V::Type r, typename V::Type g, typename V::Type b) noexcept
+{
+    // a little slack, so that colours converted to a model and back aren't flagged by rounding errors
+    auto low = V::set (-gamutTolerance);
+    auto high = V::set (1.0f + gamutTolerance);
+
+    auto outside = [&] (typename V::Type c) { return V::either (V::greater (low, c), V::greater (c, high)); };
+
+    return V::either (outside (r), V::either (outside (g), outside (b)));
+}
+
+//==============================================================================
+template <typename V>
+size_t rgbToHsbLoop (const float* r, const float* g, const float* b,
+                     float* h, float* s, float* v, size_t begin, size_t end) noexcept
+{
+    for (; begin + V::width <= end; begin += V::width)
+    {
+        typename V::Type hh, ss, vv;
+        rgbToHsb<V> (V::load (r + begin), V::load (g + begin), V::load (b + begin), hh, ss, vv);
+        V::store (h + begin, hh);
+        V::store (s + begin, ss);
+        V::store (v + begin, vv);
+    }
+
+    return begin;
+}
+
+template <typename V>
+size_t hsbToRgbLoop (const float* h, const float* s, const float* v,
+                     float* r, float* g, float* b, size_t begin, size_t end) noexcept
+{
+    for (; begin + V::width <= end; begin += V::width)
+    {
+        typename V::Type rr, gg, bb;
+        hsbToRgb<V> (V::load (h + begin), V::load (s + begin), V::load (v + begin), rr, gg, bb);
+        V::store (r + begin, rr);
+        V::store (g + begin, gg);
+        V::store (b + begin, bb);
+    }
+
+    return begin;
+}
+
+template <typename V>
+size_t rgbToARGBLoop (const float* r, const float* g, const float* b, float alpha,
+                      juce::uint32* dest, size_t begin, size_t end) noexcept
+{
+    auto a = V::set (alpha);
+
+    for (; begin + V::width <= end; begin += V::width)
+        storeARGB<V> (dest + begin, a, V::load (r + begin), V::load (g + begin), V::load (b + begin));
+
+    return begin;
+}
+
+template <typename V>
+size_t rgbToARGBMaskedLoop (const float* r, const float* g, const float* b, float alpha, juce::uint32 outOfGamutPixel,
+                            juce::uint32* dest, size_t begin, size_t end) noexcept
+{
+    auto a = V::set (alpha);
+
+    for (; begin + V::width <= end; begin += V::width)
+    {
+        auto rr = V::load (r + begin);
+        auto gg = V::load (g + begin);
+        auto bb = V::load (b + begin);
+
+        storeARGB<V> (dest + begin, a, rr, gg, bb);
+
+        // out of gamut regions are usually large and contiguous, so patching
+        // the few flagged pixels is cheaper than blending every block
+        auto bits = V::toBits (isOutOfGamut<V> (rr, gg, bb));
+
+        for (size_t lane = 0; bits != 0; ++lane, bits >>= 1)
+            if ((bits & 1) != 0)
+                dest[begin + lane] = outOfGamutPixel;
+    }
+
+    return begin;
+}
+
+template <typename V>
+size_t hsbToARGBLoop (const float* h, const float* s, const float* v, float alpha,
+                      juce::uint32* dest, size_t begin, size_t end) noexcept
+{
+    auto a = V::set (alpha);
+
+    for (; begin + V::width <= end; begin += V::width)
+    {
+        typename V::Type rr, gg, bb;
+        hsbToRgb<V> (V::load (h + begin), V::load (s + begin), V::load (v + begin), rr, gg, bb);
+        storeARGB<V> (dest + begin, a, rr, gg, bb);
+    }
+
+    return begin;
+}
+
+//==============================================================================
+/** A transfer function sampled over 0.0 to 1.0 and linearly interpolated. Outside
+    that range the exact function is used, mirrored for negative values.
+*/
+struct TransferTable
+{
+    static constexpr int size = 4096;
+
+    template <typename Fn>
+    explicit TransferTable (Fn fn)  : exact (fn)
+    {
+        for (int i = 0; i <= size; ++i)
+            values[(size_t) i] = fn ((float) i / (float) size);
+    }
+
+    void apply (const float* in, float* out, size_t num) const noexcept
+    {
+        for (size_t i = 0; i < num; ++i)
+        {
+            auto v = in[i];
+            auto magnitude = std::abs (v);
+
+            float result;
+
+            if (magnitude < 1.0f)
+            {
+                auto pos = magnitude * (float) size;
+                auto index = (int) pos;
+                auto frac = pos - (float) index;
+
+                result = values[(size_t) index] + frac * (values[(size_t) index + 1] - values[(size_t) index]);
+            }
+            else
+            {
+                result = exact (magnitude);
+            }
+
+            out[i] = v < 0.0f ? -result : result;
+        }
+    }
+
+    std::array<float, size + 1> values;
+    float (*exact) (float);
+};
+
+float linearToSRGBExact (float v)
+{
+    return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow (v, 1.0f / 2.4f) - 0.055f;
+}
+
+float srgbToLinearExact (float v)
+{
+    return v <= 0.04045f ? v / 12.92f : std::pow ((v + 0.055f) / 1.055f, 2.4f);
+}
+
+const TransferTable& getLinearToSRGBTable()
+{
+    static const TransferTable table (linearToSRGBExact);
+    return table;
+}
+
+const TransferTable& getSRGBToLinearTable()
+{
+    static const TransferTable table (srgbToLinearExact);
+    return table;
+}
+
+} // namespace
+
+//==============================================================================
+void rgbToHsb (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+               std::span<float> hue, std::span<float> saturation, std::span<float> brightness) noexcept
+{
+    jassert (red.size() == green.size() && red.size() == blue.size());
+    jassert (red.size() == hue.size() && red.size() == saturation.size() && red.size() == brightness.size());
+
+    auto num = red.size();
+    auto i = rgbToHsbLoop<VectorOps> (red.data(), green.data(), blue.data(),
+                                      hue.data(), saturation.data(), brightness.data(), 0, num);
+
+    rgbToHsbLoop<ScalarOps> (red.data(), green.data(), blue.data(),
+                             hue.data(), saturation.data(), brightness.data(), i, num);
+}
+
+void hsbToRgb (std::span<const float> hue, std::span<const float> saturation, std::span<const float> brightness,
+               std::span<float> red, std::span<float> green, std::span<float> blue) noexcept
+{
+    jassert (hue.size() == saturation.size() && hue.size() == brightness.size());
+    jassert (hue.size() == red.size() && hue.size() == green.size() && hue.size() == blue.size());
+
+    auto num = hue.size();
+    auto i = hsbToRgbLoop<VectorOps> (hue.data(), saturation.data(), brightness.data(),
+                                      red.data(), green.data(), blue.data(), 0, num);
+
+    hsbToRgbLoop<ScalarOps> (hue.data(), saturation.data(), brightness.data(),
+                             red.data(), green.data(), blue.data(), i, num);
+}
+
+void rgbToARGB (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+                float alpha, std::span<juce::uint32> dest) noexcept
+{
+    jassert (red.size() == green.size() && red.size() == blue.size() && red.size() == dest.size());
+
+    alpha = juce::jlimit (0.0f, 1.0f, alpha);
+
+    auto num = red.size();
+    auto i = rgbToARGBLoop<VectorOps> (red.data(), green.data(), blue.data(), alpha, dest.data(), 0, num);
+    rgbToARGBLoop<ScalarOps> (red.data(), green.data(), blue.data(), alpha, dest.data(), i, num);
+}
+
+void rgbToARGB (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+                float alpha, std::span<juce::uint32> dest, juce::uint32 outOfGamutPixel) noexcept
+{
+    jassert (red.size() == green.size() && red.size() == blue.size() && red.size() == dest.size());
+
+    alpha = juce::jlimit (0.0f, 1.0f, alpha);
+
+    auto num = red.size();
+    auto i = rgbToARGBMaskedLoop<VectorOps> (red.data(), green.data(), blue.data(), alpha, outOfGamutPixel, dest.data(), 0, num);
+    rgbToARGBMaskedLoop<ScalarOps> (red.data(), green.data(), blue.data(), alpha, outOfGamutPixel, dest.data(), i, num);
+}
+
+void hsbToARGB (std::span<const float> hue, std::span<const float> saturation, std::span<const float> brightness,
+                float alpha, std::span<juce::uint32> dest) noexcept
+{
+    jassert (hue.size() == saturation.size() && hue.size() == brightness.size() && hue.size() == dest.size());
+
+    alpha = juce::jlimit (0.0f, 1.0f, alpha);
+
+    auto num = hue.size();
+    auto i = hsbToARGBLoop<VectorOps> (hue.data(), saturation.data(), brightness.data(), alpha, dest.data(), 0, num);
+    hsbToARGBLoop<ScalarOps> (hue.data(), saturation.data(), brightness.data(), alpha, dest.data(), i, num);
+}
+
+void linearToSRGB (std::span<const float> linear, std::span<float> encoded) noexcept
+{
+    jassert (linear.size() == encoded.size());
+    getLinearToSRGBTable().apply (linear.data(), encoded.data(), linear.size());
+}
+
+void srgbToLinear (std::span<const float> encoded, std::span<float> linear) noexcept
+{
+    jassert (linear.size() == encoded.size());
+    getSRGBToLinearTable().apply (encoded.data(), linear.data(), encoded.size());
+}
+
+const char* getInstructionSetName() noexcept
+{
+   #if REFX_COLOUR_USE_AVX2
+    return "AVX2";
+   #elif REFX_COLOUR_USE_SSE2
+    return "SSE2";
+   #elif REFX_COLOUR_USE_NEON
+    return "NEON";
+   #else
+    return "scalar";
+   #endif
+}
+
+} // namespace ColourConversion
+
+} // namespace reFX
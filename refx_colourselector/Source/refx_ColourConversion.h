@@ -0,0 +1,85 @@
+#pragma once
+
+namespace reFX
+{
+
+//==============================================================================
+/**
+    Batch colour conversion kernels.
+
+    These convert whole arrays of colours at once. Components are passed as
+    separate float arrays (structure of arrays) in the range 0.0 to 1.0, and the
+    kernels use SSE2, AVX2 or NEON where the compiler targets them, with a
+    scalar fallback for everything else and for the tail of each array.
+
+    All spans passed to a single call must have the same size.
+
+    @tags{Graphics}
+*/
+namespace ColourConversion
+{
+    /** Converts red, green and blue values to hue, saturation and brightness.
+
+        Matches calling rgbToHsb() on every element to within 1.0e-6. The hue is
+        computed in a different order, so the last bit can differ.
+    */
+    void rgbToHsb (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+                   std::span<float> hue, std::span<float> saturation, std::span<float> brightness) noexcept;
+
+    /** Converts hue, saturation and brightness values to red, green and blue.
+
+        Matches calling hsbToRgb() on every element to within 1.0e-6, since the
+        compiler may fuse the multiplies and adds of the scalar version. Hue values
+        outside 0.0 to 1.0 wrap around.
+    */
+    void hsbToRgb (std::span<const float> hue, std::span<const float> saturation, std::span<const float> brightness,
+                   std::span<float> red, std::span<float> green, std::span<float> blue) noexcept;
+
+    /** Packs red, green and blue values into 32-bit ARGB pixels.
+
+        The pixels are premultiplied by alpha, which is the layout juce::Image::ARGB
+        uses, so the result can be written straight into a BitmapData line.
+        Components are clipped to 0.0 to 1.0 before packing.
+    */
+    void rgbToARGB (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+                    float alpha, std::span<juce::uint32> dest) noexcept;
+
+    /** Converts hue, saturation and brightness values directly into premultiplied
+        32-bit ARGB pixels.
+
+        @see rgbToARGB
+    */
+    void hsbToARGB (std::span<const float> hue, std::span<const float> saturation, std::span<const float> brightness,
+                    float alpha, std::span<juce::uint32> dest) noexcept;
+
+    /** Packs red, green and blue values into premultiplied 32-bit ARGB pixels like
+        rgbToARGB(), except that pixels with a component outside 0.0 to 1.0 are set
+        to outOfGamutPixel instead of being clipped. Components within 1.0e-4 of that
+        range still count as inside it, so rounding errors aren't flagged.
+
+        This is how colour models whose gamut is larger than sRGB mark the parts of
+        a plane that can't be shown.
+    */
+    void rgbToARGB (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+                    float alpha, std::span<juce::uint32> dest, juce::uint32 outOfGamutPixel) noexcept;
+
+    /** Applies the sRGB transfer function, converting linear light to encoded values.
+
+        This interpolates a lookup table rather than calling std::pow for every
+        element. Values outside 0.0 to 1.0 are extended symmetrically, so they stay
+        outside that range and can still be detected as out of gamut afterwards.
+        The input and output may be the same span.
+    */
+    void linearToSRGB (std::span<const float> linear, std::span<float> encoded) noexcept;
+
+    /** Removes the sRGB transfer function, converting encoded values to linear light.
+
+        @see linearToSRGB
+    */
+    void srgbToLinear (std::span<const float> encoded, std::span<float> linear) noexcept;
+
+    /** Returns the name of the instruction set the kernels were compiled for. */
+    const char* getInstructionSetName() noexcept;
+}
+
+} // namespace reFX
@@ -0,0 +1,348 @@
+namespace reFX
+{
+
+namespace
+{
+
+//==============================================================================
+/** Cube root from a bit-level first guess and three Newton steps, which is
+    accurate to float precision and much cheaper than std::cbrt.
+*/
+inline float fastCbrt (float x) noexcept
+{
+    auto a = std::abs (x);
+    auto y = std::bit_cast<float> (std::bit_cast<juce::uint32> (a) / 3 + 709921077u);
+
+    for (int i = 0; i < 3; ++i)
+        y = (2.0f * y + a / (y * y)) * (1.0f / 3.0f);
+
+    return x < 0.0f ? -y : y;
+}
+
+/** Cosine and sine of an angle in turns, interpolated from a table. */
+struct SinCosTable
+{
+    static constexpr int size = 1024;
+
+    SinCosTable()
+    {
+        for (int i = 0; i <= size; ++i)
+        {
+            auto angle = juce::MathConstants<float>::twoPi * (float) i / (float) size;
+            cosines[(size_t) i] = std::cos (angle);
+            sines[(size_t) i]   = std::sin (angle);
+        }
+    }
+
+    void get (float turns, float& c, float& s) const noexcept
+    {
+        auto pos = (turns - std::floor (turns)) * (float) size;
+        auto index = juce::jmin ((int) pos, size - 1);
+        auto frac = pos - (float) index;
+
+        c = cosines[(size_t) index] + frac * (cosines[(size_t) index + 1] - cosines[(size_t) index]);
+        s = sines[(size_t) index]   + frac * (sines[(size_t) index + 1]   - sines[(size_t) index]);
+    }
+
+    std::array<float, size + 1> cosines, sines;
+};
+
+const SinCosTable& getSinCosTable()
+{
+    static const SinCosTable table;
+    return table;
+}
+
+void encode (std::span<float> red, std::span<float> green, std::span<float> blue) noexcept
+{
+    ColourConversion::linearToSRGB (red, red);
+    ColourConversion::linearToSRGB (green, green);
+    ColourConversion::linearToSRGB (blue, blue);
+}
+
+void decode (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+             std::span<float> r, std::span<float> g, std::span<float> b) noexcept
+{
+    ColourConversion::srgbToLinear (red, r);
+    ColourConversion::srgbToLinear (green, g);
+    ColourConversion::srgbToLinear (blue, b);
+}
+
+//==============================================================================
+class HSLModel  : public ColourModel
+{
+public:
+    juce::String getName() const override           { return "HSL"; }
+    juce::String getChannelName (int c) const override { return c == 0 ? "H" : (c == 1 ? "S" : "L"); }
+    int getHueChannel() const noexcept override     { return 0; }
+    int getLightnessChannel() const noexcept override { return 2; }
+
+    void toRGB (std::span<const float> h, std::span<const float> s, std::span<const float> l,
+                std::span<float> red, std::span<float> green, std::span<float> blue) const noexcept override
+    {
+        // convert to HSB in the output arrays, then let the HSB kernel finish in place
+        for (size_t i = 0; i < h.size(); ++i)
+        {
+            auto v = l[i] + s[i] * juce::jmin (l[i], 1.0f - l[i]);
+
+            red[i]   = h[i];
+            green[i] = v > 0.0f ? 2.0f * (1.0f - l[i] / v) : 0.0f;
+            blue[i]  = v;
+        }
+
+        ColourConversion::hsbToRgb (red, green, blue, red, green, blue);
+    }
+
+    void fromRGB (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+                  std::span<float> h, std::span<float> s, std::span<float> l) const noexcept override
+    {
+        ColourConversion::rgbToHsb (red, green, blue, h, s, l);
+
+        for (size_t i = 0; i < h.size(); ++i)
+        {
+            auto v = l[i];
+            auto light = v * (1.0f - s[i] * 0.5f);
+            auto range = juce::jmin (light, 1.0f - light);
+
+            s[i] = range > 0.0f ? (v - light) / range : 0.0f;
+            l[i] = light;
+        }
+    }
+};
+
+//==============================================================================
+/** The OKLab matrices, from https://bottosson.github.io/posts/oklab/ */
+struct OKLab
+{
+    static constexpr float abRange = 0.4f;
+
+    static void toLinear (float L, float a, float b, float& red, float& green, float& blue) noexcept
+    {
+        auto l = L + 0.3963377774f * a + 0.2158037573f * b;
+        auto m = L - 0.1055613458f * a - 0.0638541728f * b;
+        auto s = L - 0.0894841775f * a - 1.2914855480f * b;
+
+        l = l * l * l;
+        m = m * m * m;
+        s = s * s * s;
+
+        red   =  4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s;
+        green = -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s;
+        blue  = -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s;
+    }
+
+    static void fromLinear (float red, float green, float blue, float& L, float& a, float& b) noexcept
+    {
+        auto l = fastCbrt (0.4122214708f * red + 0.5363325363f * green + 0.0514459929f * blue);
+        auto m = fastCbrt (0.2119034982f * red + 0.6806995451f * green + 0.1073969566f * blue);
+        auto s = fastCbrt (0.0883024619f * red + 0.2817188376f * green + 0.6299787005f * blue);
+
+        L = 0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s;
+        a = 1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s;
+        b = 0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s;
+    }
+};
+
+class OKLabModel  : public ColourModel
+{
+public:
+    juce::String getName() const override           { return "OKLab"; }
+    juce::String getChannelName (int c) const override { return c == 0 ? "L" : (c == 1 ? "a" : "b"); }
+
+    void toRGB (std::span<const float> L, std::span<const float> a, std::span<const float> b,
+                std::span<float> red, std::span<float> green, std::span<float> blue) const noexcept override
+    {
+        for (size_t i = 0; i < L.size(); ++i)
+            OKLab::toLinear (L[i], (a[i] - 0.5f) * (2.0f * OKLab::abRange), (b[i] - 0.5f) * (2.0f * OKLab::abRange),
+                             red[i], green[i], blue[i]);
+
+        encode (red, green, blue);
+    }
+
+    void fromRGB (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+                  std::span<float> L, std::span<float> a, std::span<float> b) const noexcept override
+    {
+        decode (red, green, blue, L, a, b);
+
+        for (size_t i = 0; i < L.size(); ++i)
+        {
+            OKLab::fromLinear (L[i], a[i], b[i], L[i], a[i], b[i]);
+
+            a[i] = a[i] / (2.0f * OKLab::abRange) + 0.5f;
+            b[i] = b[i] / (2.0f * OKLab::abRange) + 0.5f;
+        }
+    }
+};
+
+class OKLCHModel  : public ColourModel
+{
+public:
+    static constexpr float maxChroma = 0.4f;
+
+    juce::String getName() const override           { return "OKLCH"; }
+    juce::String getChannelName (int c) const override { return c == 0 ? "L" : (c == 1 ? "C" : "H"); }
+    int getHueChannel() const noexcept override     { return 2; }
+
+    void toRGB (std::span<const float> L, std::span<const float> C, std::span<const float> h,
+                std::span<float> red, std::span<float> green, std::span<float> blue) const noexcept override
+    {
+        auto& table = getSinCosTable();
+
+        for (size_t i = 0; i < L.size(); ++i)
+        {
+            float c, s;
+            table.get (h[i], c, s);
+
+            auto chroma = C[i] * maxChroma;
+            OKLab::toLinear (L[i], chroma * c, chroma * s, red[i], green[i], blue[i]);
+        }
+
+        encode (red, green, blue);
+    }
+
+    void fromRGB (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+                  std::span<float> L, std::span<float> C, std::span<float> h) const noexcept override
+    {
+        decode (red, green, blue, L, C, h);
+
+        for (size_t i = 0; i < L.size(); ++i)
+        {
+            float a, b;
+            OKLab::fromLinear (L[i], C[i], h[i], L[i], a, b);
+
+            auto chroma = std::sqrt (a * a + b * b);
+            auto turns = std::atan2 (b, a) / juce::MathConstants<float>::twoPi;
+
+            C[i] = chroma / maxChroma;
+            h[i] = turns < 0.0f ? turns + 1.0f : turns;
+        }
+    }
+};
+
+//==============================================================================
+/** CIE L*a*b* relative to D65, through XYZ with the sRGB primaries. */
+class CIELabModel  : public ColourModel
+{
+public:
+    juce::String getName() const override           { return "CIELab"; }
+    juce::String getChannelName (int c) const override { return c == 0 ? "L*" : (c == 1 ? "a*" : "b*"); }
+
+    void toRGB (std::span<const float> L, std::span<const float> a, std::span<const float> b,
+                std::span<float> red, std::span<float> green, std::span<float> blue) const noexcept override
+    {
+        for (size_t i = 0; i < L.size(); ++i)
+        {
+            auto fy = (L[i] * 100.0f + 16.0f) / 116.0f;
+            auto fx = fy + (a[i] * 255.0f - 128.0f) / 500.0f;
+            auto fz = fy - (b[i] * 255.0f - 128.0f) / 200.0f;
+
+            auto x = finv (fx) * whiteX;
+            auto y = finv (fy);
+            auto z = finv (fz) * whiteZ;
+
+            red[i]   =  3.2404542f * x - 1.5371385f * y - 0.4985314f * z;
+            green[i] = -0.9692660f * x + 1.8760108f * y + 0.0415560f * z;
+            blue[i]  =  0.0556434f * x - 0.2040259f * y + 1.0572252f * z;
+        }
+
+        encode (red, green, blue);
+    }
+
+    void fromRGB (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+                  std::span<float> L, std::span<float> a, std::span<float> b) const noexcept override
+    {
+        decode (red, green, blue, L, a, b);
+
+        for (size_t i = 0; i < L.size(); ++i)
+        {
+            auto r = L[i], g = a[i], bl = b[i];
+
+            auto fx = f ((0.4124564f * r + 0.3575761f * g + 0.1804375f * bl) / whiteX);
+            auto fy = f  (0.2126729f * r + 0.7151522f * g + 0.0721750f * bl);
+            auto fz = f ((0.0193339f * r + 0.1191920f * g + 0.9503041f * bl) / whiteZ);
+
+            L[i] = (116.0f * fy - 16.0f) / 100.0f;
+            a[i] = (500.0f * (fx - fy) + 128.0f) / 255.0f;
+            b[i] = (200.0f * (fy - fz) + 128.0f) / 255.0f;
+        }
+    }
+
+private:
+    static constexpr float whiteX = 0.95047f;
+    static constexpr float whiteZ = 1.08883f;
+    static constexpr float delta = 6.0f / 29.0f;
+
+    static float f (float t) noexcept
+    {
+        return t > delta * delta * delta ? fastCbrt (t) : t / (3.0f * delta * delta) + 4.0f / 29.0f;
+    }
+
+    static float finv (float t) noexcept
+    {
+        return t > delta ? t * t * t : 3.0f * delta * delta * (t - 4.0f / 29.0f);
+    }
+};
+
+} // namespace
+
+//==============================================================================
+ColourModel::Values ColourModel::fromColour (const DeepColour& colour) const noexcept
+{
+    auto rgb = colour.getRGB();
+    Values values;
+
+    fromRGB ({ &rgb.r, 1 }, { &rgb.g, 1 }, { &rgb.b, 1 }, { &values[0], 1 }, { &values[1], 1 }, { &values[2], 1 });
+    return values;
+}
+
+DeepColour ColourModel::toColour (const Values& values, float alpha) const noexcept
+{
+    float r, g, b;
+    toRGB ({ &values[0], 1 }, { &values[1], 1 }, { &values[2], 1 }, { &r, 1 }, { &g, 1 }, { &b, 1 });
+
+    return DeepColour::fromRGBA (juce::jlimit (0.0f, 1.0f, r),
+                                 juce::jlimit (0.0f, 1.0f, g),
+                                 juce::jlimit (0.0f, 1.0f, b),
+                                 alpha);
+}
+
+bool ColourModel::isInGamut (const Values& values) const noexcept
+{
+    float rgb[3];
+    toRGB ({ &values[0], 1 }, { &values[1], 1 }, { &values[2], 1 }, { &rgb[0], 1 }, { &rgb[1], 1 }, { &rgb[2], 1 });
+
+    return std::all_of (std::begin (rgb), std::end (rgb), [] (float c) { return c >= -1.0e-4f && c <= 1.0f + 1.0e-4f; });
+}
+
+juce::uint64 ColourModel::createInstanceId() noexcept
+{
+    static std::atomic<juce::uint64> nextId { 1 };
+    return nextId.fetch_add (1, std::memory_order_relaxed);
+}
+
+//==============================================================================
+const ColourModel& ColourModel::getHSL()
+{
+    static const HSLModel model;
+    return model;
+}
+
+const ColourModel& ColourModel::getOKLab()
+{
+    static const OKLabModel model;
+    return model;
+}
+
+const ColourModel& ColourModel::getOKLCH()
+{
+    static const OKLCHModel model;
+    return model;
+}
+
+const ColourModel& ColourModel::getCIELab()
+{
+    static const CIELabModel model;
+    return model;
+}
+
+} // namespace reFX
@@ -0,0 +1,109 @@
+#pragma once
+
+namespace reFX
+{
+
+//==============================================================================
+/**
+    A colour space with three channels that ColourSelector can show as a plane
+    and a strip.
+
+    Every channel is normalised to the range 0.0 to 1.0, whatever its natural
+    units are, so the views can map channels to screen positions the same way
+    for every model. getChannelName() describes what a channel means.
+
+    Conversions work on whole arrays at once, like the kernels in
+    ColourConversion, because that is how planes are rendered. The RGB values on
+    the other side are gamma-encoded sRGB. Models whose gamut is larger than
+    sRGB produce RGB values outside 0.0 to 1.0 for colours that sRGB can't show;
+    they are left unclipped, so that the caller can mask them.
+
+    The built-in models are stateless singletons that live for the whole
+    program, so they can be shared freely between selectors and threads.
+
+    @tags{Graphics}
+*/
+class ColourModel
+{
+public:
+    //==============================================================================
+    virtual ~ColourModel() = default;
+
+    /** Returns the name of the model, for example "OKLCH". */
+    virtual juce::String getName() const = 0;
+
+    /** Returns a short name for one of the three channels, for example "L". */
+    virtual juce::String getChannelName (int channel) const = 0;
+
+    /** Returns the index of the channel that is an angle and wraps around, or -1. */
+    virtual int getHueChannel() const noexcept          { return -1; }
+
+    /** Returns the index of the channel that goes from dark to light. ColourSelector
+        puts it on the vertical axis of a plane whenever it isn't on the strip.
+    */
+    virtual int getLightnessChannel() const noexcept    { return 0; }
+
+    /** Converts normalised channel values of this model to sRGB.
+
+        All spans passed to a single call must have the same size.
+    */
+    virtual void toRGB (std::span<const float> c0, std::span<const float> c1, std::span<const float> c2,
+                        std::span<float> red, std::span<float> green, std::span<float> blue) const noexcept = 0;
+
+    /** Converts sRGB values to normalised channel values of this model.
+
+        All spans passed to a single call must have the same size.
+    */
+    virtual void fromRGB (std::span<const float> red, std::span<const float> green, std::span<const float> blue,
+                          std::span<float> c0, std::span<float> c1, std::span<float> c2) const noexcept = 0;
+
+    //==============================================================================
+    using Values = std::array<float, 3>;
+
+    /** Returns the normalised channel values of a colour in this model. */
+    Values fromColour (const DeepColour& colour) const noexcept;
+
+    /** Returns the colour for some channel values, clipped to sRGB. */
+    DeepColour toColour (const Values& values, float alpha) const noexcept;
+
+    /** Returns true if some channel values describe a colour that sRGB can show. */
+    bool isInGamut (const Values& values) const noexcept;
+
+    /** Returns a number that identifies this model object. It's never given to another
+        model, not even after this one is deleted, so ColourPlane::Cache uses it rather
+        than the address to tell the planes of different models apart.
+    */
+    juce::uint64 getInstanceId() const noexcept             { return instanceId; }
+
+    //==============================================================================
+    /** Hue, saturation and lightness, channels in that order. */
+    static const ColourModel& getHSL();
+
+    /** Bjorn Ottosson's perceptual OKLab: lightness, then the green-red and blue-yellow
+        axes, which are mapped from -0.4 to 0.4 onto 0.0 to 1.0.
+    */
+    static const ColourModel& getOKLab();
+
+    /** The polar form of OKLab: lightness, chroma from 0.0 to 0.4, and hue. */
+    static const ColourModel& getOKLCH();
+
+    /** CIE L*a*b* with a D65 white point: L* from 0 to 100, and a* and b* from
+        -128 to 127, each mapped onto 0.0 to 1.0.
+    */
+    static const ColourModel& getCIELab();
+
+protected:
+    //==============================================================================
+    ColourModel() = default;
+
+    // a copy is a different model, so it keeps its own id
+    ColourModel (const ColourModel&) noexcept {}
+    ColourModel& operator= (const ColourModel&) noexcept    { return *this; }
+
+private:
+    static juce::uint64 createInstanceId() noexcept;
+
+    juce::uint64 instanceId = createInstanceId();
+};
+
+} // namespace reFX
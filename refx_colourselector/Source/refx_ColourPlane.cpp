@@ -0,0 +1,861 @@
+namespace reFX
+{
+
+namespace ColourPlane
+{
+
+namespace
+{
+
+using Params = ColourSelector::Params;
+
+bool isHSB (Params p)
+{
+    return p == Params::hue || p == Params::saturation || p == Params::brightness;
+}
+
+int getChannelIndex (Params p)
+{
+    return isHSB (p) ? int (p) : int (p) - int (Params::red);
+}
+
+//==============================================================================
+constexpr juce::uint32 toOpaqueARGB (RGB c) noexcept
+{
+    auto to8Bit = [] (float v) { return juce::uint32 ((v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v)) * 255.0f + 0.5f); };
+
+    return 0xff000000u | (to8Bit (c.r) << 16) | (to8Bit (c.g) << 8) | to8Bit (c.b);
+}
+
+/** Fully saturated, fully bright hues, baked in at compile time. Six sectors of 256
+    steps cover every distinct 8-bit pure hue.
+*/
+constexpr size_t hueLUTSize = 6 * 256;
+
+constexpr auto hueLUT = []
+{
+    std::array<juce::uint32, hueLUTSize> lut {};
+
+    for (size_t i = 0; i < hueLUTSize; ++i)
+        lut[i] = toOpaqueARGB (hsbToRgb ({ float (i) / float (hueLUTSize), 1.0f, 1.0f }));
+
+    return lut;
+}();
+
+static_assert (hueLUT[0] == 0xffff0000);
+static_assert (hueLUT[hueLUTSize / 3] == 0xff00ff00);
+static_assert (hueLUT[hueLUTSize * 2 / 3] == 0xff0000ff);
+
+juce::uint32 lookupHue (float hue) noexcept
+{
+    return hueLUT[size_t (juce::roundToInt (hue * float (hueLUTSize))) % hueLUTSize];
+}
+
+//==============================================================================
+struct RowBuffers
+{
+    explicit RowBuffers (int width)
+        : num (size_t (width)), storage (num * 7)
+    {
+        for (size_t i = 0; i < num; ++i)
+            storage[i] = float (i) / float (num);
+    }
+
+    /** The x value of every column, 0.0 at the left edge. */
+    std::span<float> getX()                 { return get (0); }
+
+    /** Per-column colours that stay the same for every row. */
+    std::span<float> getColumn (int c)      { return get (1 + c); }
+
+    /** Scratch space for the row being generated. */
+    std::span<float> getRow (int c)         { return get (4 + c); }
+
+    std::span<float> get (int index)        { return { storage.get() + num * size_t (index), num }; }
+
+    size_t num;
+    juce::HeapBlock<float> storage;
+};
+
+std::span<juce::uint32> getLine (const juce::Image::BitmapData& dest, int y)
+{
+    return { reinterpret_cast<juce::uint32*> (dest.getLinePointer (y)), size_t (dest.width) };
+}
+
+float getYValue (int y, int height)
+{
+    return 1.0f - (float) y / (float) height;
+}
+
+void writeRow (RowBuffers& buffers, const juce::Image::BitmapData& dest, int y)
+{
+    ColourConversion::rgbToARGB (buffers.getRow (0), buffers.getRow (1), buffers.getRow (2), 1.0f, getLine (dest, y));
+}
+
+void writeModelRow (const ColourModel& model, RowBuffers& buffers, juce::uint32 outOfGamutPixel, std::span<juce::uint32> line)
+{
+    model.toRGB (buffers.getColumn (0), buffers.getColumn (1), buffers.getColumn (2),
+                 buffers.getRow (0), buffers.getRow (1), buffers.getRow (2));
+
+    ColourConversion::rgbToARGB (buffers.getRow (0), buffers.getRow (1), buffers.getRow (2), 1.0f, line, outOfGamutPixel);
+}
+
+// Fills pixels with the colour as one channel runs through their centres, from 0.0
+// at the first pixel towards 1.0 at the last
+void renderRamp (Params param, const DeepColour& colour, std::span<juce::uint32> pixels)
+{
+    auto num = pixels.size();
+    juce::HeapBlock<float> storage (num * 3);
+
+    std::span<float> channels[] = { { storage.get(), num },
+                                    { storage.get() + num, num },
+                                    { storage.get() + num * 2, num } };
+
+    if (isHSB (param))
+    {
+        auto hsb = colour.getHSB();
+        const float values[] = { hsb.h, hsb.s, hsb.b };
+
+        for (int c = 0; c < 3; ++c)
+            std::fill (channels[c].begin(), channels[c].end(), values[c]);
+    }
+    else
+    {
+        auto rgb = colour.getRGB();
+        const float values[] = { rgb.r, rgb.g, rgb.b };
+
+        for (int c = 0; c < 3; ++c)
+            std::fill (channels[c].begin(), channels[c].end(), values[c]);
+    }
+
+    auto ramp = channels[getChannelIndex (param)];
+
+    for (size_t i = 0; i < num; ++i)
+        ramp[i] = ((float) i + 0.5f) / (float) num;
+
+    if (isHSB (param))
+        ColourConversion::hsbToARGB (channels[0], channels[1], channels[2], 1.0f, pixels);
+    else
+        ColourConversion::rgbToARGB (channels[0], channels[1], channels[2], 1.0f, pixels);
+}
+
+//==============================================================================
+// Fixed hue, x = saturation, y = brightness:
+// a bilinear blend of white, black and the pure hue, c = b * (1 - s + s * pure)
+void renderSaturationBrightness (float hue, const juce::Image::BitmapData& dest, int startRow, int endRow)
+{
+    RowBuffers buffers (dest.width);
+
+    auto pure = hsbToRgb ({ hue, 1.0f, 1.0f });
+    const float channelPure[] = { pure.r, pure.g, pure.b };
+
+    auto xs = buffers.getX();
+
+    for (int y = startRow; y < endRow; ++y)
+    {
+        auto bri = getYValue (y, dest.height);
+
+        for (int c = 0; c < 3; ++c)
+        {
+            auto row = buffers.getRow (c);
+            auto slope = bri * (channelPure[c] - 1.0f);
+
+            for (size_t x = 0; x < buffers.num; ++x)
+                row[x] = bri + xs[x] * slope;
+        }
+
+        writeRow (buffers, dest, y);
+    }
+}
+
+// Fixed saturation, x = hue, y = brightness: one hue lookup per column, scaled per row
+void renderHueBrightness (float saturation, const juce::Image::BitmapData& dest, int startRow, int endRow)
+{
+    RowBuffers buffers (dest.width);
+
+    std::fill (buffers.getRow (0).begin(), buffers.getRow (0).end(), saturation);
+    std::fill (buffers.getRow (1).begin(), buffers.getRow (1).end(), 1.0f);
+
+    ColourConversion::hsbToRgb (buffers.getX(), buffers.getRow (0), buffers.getRow (1),
+                                buffers.getColumn (0), buffers.getColumn (1), buffers.getColumn (2));
+
+    for (int y = startRow; y < endRow; ++y)
+    {
+        auto bri = getYValue (y, dest.height);
+
+        for (int c = 0; c < 3; ++c)
+        {
+            auto row = buffers.getRow (c);
+            auto column = buffers.getColumn (c);
+
+            for (size_t x = 0; x < buffers.num; ++x)
+                row[x] = bri * column[x];
+        }
+
+        writeRow (buffers, dest, y);
+    }
+}
+
+// Fixed brightness, x = hue, y = saturation: c = b * (1 - s) + b * s * pure (x)
+void renderHueSaturation (float brightness, const juce::Image::BitmapData& dest, int startRow, int endRow)
+{
+    RowBuffers buffers (dest.width);
+
+    std::fill (buffers.getRow (0).begin(), buffers.getRow (0).end(), 1.0f);
+
+    ColourConversion::hsbToRgb (buffers.getX(), buffers.getRow (0), buffers.getRow (0),
+                                buffers.getColumn (0), buffers.getColumn (1), buffers.getColumn (2));
+
+    for (int y = startRow; y < endRow; ++y)
+    {
+        auto sat = getYValue (y, dest.height);
+        auto offset = brightness * (1.0f - sat);
+        auto scale = brightness * sat;
+
+        for (int c = 0; c < 3; ++c)
+        {
+            auto row = buffers.getRow (c);
+            auto column = buffers.getColumn (c);
+
+            for (size_t x = 0; x < buffers.num; ++x)
+                row[x] = offset + scale * column[x];
+        }
+
+        writeRow (buffers, dest, y);
+    }
+}
+
+// Any two RGB channels: the x channel is a ramp, the other two are constant per row
+void renderRGB (int xChannel, int yChannel, RGB fixed, const juce::Image::BitmapData& dest, int startRow, int endRow)
+{
+    RowBuffers buffers (dest.width);
+
+    const float values[] = { fixed.r, fixed.g, fixed.b };
+
+    for (int c = 0; c < 3; ++c)
+    {
+        auto row = buffers.getRow (c);
+
+        if (c == xChannel)
+            std::copy (buffers.getX().begin(), buffers.getX().end(), row.begin());
+        else
+            std::fill (row.begin(), row.end(), values[c]);
+    }
+
+    auto yRow = buffers.getRow (yChannel);
+
+    for (int y = startRow; y < endRow; ++y)
+    {
+        std::fill (yRow.begin(), yRow.end(), getYValue (y, dest.height));
+        writeRow (buffers, dest, y);
+    }
+}
+
+// Any other pair of HSB channels: fill the HSB rows and convert them in one batch
+void renderHSB (int xChannel, int yChannel, HSB fixed, const juce::Image::BitmapData& dest, int startRow, int endRow)
+{
+    RowBuffers buffers (dest.width);
+
+    const float values[] = { fixed.h, fixed.s, fixed.b };
+
+    for (int c = 0; c < 3; ++c)
+    {
+        auto column = buffers.getColumn (c);
+
+        if (c == xChannel)
+            std::copy (buffers.getX().begin(), buffers.getX().end(), column.begin());
+        else
+            std::fill (column.begin(), column.end(), values[c]);
+    }
+
+    auto yColumn = buffers.getColumn (yChannel);
+
+    for (int y = startRow; y < endRow; ++y)
+    {
+        std::fill (yColumn.begin(), yColumn.end(), getYValue (y, dest.height));
+
+        ColourConversion::hsbToARGB (buffers.getColumn (0), buffers.getColumn (1), buffers.getColumn (2),
+                                     1.0f, getLine (dest, y));
+    }
+}
+
+// Mixed HSB and RGB channels have no closed form, so go through DeepColour for each pixel
+void renderGeneric (Params xParam, Params yParam, const DeepColour& colour,
+                    const juce::Image::BitmapData& dest, int startRow, int endRow)
+{
+    RowBuffers buffers (dest.width);
+
+    auto set = [] (DeepColour c, Params param, float val)
+    {
+        if (isHSB (param))
+        {
+            auto hsb = c.getHSB();
+            float* values[] = { &hsb.h, &hsb.s, &hsb.b };
+            *values[getChannelIndex (param)] = val;
+            return DeepColour (hsb);
+        }
+
+        auto rgb = c.getRGB();
+        float* values[] = { &rgb.r, &rgb.g, &rgb.b };
+        *values[getChannelIndex (param)] = val;
+        return DeepColour (rgb);
+    };
+
+    for (int y = startRow; y < endRow; ++y)
+    {
+        auto yVal = getYValue (y, dest.height);
+
+        for (size_t x = 0; x < buffers.num; ++x)
+        {
+            auto rgb = set (set (colour, xParam, buffers.getX()[x]), yParam, yVal).getRGB();
+
+            buffers.getRow (0)[x] = rgb.r;
+            buffers.getRow (1)[x] = rgb.g;
+            buffers.getRow (2)[x] = rgb.b;
+        }
+
+        writeRow (buffers, dest, y);
+    }
+}
+
+} // namespace
+
+//==============================================================================
+void renderRows (Params xParam, Params yParam, const DeepColour& colour,
+                 const juce::Image::BitmapData& dest, int startRow, int endRow)
+{
+    jassert (dest.pixelFormat == juce::Image::ARGB);
+    jassert (xParam != yParam);
+
+    startRow = juce::jmax (0, startRow);
+    endRow = juce::jmin (dest.height, endRow);
+
+    if (dest.width <= 0 || startRow >= endRow)
+        return;
+
+    if (isHSB (xParam) && isHSB (yParam))
+    {
+        auto hsb = colour.getHSB();
+
+        if (xParam == Params::saturation && yParam == Params::brightness)
+            renderSaturationBrightness (hsb.h, dest, startRow, endRow);
+        else if (xParam == Params::hue && yParam == Params::brightness)
+            renderHueBrightness (hsb.s, dest, startRow, endRow);
+        else if (xParam == Params::hue && yParam == Params::saturation)
+            renderHueSaturation (hsb.b, dest, startRow, endRow);
+        else
+            renderHSB (getChannelIndex (xParam), getChannelIndex (yParam), hsb, dest, startRow, endRow);
+    }
+    else if (! isHSB (xParam) && ! isHSB (yParam))
+    {
+        renderRGB (getChannelIndex (xParam), getChannelIndex (yParam), colour.getRGB(), dest, startRow, endRow);
+    }
+    else
+    {
+        renderGeneric (xParam, yParam, colour, dest, startRow, endRow);
+    }
+}
+
+juce::Image render (Params xParam, Params yParam, const DeepColour& colour, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return {};
+
+    juce::Image image (juce::Image::ARGB, width, height, false);
+
+    juce::Image::BitmapData pixels (image, juce::Image::BitmapData::writeOnly);
+    renderRows (xParam, yParam, colour, pixels, 0, height);
+
+    return image;
+}
+
+//==============================================================================
+void renderStrip (Params param, const DeepColour& colour, const juce::Image::BitmapData& dest)
+{
+    jassert (dest.pixelFormat == juce::Image::ARGB);
+
+    if (dest.width <= 0 || dest.height <= 0)
+        return;
+
+    auto fillRows = [&dest] (auto getPixel)
+    {
+        for (int y = 0; y < dest.height; ++y)
+        {
+            auto line = getLine (dest, y);
+            std::fill (line.begin(), line.end(), getPixel (y));
+        }
+    };
+
+    auto getValue = [&dest] (int y) { return 1.0f - ((float) y + 0.5f) / (float) dest.height; };
+
+    if (param == Params::hue)
+    {
+        fillRows ([&] (int y) { return lookupHue (getValue (y)); });
+        return;
+    }
+
+    // the ramp runs upwards, so the strip takes it from the bottom row
+    auto num = size_t (dest.height);
+    juce::HeapBlock<juce::uint32> pixels (num);
+    std::span<juce::uint32> column (pixels.get(), num);
+
+    renderRamp (param, colour, column);
+
+    fillRows ([&] (int y) { return column[num - 1 - size_t (y)]; });
+}
+
+juce::Image renderStrip (Params param, const DeepColour& colour, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return {};
+
+    juce::Image image (juce::Image::ARGB, width, height, false);
+
+    juce::Image::BitmapData pixels (image, juce::Image::BitmapData::writeOnly);
+    renderStrip (param, colour, pixels);
+
+    return image;
+}
+
+//==============================================================================
+void renderTrack (Params param, const DeepColour& colour, const juce::Image::BitmapData& dest)
+{
+    jassert (dest.pixelFormat == juce::Image::ARGB);
+
+    if (dest.width <= 0 || dest.height <= 0)
+        return;
+
+    auto first = getLine (dest, 0);
+    renderRamp (param, colour, first);
+
+    for (int y = 1; y < dest.height; ++y)
+        std::copy (first.begin(), first.end(), getLine (dest, y).begin());
+}
+
+void renderAlphaTrack (const DeepColour& colour, int checkSize, juce::Colour lightCheck, juce::Colour darkCheck,
+                       const juce::Image::BitmapData& dest)
+{
+    jassert (dest.pixelFormat == juce::Image::ARGB);
+
+    if (dest.width <= 0 || dest.height <= 0)
+        return;
+
+    checkSize = juce::jmax (1, checkSize);
+
+    // Every row is one of two lines, which differ only in which check comes first,
+    // so both are blended once and then copied down the track.
+    auto num = size_t (dest.width);
+    juce::HeapBlock<float> storage (num * 3);
+    juce::HeapBlock<juce::uint32> lines (num * 2);
+
+    std::span<float> red   (storage.get(), num);
+    std::span<float> green (storage.get() + num, num);
+    std::span<float> blue  (storage.get() + num * 2, num);
+
+    auto rgb = colour.getRGB();
+    const RGB checks[] = { { lightCheck.getFloatRed(), lightCheck.getFloatGreen(), lightCheck.getFloatBlue() },
+                           { darkCheck.getFloatRed(),  darkCheck.getFloatGreen(),  darkCheck.getFloatBlue() } };
+
+    for (size_t phase = 0; phase < 2; ++phase)
+    {
+        for (size_t x = 0; x < num; ++x)
+        {
+            auto alpha = ((float) x + 0.5f) / (float) num;
+            auto& check = checks[(x / size_t (checkSize) + phase) % 2];
+
+            red[x]   = check.r + (rgb.r - check.r) * alpha;
+            green[x] = check.g + (rgb.g - check.g) * alpha;
+            blue[x]  = check.b + (rgb.b - check.b) * alpha;
+        }
+
+        ColourConversion::rgbToARGB (red, green, blue, 1.0f, { lines.get() + num * phase, num });
+    }
+
+    for (int y = 0; y < dest.height; ++y)
+    {
+        auto line = lines.get() + num * size_t ((y / checkSize) % 2);
+        std::copy (line, line + num, getLine (dest, y).begin());
+    }
+}
+
+//==============================================================================
+void renderRows (const ColourModel& model, int xChannel, int yChannel, const ColourModel::Values& values,
+                 juce::uint32 outOfGamutPixel, const juce::Image::BitmapData& dest, int startRow, int endRow)
+{
+    jassert (dest.pixelFormat == juce::Image::ARGB);
+    jassert (xChannel != yChannel && juce::isPositiveAndBelow (xChannel, 3) && juce::isPositiveAndBelow (yChannel, 3));
+
+    startRow = juce::jmax (0, startRow);
+    endRow = juce::jmin (dest.height, endRow);
+
+    if (dest.width <= 0 || startRow >= endRow)
+        return;
+
+    RowBuffers buffers (dest.width);
+
+    // the model's channels are gathered in the column buffers: x varies along the
+    // row, y is filled in for each row, and the third channel never changes
+    auto fixed = buffers.getColumn (3 - xChannel - yChannel);
+    std::fill (fixed.begin(), fixed.end(), values[size_t (3 - xChannel - yChannel)]);
+    std::copy (buffers.getX().begin(), buffers.getX().end(), buffers.getColumn (xChannel).begin());
+
+    for (int y = startRow; y < endRow; ++y)
+    {
+        auto column = buffers.getColumn (yChannel);
+        std::fill (column.begin(), column.end(), getYValue (y, dest.height));
+
+        writeModelRow (model, buffers, outOfGamutPixel, getLine (dest, y));
+    }
+}
+
+juce::Image render (const ColourModel& model, int xChannel, int yChannel, const ColourModel::Values& values,
+                    juce::uint32 outOfGamutPixel, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return {};
+
+    juce::Image image (juce::Image::ARGB, width, height, false);
+
+    juce::Image::BitmapData pixels (image, juce::Image::BitmapData::writeOnly);
+    renderRows (model, xChannel, yChannel, values, outOfGamutPixel, pixels, 0, height);
+
+    return image;
+}
+
+void renderStrip (const ColourModel& model, int channel, const ColourModel::Values& values,
+                  juce::uint32 outOfGamutPixel, const juce::Image::BitmapData& dest)
+{
+    jassert (dest.pixelFormat == juce::Image::ARGB);
+    jassert (juce::isPositiveAndBelow (channel, 3));
+
+    if (dest.width <= 0 || dest.height <= 0)
+        return;
+
+    // the strip is one column wide in the buffers, then repeated across each row
+    RowBuffers buffers (dest.height);
+    juce::HeapBlock<juce::uint32> column ((size_t) dest.height);
+
+    for (int c = 0; c < 3; ++c)
+    {
+        auto channelValues = buffers.getColumn (c);
+
+        if (c == channel)
+        {
+            for (size_t y = 0; y < buffers.num; ++y)
+                channelValues[y] = 1.0f - ((float) y + 0.5f) / (float) dest.height;
+        }
+        else
+        {
+            std::fill (channelValues.begin(), channelValues.end(), values[size_t (c)]);
+        }
+    }
+
+    writeModelRow (model, buffers, outOfGamutPixel, { column.get(), buffers.num });
+
+    for (int y = 0; y < dest.height; ++y)
+    {
+        auto line = getLine (dest, y);
+        std::fill (line.begin(), line.end(), column[y]);
+    }
+}
+
+juce::Image renderStrip (const ColourModel& model, int channel, const ColourModel::Values& values,
+                         juce::uint32 outOfGamutPixel, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return {};
+
+    juce::Image image (juce::Image::ARGB, width, height, false);
+
+    juce::Image::BitmapData pixels (image, juce::Image::BitmapData::writeOnly);
+    renderStrip (model, channel, values, outOfGamutPixel, pixels);
+
+    return image;
+}
+
+//==============================================================================
+struct AsyncRenderer::Pool
+{
+    juce::ThreadPool threads { juce::ThreadPoolOptions {}
+                                   .withThreadName ("Colour plane")
+                                   .withNumberOfThreads (juce::jmax (1, juce::SystemStats::getNumCpus() - 1)) };
+};
+
+/** The state shared between a renderer and the pool threads working on one plane.
+    The threads hold on to it, so an abandoned job stays valid until the last of
+    them has noticed that it was cancelled.
+*/
+struct AsyncRenderer::Job
+{
+    Job (AsyncRenderer& r, RowRenderer rowRenderer, int width, int height)
+        : renderer (&r), renderRows (std::move (rowRenderer)),
+          image (juce::Image::ARGB, width, height, false, juce::SoftwareImageType()),
+          pixels (std::make_unique<juce::Image::BitmapData> (image, juce::Image::BitmapData::writeOnly)),
+          numTiles ((height + rowsPerTile - 1) / rowsPerTile)
+    {
+    }
+
+    /** Renders tiles until there are none left or the job is cancelled. */
+    void run()
+    {
+        while (! cancelled)
+        {
+            auto tile = nextTile++;
+
+            if (tile >= numTiles)
+                return;
+
+            auto startRow = tile * rowsPerTile;
+            renderRows (*pixels, startRow, juce::jmin (pixels->height, startRow + rowsPerTile));
+
+            if (++tilesDone == numTiles)
+            {
+                {
+                    const std::scoped_lock sl (lock);
+
+                    if (renderer != nullptr)
+                        renderer->triggerAsyncUpdate();
+                }
+
+                finished.signal();
+            }
+        }
+    }
+
+    void cancel()
+    {
+        cancelled = true;
+
+        const std::scoped_lock sl (lock);
+        renderer = nullptr;
+    }
+
+    bool isComplete() const noexcept    { return tilesDone == numTiles && ! cancelled; }
+
+    std::mutex lock;
+    AsyncRenderer* renderer;
+    const RowRenderer renderRows;
+
+    juce::Image image;
+    std::unique_ptr<juce::Image::BitmapData> pixels;
+
+    const int numTiles;
+    std::atomic<int> nextTile { 0 }, tilesDone { 0 };
+    std::atomic<bool> cancelled { false };
+    juce::WaitableEvent finished { true };
+};
+
+AsyncRenderer::AsyncRenderer() = default;
+
+AsyncRenderer::~AsyncRenderer()
+{
+    cancel();
+}
+
+void AsyncRenderer::render (RowRenderer renderRows, int width, int height)
+{
+    cancel();
+
+    if (width <= 0 || height <= 0)
+        return;
+
+    job = std::make_shared<Job> (*this, std::move (renderRows), width, height);
+
+    auto numWorkers = juce::jmin (job->numTiles, pool->threads.getNumThreads());
+
+    for (int i = 0; i < numWorkers; ++i)
+        pool->threads.addJob ([j = job] { j->run(); });
+}
+
+void AsyncRenderer::render (Params xParam, Params yParam, const DeepColour& colour, int width, int height)
+{
+    // every worker reads the captured values at once, so they're captured as plain
+    // HSB and RGB values rather than relying on how DeepColour stores them
+    render ([=, hsb = colour.getHSB(), rgb = colour.getRGB(), alpha = colour.getAlpha()]
+            (const juce::Image::BitmapData& dest, int startRow, int endRow)
+            {
+                ColourPlane::renderRows (xParam, yParam, DeepColour (hsb, rgb, alpha), dest, startRow, endRow);
+            },
+            width, height);
+}
+
+void AsyncRenderer::cancel()
+{
+    if (job != nullptr)
+    {
+        job->cancel();
+        job = nullptr;
+    }
+
+    cancelPendingUpdate();
+}
+
+void AsyncRenderer::clear()
+{
+    cancel();
+    image = {};
+}
+
+void AsyncRenderer::finishRendering()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (job == nullptr)
+        return;
+
+    job->finished.wait();
+
+    cancelPendingUpdate();
+    handleAsyncUpdate();
+}
+
+void AsyncRenderer::handleAsyncUpdate()
+{
+    if (job == nullptr || ! job->isComplete())
+        return;
+
+    job->pixels = nullptr;
+    image = job->image;
+    job = nullptr;
+
+    if (onImageReady != nullptr)
+        onImageReady();
+}
+
+//==============================================================================
+JUCE_IMPLEMENT_SINGLETON (Cache)
+
+std::atomic<size_t> Cache::maximumSize { 32 * 1024 * 1024 };
+
+Cache::~Cache()
+{
+    clearSingletonInstance();
+}
+
+namespace
+{
+
+/** The bits that a Key's value is compared and hashed by. -0.0 and 0.0 compare equal
+    as floats, and NaN doesn't even equal itself, so both are folded into one pattern
+    each; otherwise equal keys could hash differently, and a NaN key could never be found.
+*/
+juce::uint32 getCanonicalBits (float value) noexcept
+{
+    if (value == 0.0f)
+        return 0;
+
+    if (std::isnan (value))
+        return 0x7fc00000;
+
+    return std::bit_cast<juce::uint32> (value);
+}
+
+} // namespace
+
+bool Cache::Key::operator== (const Key& other) const noexcept
+{
+    return modelId == other.modelId
+        && xChannel == other.xChannel
+        && yChannel == other.yChannel
+        && std::equal (values.begin(), values.end(), other.values.begin(),
+                       [] (float a, float b) { return getCanonicalBits (a) == getCanonicalBits (b); })
+        && outOfGamutPixel == other.outOfGamutPixel
+        && width == other.width
+        && height == other.height;
+}
+
+size_t Cache::KeyHash::operator() (const Key& key) const noexcept
+{
+    auto hash = std::hash<juce::uint64>() (key.modelId);
+
+    auto combine = [&hash] (size_t value)
+    {
+        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+
+    combine (size_t (key.xChannel + 1));
+    combine (size_t (key.yChannel + 1));
+
+    for (auto value : key.values)
+        combine (getCanonicalBits (value));
+
+    combine (key.outOfGamutPixel);
+    combine (size_t (key.width));
+    combine (size_t (key.height));
+
+    return hash;
+}
+
+juce::Image Cache::find (const Key& key)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    auto it = index.find (key);
+
+    if (it == index.end())
+        return {};
+
+    entries.splice (entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+void Cache::add (const Key& key, const juce::Image& image)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    auto limit = getMaximumSize();
+    auto size = getSizeOf (image);
+
+    if (image.isNull() || size > limit)
+        return;
+
+    if (auto it = index.find (key); it != index.end())
+    {
+        totalSize -= getSizeOf (it->second->second);
+        entries.erase (it->second);
+        index.erase (it);
+    }
+
+    trim (limit - size);
+
+    entries.emplace_front (key, image);
+    index.emplace (key, entries.begin());
+    totalSize += size;
+}
+
+void Cache::clear()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    trim (0);
+}
+
+void Cache::setMaximumSize (size_t numBytes) noexcept
+{
+    maximumSize.store (numBytes, std::memory_order_relaxed);
+}
+
+size_t Cache::getMaximumSize() noexcept
+{
+    return maximumSize.load (std::memory_order_relaxed);
+}
+
+size_t Cache::getSizeOf (const juce::Image& image) noexcept
+{
+    return size_t (image.getWidth()) * size_t (image.getHeight()) * sizeof (juce::PixelARGB);
+}
+
+void Cache::trim (size_t limit)
+{
+    while (totalSize > limit && ! entries.empty())
+    {
+        auto& oldest = entries.back();
+
+        totalSize -= getSizeOf (oldest.second);
+        index.erase (oldest.first);
+        entries.pop_back();
+    }
+}
+
+} // namespace ColourPlane
+
+} // namespace reFX
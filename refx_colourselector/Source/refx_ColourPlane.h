@@ -0,0 +1,249 @@
+#pragma once
+
+namespace reFX
+{
+
+//==============================================================================
+/**
+    Renders the two-dimensional colour planes shown by ColourSelector.
+
+    A plane shows every combination of two channels, with the remaining channels
+    taken from a reference colour. The x channel runs from 0.0 at the left edge
+    towards 1.0 at the right, and the y channel from 1.0 at the top towards 0.0
+    at the bottom.
+
+    The six layouts that ColourSelector uses have closed forms and are generated
+    a row at a time with the batch kernels in ColourConversion. Other channel
+    pairs fall back to a per-pixel conversion. Planes of a ColourModel go through
+    the model's batch conversion a row at a time.
+
+    @tags{Graphics}
+*/
+namespace ColourPlane
+{
+    /** Fills the rows startRow to endRow (exclusive) of a plane.
+
+        The destination must be an ARGB bitmap; its full width and height are
+        treated as the extent of the plane, so a large plane can be rendered in
+        several calls over different row ranges.
+    */
+    void renderRows (ColourSelector::Params xParam, ColourSelector::Params yParam,
+                     const DeepColour& colour, const juce::Image::BitmapData& dest,
+                     int startRow, int endRow);
+
+    /** Renders a whole plane into a new opaque ARGB image. */
+    juce::Image render (ColourSelector::Params xParam, ColourSelector::Params yParam,
+                        const DeepColour& colour, int width, int height);
+
+    /** Fills a vertical strip in which one channel runs from 1.0 in the top row
+        to 0.0 in the bottom row, sampled at the centre of each row.
+
+        The other channels are taken from the colour, except for the hue strip,
+        which is always drawn fully saturated and at full brightness. The
+        destination must be an ARGB bitmap.
+    */
+    void renderStrip (ColourSelector::Params param, const DeepColour& colour,
+                      const juce::Image::BitmapData& dest);
+
+    /** Renders a whole strip into a new opaque ARGB image. */
+    juce::Image renderStrip (ColourSelector::Params param, const DeepColour& colour, int width, int height);
+
+    /** Fills a horizontal track in which one channel runs from 0.0 in the left column
+        to 1.0 in the right one, sampled at the centre of each column.
+
+        Unlike the strips, every channel shows what the colour becomes, so the hue
+        track keeps the colour's saturation and brightness. The destination must be
+        an ARGB bitmap.
+    */
+    void renderTrack (ColourSelector::Params param, const DeepColour& colour,
+                      const juce::Image::BitmapData& dest);
+
+    /** Fills a horizontal track in which the colour's alpha runs from 0.0 in the left
+        column to 1.0 in the right one, composited over a checkerboard of squares of
+        checkSize pixels. The destination must be an ARGB bitmap, and is left opaque.
+    */
+    void renderAlphaTrack (const DeepColour& colour, int checkSize, juce::Colour lightCheck, juce::Colour darkCheck,
+                           const juce::Image::BitmapData& dest);
+
+    //==============================================================================
+    /** Fills the rows startRow to endRow (exclusive) of a plane of a colour model.
+
+        The x and y channels are laid out as for the other planes, the remaining
+        channel is taken from values, and pixels that sRGB can't show are set to
+        outOfGamutPixel, a premultiplied ARGB value.
+    */
+    void renderRows (const ColourModel& model, int xChannel, int yChannel, const ColourModel::Values& values,
+                     juce::uint32 outOfGamutPixel, const juce::Image::BitmapData& dest, int startRow, int endRow);
+
+    /** Renders a whole plane of a colour model into a new ARGB image. */
+    juce::Image render (const ColourModel& model, int xChannel, int yChannel, const ColourModel::Values& values,
+                        juce::uint32 outOfGamutPixel, int width, int height);
+
+    /** Fills a vertical strip of one channel of a colour model, running from 1.0 in
+        the top row to 0.0 in the bottom row, with the other channels taken from values.
+    */
+    void renderStrip (const ColourModel& model, int channel, const ColourModel::Values& values,
+                      juce::uint32 outOfGamutPixel, const juce::Image::BitmapData& dest);
+
+    /** Renders a whole strip of a colour model into a new ARGB image. */
+    juce::Image renderStrip (const ColourModel& model, int channel, const ColourModel::Values& values,
+                             juce::uint32 outOfGamutPixel, int width, int height);
+
+    //==============================================================================
+    /**
+        Renders planes on a shared background thread pool.
+
+        A plane is split into tiles of rowsPerTile rows, and the pool's threads take
+        tiles from the job until none are left, so a plane is filled by all the
+        threads at once. The finished image is handed over on the message thread,
+        and until then getImage() keeps returning the last completed one.
+
+        Requesting a new plane, or calling cancel(), abandons the job in flight:
+        its remaining tiles are skipped and its image is never delivered.
+    */
+    class AsyncRenderer  : private juce::AsyncUpdater
+    {
+    public:
+        AsyncRenderer();
+        ~AsyncRenderer() override;
+
+        /** Fills a range of rows of the destination, like renderRows(). It is called
+            on the pool's threads, so it mustn't refer to anything that may change
+            while the plane is being rendered.
+        */
+        using RowRenderer = std::function<void (const juce::Image::BitmapData&, int startRow, int endRow)>;
+
+        /** Starts rendering a plane, cancelling the one in flight, if any. */
+        void render (RowRenderer renderRows, int width, int height);
+
+        /** Starts rendering one of the HSB or RGB planes. */
+        void render (ColourSelector::Params xParam, ColourSelector::Params yParam,
+                     const DeepColour& colour, int width, int height);
+
+        /** Abandons the plane in flight, if any. */
+        void cancel();
+
+        /** Abandons the plane in flight, if any, and releases the last completed one. */
+        void clear();
+
+        /** Waits for the plane in flight, if any, and hands it over straight away,
+            calling onImageReady before returning rather than on a later message loop
+            iteration. Call it on the message thread.
+        */
+        void finishRendering();
+
+        /** Returns true while a plane is being rendered. */
+        bool isRendering() const noexcept           { return job != nullptr; }
+
+        /** Returns the last completed plane. */
+        const juce::Image& getImage() const noexcept { return image; }
+
+        /** Called on the message thread when a plane has been completed. */
+        std::function<void()> onImageReady;
+
+        static constexpr int rowsPerTile = 32;
+
+    private:
+        struct Job;
+        struct Pool;
+
+        juce::SharedResourcePointer<Pool> pool;
+        std::shared_ptr<Job> job;
+        juce::Image image;
+
+        void handleAsyncUpdate() override;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AsyncRenderer)
+    };
+
+    //==============================================================================
+    /**
+        A cache of rendered planes and strips, shared by every selector in the process.
+
+        Selectors that show the same plane, or a popup that's reopened for a colour it
+        has shown before, find the finished image here instead of rendering it again.
+        The least recently used images are dropped whenever the total size of the
+        images goes over the maximum size.
+
+        There's a single cache, reached through getInstance(), which lives until JUCE
+        shuts down rather than going away with the last selector, so that images
+        survive a popup being closed and opened again. Use it only on the message thread.
+    */
+    class Cache  : private juce::DeletedAtShutdown
+    {
+    public:
+        ~Cache() override;
+
+        JUCE_DECLARE_SINGLETON_SINGLETHREADED (Cache, false)
+
+        /** Describes an image completely: two images with equal keys are identical. */
+        struct Key
+        {
+            /** The colour model's ColourModel::getInstanceId(), or 0 for the HSB and RGB layouts. */
+            juce::uint64 modelId = 0;
+
+            /** The channels on the x and y axes. A strip has its channel in xChannel
+                and -1 in yChannel.
+            */
+            int xChannel = -1, yChannel = -1;
+
+            /** The channels the image is drawn from, with every other channel set to zero. */
+            std::array<float, 6> values {};
+
+            /** The pixel used where a model's colours are out of gamut. */
+            juce::uint32 outOfGamutPixel = 0;
+
+            /** The size in physical pixels, which already includes the display's scale factor. */
+            int width = 0, height = 0;
+
+            /** Compares the values by their bits, after reading -0.0 as 0.0 and every NaN
+                as the same NaN, which is also how KeyHash sees them.
+            */
+            bool operator== (const Key&) const noexcept;
+        };
+
+        /** Returns the image for a key, or a null image if it isn't in the cache. */
+        juce::Image find (const Key& key);
+
+        /** Adds an image, dropping the least recently used ones if the cache gets too big. */
+        void add (const Key& key, const juce::Image& image);
+
+        /** Drops every image. */
+        void clear();
+
+        /** Returns the total size of the images in the cache, in bytes. */
+        size_t getSize() const noexcept             { return totalSize; }
+
+        /** Sets the maximum total size of the images, in bytes. It takes effect when
+            the next image is added. The default is 32 MB.
+        */
+        static void setMaximumSize (size_t numBytes) noexcept;
+
+        /** Returns the maximum total size of the images, in bytes. */
+        static size_t getMaximumSize() noexcept;
+
+    private:
+        Cache() = default;
+
+        struct KeyHash
+        {
+            size_t operator() (const Key&) const noexcept;
+        };
+
+        using Entry = std::pair<Key, juce::Image>;
+
+        // most recently used first
+        std::list<Entry> entries;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+        size_t totalSize = 0;
+
+        static std::atomic<size_t> maximumSize;
+
+        static size_t getSizeOf (const juce::Image&) noexcept;
+        void trim (size_t limit);
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Cache)
+    };
+}
+
+} // namespace reFX
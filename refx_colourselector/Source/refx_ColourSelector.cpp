@@ -2,9 +2,16 @@ namespace reFX
 {
 
 //==============================================================================
-struct ColourComponentSlider  : public juce::Slider
+/** A slider for one channel of the colour, whose track shows the colour that each
+    position of the thumb gives. The track is rendered once into an image and kept
+    until one of the channels it is drawn from changes.
+*/
+class ColourSelector::ColourComponentSlider  : public juce::Slider
 {
-    ColourComponentSlider (const juce::String& name, int max)  : juce::Slider (name)
+public:
+    /** Creates a slider for one of the channels, or for alpha if the channel is empty. */
+    ColourComponentSlider (ColourSelector& cs, const juce::String& name, int max, std::optional<Params> p)
+        : juce::Slider (name), owner (cs), param (p)
     {
         setRange (0.0, double (max), 0.0);
     }
@@ -18,6 +25,78 @@ struct ColourComponentSlider  : public juce::Slider
     {
         return (double) text.getIntValue();
     }
+
+    /** Returns the channels that the track is drawn from: the other two channels of
+        the slider's own model, or the colour itself for the alpha track.
+    */
+    ChannelMask getTrackDependencies() const
+    {
+        if (! param.has_value())
+            return rgbChannels;
+
+        auto model = (getChannelMask (*param) & hsbChannels) != 0 ? hsbChannels : rgbChannels;
+        return model & ~getChannelMask (*param);
+    }
+
+    void channelsChanged (ChannelMask changed)
+    {
+        if ((changed & getTrackDependencies()) != 0)
+        {
+            track = {};
+            repaint();
+        }
+    }
+
+    void releaseTrack()
+    {
+        track = {};
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        auto bounds = getLookAndFeel().getSliderLayout (*this).sliderBounds;
+        auto area = bounds.withSizeKeepingCentre (bounds.getWidth(), juce::jmin (bounds.getHeight() - 4, maxTrackHeight));
+
+        if (area.isEmpty())
+            return;
+
+        // render at device resolution, so the track is exact on HiDPI screens too
+        auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        auto width  = juce::jmax (1, juce::roundToInt ((float) area.getWidth()  * scale));
+        auto height = juce::jmax (1, juce::roundToInt ((float) area.getHeight() * scale));
+
+        if (track.isNull() || track.getWidth() != width || track.getHeight() != height)
+        {
+            track = juce::Image (juce::Image::ARGB, width, height, false);
+            juce::Image::BitmapData pixels (track, juce::Image::BitmapData::writeOnly);
+
+            if (param.has_value())
+                ColourPlane::renderTrack (*param, owner.colour, pixels);
+            else
+                ColourPlane::renderAlphaTrack (owner.colour, juce::roundToInt (checkSize * scale),
+                                               juce::Colour (0xffffffff), juce::Colour (0xffdddddd), pixels);
+        }
+
+        g.drawImage (track, area.toFloat());
+
+        auto x = (float) getPositionOfValue (getValue());
+        auto thumb = juce::Rectangle<float> (5.0f, (float) area.getHeight() + 4.0f).withCentre ({ x, area.toFloat().getCentreY() });
+
+        g.setColour (juce::Colours::black);
+        g.drawRect (thumb, 1.0f);
+        g.setColour (juce::Colours::white);
+        g.drawRect (thumb.reduced (1.0f), 1.0f);
+    }
+
+private:
+    ColourSelector& owner;
+    const std::optional<Params> param;
+    juce::Image track;
+
+    static constexpr int maxTrackHeight = 12;
+    static constexpr float checkSize = 6.0f;
+
+    JUCE_DECLARE_NON_COPYABLE (ColourComponentSlider)
 };
 
 //==============================================================================
@@ -60,21 +139,84 @@ public:
         setWantsKeyboardFocus (true);
         addAndMakeVisible (marker);
         setMouseCursor (juce::MouseCursor::CrosshairCursor);
+
+        renderer.onImageReady = [this]
+        {
+            colours = renderer.getImage();
+            isRefined = true;
+            ColourPlane::Cache::getInstance()->add (renderingKey, colours);
+            repaint();
+        };
     }
 
     void setParameters (Params x_, Params y_)
     {
+        auto layoutChanged = x_ != xParam || y_ != yParam || modelId != 0;
+
         xParam = x_;
         yParam = y_;
+        modelId = 0;
 
-        updateIfNeeded();
+        updateLayout (layoutChanged);
+    }
+
+    /** Chooses the channels of the owner's colour model shown on each axis. */
+    void setModelChannels (int x_, int y_)
+    {
+        auto newModelId = owner.colourModel->getInstanceId();
+        auto layoutChanged = x_ != xChannel || y_ != yChannel || newModelId != modelId;
+
+        xChannel = x_;
+        yChannel = y_;
+        modelId = newModelId;
+
+        updateLayout (layoutChanged);
     }
 
     void paint (juce::Graphics& g) override
     {
-        if (colours.isNull())
+        auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+        if (! juce::approximatelyEqual (scale, deviceScale))
+        {
+            deviceScale = scale;
+            isRefined = false;
+            renderer.cancel();
+        }
+
+        if (! isRefined && ! draftMode && ! renderer.isRendering())
+        {
+            if (auto image = ColourPlane::Cache::getInstance()->find (getCacheKey (getRefinedSize())); image.isValid())
+            {
+                colours = image;
+                isCurrent = true;
+                isRefined = true;
+            }
+        }
+
+        if (colours.isNull() || (draftMode && ! isCurrent))
             updateImage();
 
+        if (! isRefined && ! draftMode && ! renderer.isRendering())
+        {
+            auto size = getRefinedSize();
+            renderingKey = getCacheKey (size);
+
+            if (auto* model = owner.colourModel)
+            {
+                renderer.render ([model, x = xChannel, y = yChannel, values = owner.modelValues, outOfGamut = getOutOfGamutPixel()]
+                                 (const juce::Image::BitmapData& dest, int startRow, int endRow)
+                                 {
+                                     ColourPlane::renderRows (*model, x, y, values, outOfGamut, dest, startRow, endRow);
+                                 },
+                                 size.x, size.y);
+            }
+            else
+            {
+                renderer.render (xParam, yParam, owner.colour, size.x, size.y);
+            }
+        }
+
         g.setOpacity (1.0f);
         g.drawImageTransformed (colours,
                                 juce::RectanglePlacement (juce::RectanglePlacement::stretchToFit)
@@ -83,154 +225,259 @@ public:
                                 false);
     }
 
+    /** Renders the coarse plane, which is cheap enough to do on every change. */
     void updateImage()
     {
-        auto width = getWidth() / 2;
-        auto height = getHeight() / 2;
-        colours = juce::Image (juce::Image::RGB, width, height, false);
+        auto size = getCoarseSize();
 
-        juce::Image::BitmapData pixels (colours, juce::Image::BitmapData::writeOnly);
-
-        for (int y = 0; y < height; ++y)
-        {
-            auto yVal = 1.0f - (float) y / (float) height;
+        if (auto* model = owner.colourModel)
+            colours = ColourPlane::render (*model, xChannel, yChannel, owner.modelValues, getOutOfGamutPixel(), size.x, size.y);
+        else
+            colours = ColourPlane::render (xParam, yParam, owner.colour, size.x, size.y);
 
-            for (int x = 0; x < width; ++x)
-            {
-                auto xVal = (float) x / (float) width;
+        isCurrent = true;
+    }
 
-                auto c = owner.colour;
+    /** While draft mode is on, for example while the 1D strip is being dragged and the
+        plane changes on every event, only the coarse plane is drawn. Turning it off
+        refines the current plane to full device resolution.
+    */
+    void setDraftMode (bool shouldBeDraft)
+    {
+        draftMode = shouldBeDraft;
 
-                auto set = [&] (Params param, float val)
-                {
-                    if (param == Params::hue)
-                    {
-                        auto hsb = c.getHSB();
-                        hsb.h = juce::jlimit (0.0f, 1.0f, val);
-                        c = DeepColour (hsb);
-                    }
-                    else if (param == Params::saturation)
-                    {
-                        auto hsb = c.getHSB();
-                        hsb.s = juce::jlimit (0.0f, 1.0f, val);
-                        c = DeepColour (hsb);
-                    }
-                    else if (param == Params::brightness)
-                    {
-                        auto hsb = c.getHSB();
-                        hsb.b = juce::jlimit (0.0f, 1.0f, val);
-                        c = DeepColour (hsb);
-                    }
-                    else if (param == Params::red)
-                    {
-                        auto rgb = c.getRGB();
-                        rgb.r = juce::jlimit (0.0f, 1.0f, val);
-                        c = DeepColour (rgb);
-                    }
-                    else if (param == Params::blue)
-                    {
-                        auto rgb = c.getRGB();
-                        rgb.b = juce::jlimit (0.0f, 1.0f, val);
-                        c = DeepColour (rgb);
-                    }
-                    else if (param == Params::green)
-                    {
-                        auto rgb = c.getRGB();
-                        rgb.g = juce::jlimit (0.0f, 1.0f, val);
-                        c = DeepColour (rgb);
-                    }
-                    else
-                    {
-                        jassertfalse;
-                    }
-                };
-
-                set (xParam, xVal);
-                set (yParam, yVal);
-
-                pixels.setPixelColour (x, y, c.getColour());
-            }
-        }
+        if (draftMode)
+            renderer.cancel();
+        else if (! isRefined)
+            repaint();
     }
 
     void mouseDown (const juce::MouseEvent& e) override
     {
         grabKeyboardFocus();
+        owner.beginGesture();
         mouseDrag (e);
     }
 
+    void mouseUp (const juce::MouseEvent&) override
+    {
+        owner.endGesture();
+    }
+
     void mouseDrag (const juce::MouseEvent& e) override
     {
         auto xVal =        (float) (e.x - edge) / (float) (getWidth()  - edge * 2);
         auto yVal = 1.0f - (float) (e.y - edge) / (float) (getHeight() - edge * 2);
 
-        auto set = [&] (Params param, float val)
+        if (owner.colourModel != nullptr)
+        {
+            auto values = owner.modelValues;
+            values[size_t (xChannel)] = juce::jlimit (0.0f, 1.0f, xVal);
+            values[size_t (yChannel)] = juce::jlimit (0.0f, 1.0f, yVal);
+
+            if (owner.snapToSwatches)
+                owner.set (owner.getSnappedColour (owner.colourModel->toColour (values, owner.colour.getAlpha())));
+            else
+                owner.setFromModel (values);
+
+            return;
+        }
+
+        auto set = [&] (DeepColour c, Params param, float val)
         {
+            val = juce::jlimit (0.0f, 1.0f, val);
+
             if (param == Params::hue)
             {
-                auto hsb = owner.colour.getHSB();
-                hsb.h = juce::jlimit (0.0f, 1.0f, val);
-                owner.set (DeepColour::fromHSB (hsb.h, hsb.s, hsb.b, owner.colour.getAlpha()));
+                auto hsb = c.getHSB();
+                return DeepColour::fromHSB (val, hsb.s, hsb.b, c.getAlpha());
             }
             else if (param == Params::saturation)
             {
-                auto hsb = owner.colour.getHSB();
-                hsb.s = juce::jlimit (0.0f, 1.0f, val);
-                owner.set (DeepColour::fromHSB (hsb.h, hsb.s, hsb.b, owner.colour.getAlpha()));
+                auto hsb = c.getHSB();
+                return DeepColour::fromHSB (hsb.h, val, hsb.b, c.getAlpha());
             }
             else if (param == Params::brightness)
             {
-                auto hsb = owner.colour.getHSB();
-                hsb.b = juce::jlimit (0.0f, 1.0f, val);
-                owner.set (DeepColour::fromHSB (hsb.h, hsb.s, hsb.b, owner.colour.getAlpha()));
+                auto hsb = c.getHSB();
+                return DeepColour::fromHSB (hsb.h, hsb.s, val, c.getAlpha());
             }
             else if (param == Params::red)
             {
-                auto rgb = owner.colour.getRGB();
-                rgb.r = juce::jlimit (0.0f, 1.0f, val);
-                owner.set (DeepColour::fromRGBA (rgb.r, rgb.g, rgb.b, owner.colour.getAlpha()));
+                auto rgb = c.getRGB();
+                return DeepColour::fromRGBA (val, rgb.g, rgb.b, c.getAlpha());
             }
             else if (param == Params::blue)
             {
-                auto rgb = owner.colour.getRGB();
-                rgb.b = juce::jlimit (0.0f, 1.0f, val);
-                owner.set (DeepColour::fromRGBA (rgb.r, rgb.g, rgb.b, owner.colour.getAlpha()));
+                auto rgb = c.getRGB();
+                return DeepColour::fromRGBA (rgb.r, rgb.g, val, c.getAlpha());
             }
             else if (param == Params::green)
             {
-                auto rgb = owner.colour.getRGB();
-                rgb.g = juce::jlimit (0.0f, 1.0f, val);
-                owner.set (DeepColour::fromRGBA (rgb.r, rgb.g, rgb.b, owner.colour.getAlpha()));
-            }
-            else
-            {
-                jassertfalse;
+                auto rgb = c.getRGB();
+                return DeepColour::fromRGBA (rgb.r, val, rgb.b, c.getAlpha());
             }
+
+            jassertfalse;
+            return c;
         };
 
-        set (xParam, xVal);
-        set (yParam, yVal);
+        owner.set (owner.getSnappedColour (set (set (owner.colour, xParam, xVal), yParam, yVal)));
     }
 
-    void updateIfNeeded()
+    /** Returns the channels that the plane image is generated from. Only the channel
+        that isn't on either axis matters, so a drag inside the plane never needs it rebuilt.
+    */
+    ChannelMask getPlaneDependencies() const
     {
-        colours = {};
-        repaint();
+        if (owner.colourModel != nullptr)
+            return modelChannels & ~getAxisChannels();
+
+        auto axes = getAxisChannels();
+
+        if ((axes & hsbChannels) == axes)
+            return hsbChannels & ~axes;
+
+        if ((axes & rgbChannels) == axes)
+            return rgbChannels & ~axes;
+
+        return (hsbChannels | rgbChannels) & ~axes;
+    }
+
+    void channelsChanged (ChannelMask changed)
+    {
+        if ((changed & getPlaneDependencies()) != 0)
+            invalidatePlane();
+
+        if ((changed & getAxisChannels()) != 0)
+            updateMarker();
+    }
+
+    ChannelMask getAxisChannels() const
+    {
+        if (owner.colourModel != nullptr)
+            return getModelChannelMask (xChannel) | getModelChannelMask (yChannel);
+
+        return getChannelMask (xParam) | getChannelMask (yParam);
+    }
+
+    void updateLayout (bool layoutChanged)
+    {
+        // the old image has other axes, so rather than drawing it until the refined
+        // plane arrives, the next paint() starts again from the coarse plane
+        if (layoutChanged)
+            colours = {};
+
+        invalidatePlane();
         updateMarker();
     }
 
     void resized() override
     {
-        colours = {};
+        invalidatePlane();
         updateMarker();
     }
 
+    /** Waits for the background render, if there is one, and shows its plane. */
+    void finishRendering()
+    {
+        renderer.finishRendering();
+    }
+
+    /** Drops the plane and the background render's copy of it, for a selector that
+        isn't showing. The next paint() starts again from the coarse plane.
+    */
+    void releaseImage()
+    {
+        renderer.clear();
+        colours = {};
+        isCurrent = false;
+        isRefined = false;
+    }
+
 private:
     ColourSelector& owner;
     const int edge;
     juce::Image colours;
     Params xParam = Params::hue;
     Params yParam = Params::saturation;
+    int xChannel = 1;
+    int yChannel = 0;
+    juce::uint64 modelId = 0;
+
+    /** The coarse plane never has more pixels than this, however large the component. */
+    static constexpr int maxCoarsePixels = 192 * 192;
+
+    /** The full resolution plane is rendered in the background. Until it arrives,
+        paint() keeps drawing the last image it had, or the coarse plane while in
+        draft mode or after the axes have changed, so the message thread never waits
+        for a large plane.
+    */
+    ColourPlane::AsyncRenderer renderer;
+    ColourPlane::Cache::Key renderingKey;
+
+    float deviceScale = 1.0f;
+    bool draftMode = false;
+    bool isCurrent = false;
+    bool isRefined = false;
+
+    void invalidatePlane()
+    {
+        renderer.cancel();
+        isCurrent = false;
+        isRefined = false;
+        repaint();
+    }
+
+    juce::uint32 getOutOfGamutPixel() const
+    {
+        return owner.findColour (backgroundColourId).getPixelARGB().getNativeARGB();
+    }
+
+    juce::Point<int> getCoarseSize() const
+    {
+        auto area = getLocalBounds().reduced (edge);
+        auto numPixels = (float) juce::jmax (1, area.getWidth() * area.getHeight());
+        auto scale = juce::jmin (0.5f, std::sqrt ((float) maxCoarsePixels / numPixels));
+
+        return { juce::jmax (1, juce::roundToInt ((float) area.getWidth()  * scale)),
+                 juce::jmax (1, juce::roundToInt ((float) area.getHeight() * scale)) };
+    }
+
+    juce::Point<int> getRefinedSize() const
+    {
+        auto area = getLocalBounds().reduced (edge);
+
+        return { juce::jmax (1, juce::roundToInt ((float) area.getWidth()  * deviceScale)),
+                 juce::jmax (1, juce::roundToInt ((float) area.getHeight() * deviceScale)) };
+    }
+
+    ColourPlane::Cache::Key getCacheKey (juce::Point<int> size) const
+    {
+        ColourPlane::Cache::Key key;
+        key.width = size.x;
+        key.height = size.y;
+
+        if (auto* model = owner.colourModel)
+        {
+            key.modelId = model->getInstanceId();
+            key.xChannel = xChannel;
+            key.yChannel = yChannel;
+            key.outOfGamutPixel = getOutOfGamutPixel();
+
+            for (int c = 0; c < 3; ++c)
+                if (c != xChannel && c != yChannel)
+                    key.values[size_t (c)] = owner.modelValues[size_t (c)];
+        }
+        else
+        {
+            key.xChannel = int (xParam);
+            key.yChannel = int (yParam);
+            key.values = getChannelValues (owner.colour, getPlaneDependencies());
+        }
+
+        return key;
+    }
 
     struct Parameter2DMarker  : public Component
     {
@@ -274,6 +521,15 @@ private:
             return 0.0f;
         };
 
+        if (owner.colourModel != nullptr)
+        {
+            auto x = owner.modelValues[size_t (xChannel)];
+            auto y = owner.modelValues[size_t (yChannel)];
+
+            marker.setBounds (juce::Rectangle<int> (markerSize, markerSize).withCentre (area.getRelativePoint (x, 1.0f - y)));
+            return;
+        }
+
         marker.setBounds (juce::Rectangle<int> (markerSize, markerSize).withCentre (area.getRelativePoint (get (xParam), 1.0f - get (yParam))));
     }
 
@@ -298,58 +554,65 @@ public:
         updateIfNeeded();
     }
 
+    /** Chooses the channel of the owner's colour model that the strip shows. */
+    void setModelChannel (int c)
+    {
+        channel = c;
+
+        updateIfNeeded();
+    }
+
     void paint (juce::Graphics& g) override
     {
-        juce::ColourGradient cg;
-        cg.isRadial = false;
-        cg.point1.setXY (0.0f, (float) edge);
-        cg.point2.setXY (0.0f, (float) getHeight());
+        auto area = getLocalBounds().reduced (edge);
+
+        if (area.isEmpty())
+            return;
 
-        auto c = owner.colour;
-        for (float i = 0.0f; i <= 1.0f; i += 0.02f)
+        // render at device resolution, so the strip is exact on HiDPI screens too
+        auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        auto width  = juce::jmax (1, juce::roundToInt ((float) area.getWidth()  * scale));
+        auto height = juce::jmax (1, juce::roundToInt ((float) area.getHeight() * scale));
+
+        if (strip.isNull() || strip.getWidth() != width || strip.getHeight() != height)
         {
-            if (param == Params::hue)
-            {
-                HSB hsb;
-                hsb.h = 1.0f - i;
-                hsb.s = 1.0f;
-                hsb.b = 1.0f;
-                cg.addColour (i, DeepColour (hsb).getColour());
-            }
-            else if (param == Params::saturation)
-            {
-                auto hsb = c.getHSB();
-                hsb.s = 1.0f - i;
-                cg.addColour (i, DeepColour (hsb).getColour());
-            }
-            else if (param == Params::brightness)
-            {
-                auto hsb = c.getHSB();
-                hsb.b = 1.0f - i;
-                cg.addColour (i, DeepColour (hsb).getColour());
-            }
-            else if (param == Params::red)
+            ColourPlane::Cache::Key key;
+            key.width = width;
+            key.height = height;
+
+            auto* model = owner.colourModel;
+            auto outOfGamutPixel = owner.findColour (backgroundColourId).getPixelARGB().getNativeARGB();
+
+            if (model != nullptr)
             {
-                auto rgb = c.getRGB();
-                rgb.r = 1.0f - i;
-                cg.addColour (i, DeepColour (rgb).getColour());
+                key.modelId = model->getInstanceId();
+                key.xChannel = channel;
+                key.outOfGamutPixel = outOfGamutPixel;
+
+                for (int c = 0; c < 3; ++c)
+                    if (c != channel)
+                        key.values[size_t (c)] = owner.modelValues[size_t (c)];
             }
-            else if (param == Params::blue)
+            else
             {
-                auto rgb = c.getRGB();
-                rgb.b = 1.0f - i;
-                cg.addColour (i, DeepColour (rgb).getColour());
+                key.xChannel = int (param);
+                key.values = getChannelValues (owner.colour, getStripDependencies());
             }
-            else if (param == Params::green)
+
+            strip = ColourPlane::Cache::getInstance()->find (key);
+
+            if (strip.isNull())
             {
-                auto rgb = c.getRGB();
-                rgb.g = 1.0f - i;
-                cg.addColour (i, DeepColour (rgb).getColour());
+                if (model != nullptr)
+                    strip = ColourPlane::renderStrip (*model, channel, owner.modelValues, outOfGamutPixel, width, height);
+                else
+                    strip = ColourPlane::renderStrip (param, owner.colour, width, height);
+
+                ColourPlane::Cache::getInstance()->add (key, strip);
             }
         }
 
-        g.setGradientFill (cg);
-        g.fillRect (getLocalBounds().reduced (edge));
+        g.drawImage (strip, area.toFloat());
     }
 
     void resized() override
@@ -359,6 +622,9 @@ public:
 
         auto get = [&] ()
         {
+            if (owner.colourModel != nullptr)
+                return owner.modelValues[size_t (channel)];
+
             if (param == Params::hue)
                 return owner.colour.getHSB().h;
             else if (param == Params::saturation)
@@ -382,14 +648,33 @@ public:
     void mouseDown (const juce::MouseEvent& e) override
     {
         grabKeyboardFocus();
+
+        if (owner.parameter2D != nullptr)
+            owner.parameter2D->setDraftMode (true);
+
+        owner.beginGesture();
         mouseDrag (e);
     }
 
+    void mouseUp (const juce::MouseEvent&) override
+    {
+        if (owner.parameter2D != nullptr)
+            owner.parameter2D->setDraftMode (false);
+
+        owner.endGesture();
+    }
+
     void mouseDrag (const juce::MouseEvent& e) override
     {
         auto val = 1.0f - (float) (e.y - edge) / (float) (getHeight() - edge * 2);
 
-        if (param == Params::hue)
+        if (owner.colourModel != nullptr)
+        {
+            auto values = owner.modelValues;
+            values[size_t (channel)] = juce::jlimit (0.0f, 1.0f, val);
+            owner.setFromModel (values);
+        }
+        else if (param == Params::hue)
         {
             auto hsb = owner.colour.getHSB();
             hsb.h = juce::jlimit (0.0f, 1.0f, val);
@@ -433,10 +718,45 @@ public:
 
     void updateIfNeeded()
     {
+        strip = {};
         repaint();
         resized();
     }
 
+    void releaseImage()
+    {
+        strip = {};
+    }
+
+    /** Returns the channels that the strip is drawn from. The hue strip is always
+        fully saturated and bright, so it doesn't depend on the colour at all.
+    */
+    ChannelMask getStripDependencies() const
+    {
+        if (owner.colourModel != nullptr)
+            return modelChannels & ~getModelChannelMask (channel);
+
+        if (param == Params::hue)
+            return 0;
+
+        auto model = (getChannelMask (param) & hsbChannels) != 0 ? hsbChannels : rgbChannels;
+        return model & ~getChannelMask (param);
+    }
+
+    void channelsChanged (ChannelMask changed)
+    {
+        if ((changed & getStripDependencies()) != 0)
+        {
+            strip = {};
+            repaint();
+        }
+
+        auto shown = owner.colourModel != nullptr ? getModelChannelMask (channel) : getChannelMask (param);
+
+        if ((changed & shown) != 0)
+            resized();
+    }
+
 private:
     ColourSelector& owner;
     const int edge;
@@ -472,87 +792,362 @@ private:
 
     Parameter1DMarker marker;
     Params param = Params::hue;
+    int channel = 0;
+    juce::Image strip;
 
     JUCE_DECLARE_NON_COPYABLE (Parameter1D)
 };
 
 //==============================================================================
-class ColourSelector::SwatchComponent   : public Component
+/** The wheel and the triangle, which show hue, saturation and brightness round a
+    centre. The image is kept until a channel it's drawn from changes, and the
+    renderers keep their per-pixel tables until the size changes.
+*/
+class ColourSelector::PolarView  : public Component
 {
 public:
-    SwatchComponent (ColourSelector& cs, int itemIndex)
-        : owner (cs), index (itemIndex)
+    PolarView (ColourSelector& cs, int edgeSize)
+        : owner (cs), edge (edgeSize)
     {
+        setWantsKeyboardFocus (true);
+        setMouseCursor (juce::MouseCursor::CrosshairCursor);
     }
 
-    void paint (juce::Graphics& g) override
+    void setShape (PlaneShape newShape)
     {
-        auto col = owner.getSwatchColour (index);
-
-        g.fillCheckerBoard (getLocalBounds().toFloat(), 6.0f, 6.0f,
-                            juce::Colour (0xffdddddd).overlaidWith (col),
-                            juce::Colour (0xffffffff).overlaidWith (col));
+        if (shape != newShape)
+        {
+            shape = newShape;
+            releaseImage();
+            repaint();
+        }
     }
 
-    void mouseDown (const juce::MouseEvent&) override
+    /** Returns the channels that the image is drawn from: the brightness of the wheel,
+        or the hue of the triangle. The ring around the triangle never changes.
+    */
+    ChannelMask getImageDependencies() const
     {
-        juce::PopupMenu m;
-        m.addItem (1, TRANS("Use this swatch as the current colour"));
-        m.addSeparator();
-        m.addItem (2, TRANS("Set this swatch to the current colour"));
-
-        m.showMenuAsync (juce::PopupMenu::Options().withTargetComponent (this),
-                         juce::ModalCallbackFunction::forComponent (menuStaticCallback, this));
+        return getChannelMask (shape == PlaneShape::wheel ? Params::brightness : Params::hue);
     }
 
-private:
-    ColourSelector& owner;
-    const int index;
-
-    static void menuStaticCallback (int result, SwatchComponent* comp)
+    void channelsChanged (ChannelMask changed)
     {
-        if (comp != nullptr)
-        {
-            if (result == 1)  comp->setColourFromSwatch();
-            if (result == 2)  comp->setSwatchFromColour();
-        }
+        if ((changed & getImageDependencies()) != 0)
+            image = {};
+
+        // the markers are painted along with the image
+        if ((changed & hsbChannels) != 0)
+            repaint();
     }
 
-    void setColourFromSwatch()
+    void releaseImage()
     {
-        owner.set (owner.getSwatchColour (index));
+        image = {};
+        wheel.clear();
+        triangle.clear();
     }
 
-    void setSwatchFromColour()
+    void paint (juce::Graphics& g) override
     {
-        if (owner.getSwatchColour (index) != owner.getCurrentColour())
+        auto area = getPlaneArea();
+
+        if (area.isEmpty())
+            return;
+
+        // render at device resolution, so the edges are exact on HiDPI screens too
+        auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        auto size = juce::jmax (1, juce::roundToInt (area.getWidth() * scale));
+
+        if (image.isNull() || image.getWidth() != size)
         {
-            owner.setSwatchColour (index, owner.getCurrentColour());
-            repaint();
+            auto hsb = owner.colour.getHSB();
+            image = shape == PlaneShape::wheel ? wheel.render (hsb.b, size)
+                                               : triangle.render (hsb.h, size);
         }
-    }
 
-    JUCE_DECLARE_NON_COPYABLE (SwatchComponent)
-};
+        g.drawImage (image, area);
 
-//==============================================================================
-class ColourSelector::ColourPreviewComp  : public Component
-{
-public:
-    ColourPreviewComp (ColourSelector& cs, bool isEditable)
-        : owner (cs)
-    {
-        colourLabel.setFont (labelFont);
-        colourLabel.setJustificationType (juce::Justification::centred);
+        auto hsb = owner.colour.getHSB();
 
-        if (isEditable)
+        if (shape == PlaneShape::wheel)
         {
-            colourLabel.setEditable (true);
+            drawMarker (g, PolarPlane::Wheel::getPosition (hsb.h, hsb.s));
+        }
+        else
+        {
+            auto ringRadius = (PolarPlane::Triangle::ringInnerRadius + 1.0f) * 0.5f;
 
-            colourLabel.onEditorShow = [this]
+            drawMarker (g, PolarPlane::Wheel::getPosition (hsb.h, ringRadius));
+            drawMarker (g, PolarPlane::Triangle::getPosition (hsb.s, hsb.b));
+        }
+    }
+
+    void resized() override
+    {
+        image = {};
+    }
+
+    void mouseDown (const juce::MouseEvent& e) override
+    {
+        grabKeyboardFocus();
+
+        draggingRing = shape == PlaneShape::triangle && PolarPlane::Triangle::isInRing (toUnit (e.position));
+
+        owner.beginGesture();
+        mouseDrag (e);
+    }
+
+    void mouseUp (const juce::MouseEvent&) override
+    {
+        owner.endGesture();
+    }
+
+    void mouseDrag (const juce::MouseEvent& e) override
+    {
+        auto position = toUnit (e.position);
+        auto hsb = owner.colour.getHSB();
+
+        if (shape == PlaneShape::wheel)
+            std::tie (hsb.h, hsb.s) = PolarPlane::Wheel::getHueAndSaturation (position);
+        else if (draggingRing)
+            hsb.h = PolarPlane::Triangle::getHue (position);
+        else
+            std::tie (hsb.s, hsb.b) = PolarPlane::Triangle::getSaturationAndBrightness (position);
+
+        owner.set (owner.getSnappedColour (DeepColour::fromHSB (hsb.h, hsb.s, hsb.b, owner.colour.getAlpha())));
+    }
+
+private:
+    ColourSelector& owner;
+    const int edge;
+    PlaneShape shape = PlaneShape::wheel;
+    bool draggingRing = false;
+
+    juce::Image image;
+    PolarPlane::Wheel wheel;
+    PolarPlane::Triangle triangle;
+
+    /** The largest square that fits inside the edge, centred. */
+    juce::Rectangle<float> getPlaneArea() const
+    {
+        auto area = getLocalBounds().reduced (edge);
+        auto size = juce::jmin (area.getWidth(), area.getHeight());
+
+        return area.withSizeKeepingCentre (size, size).toFloat();
+    }
+
+    juce::Point<float> toUnit (juce::Point<float> position) const
+    {
+        auto area = getPlaneArea();
+        auto half = juce::jmax (1.0f, area.getWidth() * 0.5f);
+
+        return { (position.x - area.getCentreX()) / half, (area.getCentreY() - position.y) / half };
+    }
+
+    void drawMarker (juce::Graphics& g, juce::Point<float> unitPosition) const
+    {
+        auto area = getPlaneArea();
+        auto half = area.getWidth() * 0.5f;
+        auto markerSize = (float) juce::jmax (14, edge * 2);
+
+        auto bounds = juce::Rectangle<float> (markerSize, markerSize)
+                          .withCentre ({ area.getCentreX() + unitPosition.x * half, area.getCentreY() - unitPosition.y * half });
+
+        g.setColour (juce::Colour::greyLevel (0.1f));
+        g.drawEllipse (bounds.reduced (1.0f), 1.0f);
+        g.setColour (juce::Colour::greyLevel (0.9f));
+        g.drawEllipse (bounds.reduced (2.0f), 1.0f);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (PolarView)
+};
+
+//==============================================================================
+/** All the swatches in one component, laid out in rows inside a viewport. Only the
+    cells that intersect the clip region are painted, and the cell under the mouse
+    is found arithmetically, so a palette of thousands of colours costs no more
+    than the handful of rows that are visible.
+*/
+class ColourSelector::SwatchGrid   : public Component
+{
+public:
+    static constexpr int swatchesPerRow = 8;
+    static constexpr int swatchHeight = 22;
+    static constexpr int xGap = 4;
+    static constexpr int yGap = 4;
+
+    explicit SwatchGrid (ColourSelector& cs)
+        : owner (cs)
+    {
+        setOpaque (false);
+    }
+
+    void setNumSwatches (int newNumSwatches)
+    {
+        if (numSwatches != newNumSwatches)
+        {
+            numSwatches = newNumSwatches;
+            repaint();
+        }
+    }
+
+    int getNumSwatches() const              { return numSwatches; }
+    int getNumRows() const                  { return (numSwatches + swatchesPerRow - 1) / swatchesPerRow; }
+    int getCellWidth() const                { return getWidth() / swatchesPerRow; }
+
+    juce::Rectangle<int> getCellBounds (int index) const
+    {
+        auto cellWidth = getCellWidth();
+
+        return { (index % swatchesPerRow) * cellWidth + xGap / 2,
+                 (index / swatchesPerRow) * swatchHeight + yGap / 2,
+                 cellWidth - xGap,
+                 swatchHeight - yGap };
+    }
+
+    /** Returns the swatch under a position, or -1 if it's between or beyond the swatches. */
+    int getIndexAt (juce::Point<int> pos) const
+    {
+        auto cellWidth = getCellWidth();
+
+        if (cellWidth <= 0 || pos.x < 0 || pos.y < 0)
+            return -1;
+
+        auto column = pos.x / cellWidth;
+        auto index = (pos.y / swatchHeight) * swatchesPerRow + column;
+
+        if (column >= swatchesPerRow || index >= numSwatches || ! getCellBounds (index).contains (pos))
+            return -1;
+
+        return index;
+    }
+
+    void repaintSwatch (int index)
+    {
+        if (juce::isPositiveAndBelow (index, numSwatches))
+            repaint (getCellBounds (index));
+    }
+
+    void repaintSwatches (juce::Range<int> range)
+    {
+        range = range.getIntersectionWith ({ 0, numSwatches });
+
+        if (! range.isEmpty())
+        {
+            auto firstRow = range.getStart() / swatchesPerRow;
+            auto lastRow = (range.getEnd() - 1) / swatchesPerRow;
+
+            repaint (0, firstRow * swatchHeight, getWidth(), (lastRow - firstRow + 1) * swatchHeight);
+        }
+    }
+
+    void paint (juce::Graphics& g) override
+    {
+        auto clip = g.getClipBounds();
+        auto firstRow = juce::jmax (0, clip.getY() / swatchHeight);
+        auto lastRow = juce::jmin (getNumRows(), clip.getBottom() / swatchHeight + 1);
+
+        auto first = firstRow * swatchesPerRow;
+        auto last = juce::jmin (numSwatches, lastRow * swatchesPerRow);
+
+        // one checkerboard behind all the visible translucent swatches, rather than one per swatch
+        juce::RectangleList<int> translucent;
+
+        for (int i = first; i < last; ++i)
+        {
+            auto colour = owner.getSwatchColour (i);
+
+            if (colour.isOpaque())
+            {
+                g.setColour (colour);
+                g.fillRect (getCellBounds (i));
+            }
+            else
+            {
+                translucent.addWithoutMerging (getCellBounds (i));
+            }
+        }
+
+        if (! translucent.isEmpty())
+        {
+            juce::Graphics::ScopedSaveState sss (g);
+
+            g.reduceClipRegion (translucent);
+            g.fillCheckerBoard (translucent.getBounds().toFloat(), 6.0f, 6.0f,
+                                juce::Colour (0xffdddddd), juce::Colour (0xffffffff));
+
+            for (auto& r : translucent)
+            {
+                g.setColour (owner.getSwatchColour (getIndexAt (r.getPosition())));
+                g.fillRect (r);
+            }
+        }
+    }
+
+    void mouseDown (const juce::MouseEvent& e) override
+    {
+        auto index = getIndexAt (e.getPosition());
+
+        if (index < 0)
+            return;
+
+        juce::PopupMenu m;
+        m.addItem (1, TRANS("Use this swatch as the current colour"));
+        m.addSeparator();
+        m.addItem (2, TRANS("Set this swatch to the current colour"));
+
+        m.showMenuAsync (juce::PopupMenu::Options().withTargetScreenArea (localAreaToGlobal (getCellBounds (index))),
+                         [safeThis = SafePointer<SwatchGrid> (this), index] (int result)
+                         {
+                             if (safeThis != nullptr && index < safeThis->numSwatches)
+                             {
+                                 if (result == 1)  safeThis->setColourFromSwatch (index);
+                                 if (result == 2)  safeThis->setSwatchFromColour (index);
+                             }
+                         });
+    }
+
+private:
+    ColourSelector& owner;
+    int numSwatches = 0;
+
+    void setColourFromSwatch (int index)
+    {
+        owner.set (owner.getSwatchColour (index));
+    }
+
+    void setSwatchFromColour (int index)
+    {
+        if (owner.getSwatchColour (index) != owner.getCurrentColour())
+        {
+            owner.setSwatchColour (index, owner.getCurrentColour());
+            owner.swatchColourChanged (index);
+            repaintSwatch (index);
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (SwatchGrid)
+};
+
+//==============================================================================
+class ColourSelector::ColourPreviewComp  : public Component
+{
+public:
+    ColourPreviewComp (ColourSelector& cs, bool isEditable)
+        : owner (cs)
+    {
+        colourLabel.setFont (labelFont);
+        colourLabel.setJustificationType (juce::Justification::centred);
+
+        if (isEditable)
+        {
+            colourLabel.setEditable (true);
+
+            colourLabel.onEditorShow = [this]
             {
                 if (auto* ed = colourLabel.getCurrentTextEditor())
-                    ed->setInputRestrictions ((owner.flags & showAlphaChannel) ? 8 : 6, "1234567890ABCDEFabcdef");
+                    ed->setInputRestrictions ((int) std::tuple_size_v<ColourText::Buffer>);
             };
 
             colourLabel.onEditorHide = [this]
@@ -575,7 +1170,9 @@ public:
 
             colourLabel.setColour (juce::Label::textColourId,            textColour);
             colourLabel.setColour (juce::Label::textWhenEditingColourId, textColour);
-            colourLabel.setText (currentColour.toDisplayString ((owner.flags & showAlphaChannel) != 0), juce::dontSendNotification);
+            ColourText::Buffer buffer;
+            auto text = ColourText::format (DeepColour (currentColour), ColourText::Format::hex, (owner.flags & showAlphaChannel) != 0, buffer);
+            colourLabel.setText (juce::String::fromUTF8 (text.data(), (int) text.size()), juce::dontSendNotification);
 
             labelWidth = labelFont.getStringWidth (colourLabel.getText());
 
@@ -598,10 +1195,10 @@ public:
 private:
     void updateColourIfNecessary (const juce::String& newColourString)
     {
-        auto newColour = juce::Colour::fromString (newColourString);
+        auto newColour = ColourText::parse ({ newColourString.toRawUTF8(), newColourString.getNumBytesAsUTF8() });
 
-        if (newColour != currentColour)
-            owner.set (newColour);
+        if (newColour.has_value() && newColour->getColour() != currentColour)
+            owner.set (*newColour);
     }
 
     ColourSelector& owner;
@@ -614,17 +1211,130 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ColourPreviewComp)
 };
 
+//==============================================================================
+/** A fixed-size ring of past states for undo and redo. All the memory is allocated
+    up front, so that recording a state during a drag costs a copy and nothing more.
+*/
+class ColourSelector::History
+{
+public:
+    struct State
+    {
+        DeepColour colour;
+        Params activeParam = Params::hue;
+    };
+
+    explicit History (const State& initialState)
+    {
+        reset (initialState);
+    }
+
+    void reset (const State& state)
+    {
+        oldest = 0;
+        count = 1;
+        position = 0;
+        at (0) = state;
+    }
+
+    void setCapacity (size_t newCapacity)
+    {
+        jassert (newCapacity > 0);
+        newCapacity = juce::jmax (size_t (1), newCapacity);
+
+        // keep the newest states that fit, and the current one whatever happens
+        auto first = count > newCapacity ? juce::jmin (count - newCapacity, position) : size_t (0);
+        auto numToKeep = juce::jmin (count - first, newCapacity);
+
+        std::vector<State> newStates (newCapacity);
+
+        for (size_t i = 0; i < numToKeep; ++i)
+            newStates[i] = at (first + i);
+
+        states = std::move (newStates);
+        oldest = 0;
+        count = numToKeep;
+        position -= first;
+    }
+
+    /** Adds a state after the current one, dropping any that could have been redone. */
+    void push (const State& state)
+    {
+        count = position + 1;
+
+        if (count == states.size())
+        {
+            oldest = (oldest + 1) % states.size();
+            --count;
+        }
+
+        at (count) = state;
+        position = count++;
+    }
+
+    void replaceCurrent (const State& state)    { at (position) = state; }
+
+    bool canUndo() const noexcept               { return position > 0; }
+    bool canRedo() const noexcept               { return position + 1 < count; }
+
+    const State& undo()                         { jassert (canUndo()); return at (--position); }
+    const State& redo()                         { jassert (canRedo()); return at (++position); }
+
+private:
+    std::vector<State> states = std::vector<State> (100);
+    size_t oldest = 0, count = 0, position = 0;
+
+    State& at (size_t index)                    { return states[(oldest + index) % states.size()]; }
+
+    JUCE_DECLARE_NON_COPYABLE (History)
+};
+
 //==============================================================================
 ColourSelector::ColourSelector (int sectionsToShow, int edge, int gapAroundColourSpaceComponent)
     : colour (juce::Colours::white),
       flags (sectionsToShow),
-      edgeGap (edge)
+      edgeGap (edge),
+      colourspaceGap (gapAroundColourSpaceComponent)
 {
-    setLookAndFeel (&lf);
+    setLookAndFeel (lf.get());
 
     // not much point having a selector with no components in it!
     jassert ((flags & (showColourAtTop | showRGBSliders | showHSBSliders | showColourspace)) != 0);
 
+    // with only the RGB sliders toggled, the first of them starts out active
+    if ((flags & (showToggle | showHSBSliders | showRGBSliders)) == (showToggle | showRGBSliders))
+        selectedParam = Params::red;
+
+    if ((flags & lightweight) != 0)
+        visibilityWatcher = std::make_unique<VisibilityWatcher> (*this);
+    else
+        createComponents();
+
+    if ((flags & coalesceUpdates) != 0)
+        vBlankAttachment = juce::VBlankAttachment (this, [this] { updatePendingViews(); });
+
+    notificationTimer.callback = [this] { sendPendingNotification(); };
+
+    update (juce::dontSendNotification);
+    updateParameters();
+
+    history = std::make_unique<History> (History::State { colour, getActiveParam() });
+}
+
+ColourSelector::~ColourSelector()
+{
+    setLookAndFeel (nullptr);
+    dispatchPendingMessages();
+    setSwatchPalette (nullptr);
+    swatchViewport = nullptr;
+    swatchGrid = nullptr;
+}
+
+void ColourSelector::createComponents()
+{
+    jassert (! componentsCreated);
+    componentsCreated = true;
+
     if ((flags & showColourAtTop) != 0)
     {
         previewComponent.reset (new ColourPreviewComp (*this, (flags & editableColour) != 0));
@@ -633,9 +1343,9 @@ ColourSelector::ColourSelector (int sectionsToShow, int edge, int gapAroundColou
 
     if ((flags & showHSBSliders) != 0)
     {
-        sliders.add (hueSlider = new ColourComponentSlider (TRANS ("H"), 360));
-        sliders.add (saturationSlider = new ColourComponentSlider (TRANS ("S"), 100));
-        sliders.add (brightnessSlider = new ColourComponentSlider (TRANS ("B"), 100));
+        hueSlider = sliders.add (new ColourComponentSlider (*this, TRANS ("H"), 360, Params::hue));
+        saturationSlider = sliders.add (new ColourComponentSlider (*this, TRANS ("S"), 100, Params::saturation));
+        brightnessSlider = sliders.add (new ColourComponentSlider (*this, TRANS ("B"), 100, Params::brightness));
 
         if ((flags & showToggle) != 0)
         {
@@ -647,9 +1357,9 @@ ColourSelector::ColourSelector (int sectionsToShow, int edge, int gapAroundColou
     if ((flags & showRGBSliders) != 0)
     {
 
-        sliders.add (redSlider = new ColourComponentSlider (TRANS ("R"), 255));
-        sliders.add (greenSlider = new ColourComponentSlider (TRANS ("G"), 255));
-        sliders.add (blueSlider = new ColourComponentSlider (TRANS ("B"), 255));
+        redSlider = sliders.add (new ColourComponentSlider (*this, TRANS ("R"), 255, Params::red));
+        greenSlider = sliders.add (new ColourComponentSlider (*this, TRANS ("G"), 255, Params::green));
+        blueSlider = sliders.add (new ColourComponentSlider (*this, TRANS ("B"), 255, Params::blue));
 
         if ((flags & showToggle) != 0)
         {
@@ -660,12 +1370,14 @@ ColourSelector::ColourSelector (int sectionsToShow, int edge, int gapAroundColou
     }
 
     if ((flags & showAlphaChannel) != 0)
-        sliders.add (alphaSlider = new ColourComponentSlider (TRANS ("A"), 255));
+        alphaSlider = sliders.add (new ColourComponentSlider (*this, TRANS ("A"), 255, std::nullopt));
 
     for (auto& slider : sliders)
     {
         addAndMakeVisible (slider);
         slider->onValueChange = [this, slider] { changeColour (slider); };
+        slider->onDragStart = [this] { beginGesture(); };
+        slider->onDragEnd = [this] { endGesture(); };
     }
 
     for (auto& toggle : toggles)
@@ -673,16 +1385,24 @@ ColourSelector::ColourSelector (int sectionsToShow, int edge, int gapAroundColou
         addAndMakeVisible (toggle);
         toggle->setButtonText ({});
         toggle->setRadioGroupId (1);
-        toggle->onClick = [this] { updateParameters(); sendChangeMessage(); };
+        toggle->setToggleState ((Params) toggle->getName().getIntValue() == selectedParam, juce::dontSendNotification);
+        toggle->onClick = [this, toggle]
+        {
+            // turning the other radio buttons off calls their onClick too
+            if (! toggle->getToggleState())
+                return;
+
+            selectedParam = (Params) toggle->getName().getIntValue();
+            updateParameters();
+            recordHistory();
+            sendChangeMessage();
+        };
     }
 
-    if (toggles.size() > 0)
-        toggles[0]->setToggleState (true, juce::dontSendNotification);
-
     if ((flags & showColourspace) != 0)
     {
-        parameter2D.reset (new Parameter2D (*this, gapAroundColourSpaceComponent));
-        parameter1D.reset (new Parameter1D (*this, gapAroundColourSpaceComponent));
+        parameter2D.reset (new Parameter2D (*this, colourspaceGap));
+        parameter1D.reset (new Parameter1D (*this, colourspaceGap));
 
         addAndMakeVisible (parameter2D.get());
         addAndMakeVisible (parameter1D.get());
@@ -694,131 +1414,506 @@ ColourSelector::ColourSelector (int sectionsToShow, int edge, int gapAroundColou
         hex->setJustification (juce::Justification::centred);
         hex->onTextChange = [this]
         {
-            auto hcol = hex->getText();
+            auto text = hex->getText();
 
-            // convert hex3 and hex4 formats to hex6 and hex8
-            if ( hcol.length () == 3 )
-                hcol = juce::String::formatted ( "%c%c%c%c%c%c", hcol[ 0 ], hcol[ 0 ], hcol[ 1 ], hcol[ 1 ], hcol[ 2 ], hcol[ 2 ] );
-            else if ( hcol.length () == 4 )
-                hcol = juce::String::formatted ( "%c%c%c%c%c%c%c%c", hcol[ 0 ], hcol[ 0 ], hcol[ 1 ], hcol[ 1 ], hcol[ 2 ], hcol[ 2 ], hcol[ 3 ], hcol[ 3 ] );
+            if (auto newColour = ColourText::parse ({ text.toRawUTF8(), text.getNumBytesAsUTF8() }); newColour && *newColour != colour)
+            {
+                // everything typed until return or focus loss is one edit, and one undo step,
+                // however many of the partly typed values along the way happen to parse
+                if (! hexEditInProgress)
+                {
+                    beginGesture();
+                    hexEditInProgress = true;
+                }
 
-            // Add missing alpha
-            if ( hcol.length () == 6 )
-                hcol += juce::String ( "ff" );
+                auto changed = getChangedChannels (colour, *newColour);
 
-            // Convert rgba to argb (JUCE is weird)
-            if ( hcol.length () == 8 )
-            {
-                colour = juce::Colour::fromString (hcol.substring (6) + hcol.substring (0, 6));
-                update (juce::sendNotification);
+                colour = *newColour;
+                update (juce::sendNotification, changed);
+                recordHistory();
             }
         };
+        hex->onReturnKey = [this]
+        {
+            endHexEdit();
+        };
+        hex->onEscapeKey = [this]
+        {
+            endHexEdit();
+        };
         hex->onFocusLost = [this]
         {
+            endHexEdit();
             update (juce::sendNotification);
         };
         addAndMakeVisible (*hex);
     }
 
-    if ((flags & showOriginalColour) != 0)
-    {
-        originalColourComponent = std::make_unique<OriginalColourComp> (*this);
-        addAndMakeVisible (*originalColourComponent);
-    }
+    if ((flags & showOriginalColour) != 0)
+    {
+        originalColourComponent = std::make_unique<OriginalColourComp> (*this);
+        addAndMakeVisible (*originalColourComponent);
+    }
+
+    if ((flags & showReset) != 0)
+    {
+        resetButton = std::make_unique<juce::TextButton> ("reset");
+        resetButton->onClick = [this]
+        {
+            set (originalColour);
+        };
+        addAndMakeVisible (*resetButton);
+    }
+}
+
+//==============================================================================
+class ColourSelector::VisibilityWatcher  : public juce::ComponentMovementWatcher
+{
+public:
+    explicit VisibilityWatcher (ColourSelector& cs)
+        : juce::ComponentMovementWatcher (&cs), owner (cs)
+    {
+    }
+
+    void componentMovedOrResized (bool, bool) override {}
+    void componentPeerChanged() override                { owner.showingChanged(); }
+    void componentVisibilityChanged() override          { owner.showingChanged(); }
+
+    using juce::ComponentMovementWatcher::componentVisibilityChanged;
+
+private:
+    ColourSelector& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (VisibilityWatcher)
+};
+
+void ColourSelector::showingChanged()
+{
+    if (! isShowing())
+    {
+        releaseImages();
+        return;
+    }
+
+    if (! componentsCreated)
+    {
+        createComponents();
+
+        pendingChannels = 0;
+        updateViews (allChannels);
+        updateParameters();
+        resized();
+    }
+}
+
+void ColourSelector::releaseImages()
+{
+    if (parameter2D != nullptr)
+    {
+        parameter2D->releaseImage();
+        parameter1D->releaseImage();
+    }
+
+    if (polarView != nullptr)
+        polarView->releaseImage();
+
+    for (auto* slider : sliders)
+        slider->releaseTrack();
+}
+
+void ColourSelector::finishBackgroundRendering()
+{
+    if (parameter2D != nullptr)
+        parameter2D->finishRendering();
+}
+
+//==============================================================================
+juce::Colour ColourSelector::getCurrentColour() const
+{
+    return ((flags & showAlphaChannel) != 0) ? colour.getColour() : colour.getColour().withAlpha ((juce::uint8) 0xff);
+}
+
+void ColourSelector::setCurrentColour (juce::Colour c, juce::NotificationType notification)
+{
+    if (DeepColour (c) != colour)
+    {
+        DeepColour newColour (((flags & showAlphaChannel) != 0) ? c : c.withAlpha ((juce::uint8) 0xff));
+        auto changed = getChangedChannels (colour, newColour);
+
+        originalColour = c;
+        colour = newColour;
+        update (notification, changed);
+
+        if (history != nullptr)
+            history->replaceCurrent ({ colour, getActiveParam() });
+    }
+}
+
+void ColourSelector::setCurrentColour (DeepColour c, juce::NotificationType notification)
+{
+    if (c != colour)
+    {
+        auto newColour = ((flags & showAlphaChannel) != 0) ? c : c.withAlpha (1.0f);
+        auto changed = getChangedChannels (colour, newColour);
+
+        originalColour = c;
+        colour = newColour;
+        update (notification, changed);
+
+        if (history != nullptr)
+            history->replaceCurrent ({ colour, getActiveParam() });
+    }
+}
+
+void ColourSelector::set (const DeepColour& newColour)
+{
+    auto changed = getChangedChannels (colour, newColour);
+
+    colour = newColour;
+    update (juce::sendNotification, changed);
+    recordHistory();
+}
+
+void ColourSelector::setFromModel (const ColourModel::Values& values)
+{
+    jassert (colourModel != nullptr);
+
+    // the values are kept as they are rather than recomputed from the clipped colour,
+    // so that dragging through a grey or out of gamut region doesn't lose the position
+    ChannelMask changed = 0;
+
+    for (int c = 0; c < 3; ++c)
+        if (! juce::approximatelyEqual (values[size_t (c)], modelValues[size_t (c)]))
+            changed |= getModelChannelMask (c);
+
+    auto newColour = colourModel->toColour (values, colour.getAlpha());
+    changed |= getChangedChannels (colour, newColour);
+
+    modelValues = values;
+    colour = newColour;
+
+    {
+        const juce::ScopedValueSetter<bool> svs (keepModelValues, true);
+        update (juce::sendNotification, changed);
+    }
+
+    recordHistory();
+}
+
+ColourSelector::ChannelMask ColourSelector::updateModelValues()
+{
+    if (colourModel == nullptr)
+        return 0;
+
+    auto newValues = colourModel->fromColour (colour);
+    ChannelMask changed = 0;
+
+    for (int c = 0; c < 3; ++c)
+        if (! juce::approximatelyEqual (newValues[size_t (c)], modelValues[size_t (c)]))
+            changed |= getModelChannelMask (c);
+
+    modelValues = newValues;
+    return changed;
+}
+
+ColourSelector::ChannelMask ColourSelector::getChangedChannels (const DeepColour& oldColour, const DeepColour& newColour)
+{
+    auto oldHSB = oldColour.getHSB();
+    auto newHSB = newColour.getHSB();
+    auto oldRGB = oldColour.getRGB();
+    auto newRGB = newColour.getRGB();
+
+    ChannelMask changed = 0;
+
+    auto compare = [&] (float a, float b, ChannelMask mask)
+    {
+        if (! juce::approximatelyEqual (a, b))
+            changed |= mask;
+    };
+
+    compare (oldHSB.h, newHSB.h, getChannelMask (Params::hue));
+    compare (oldHSB.s, newHSB.s, getChannelMask (Params::saturation));
+    compare (oldHSB.b, newHSB.b, getChannelMask (Params::brightness));
+    compare (oldRGB.r, newRGB.r, getChannelMask (Params::red));
+    compare (oldRGB.g, newRGB.g, getChannelMask (Params::green));
+    compare (oldRGB.b, newRGB.b, getChannelMask (Params::blue));
+    compare (oldColour.getAlpha(), newColour.getAlpha(), alphaChannel);
+
+    return changed;
+}
+
+std::array<float, 6> ColourSelector::getChannelValues (const DeepColour& c, ChannelMask mask)
+{
+    auto hsb = c.getHSB();
+    auto rgb = c.getRGB();
+    const float all[] = { hsb.h, hsb.s, hsb.b, rgb.r, rgb.g, rgb.b };
+
+    std::array<float, 6> values {};
+
+    for (size_t i = 0; i < values.size(); ++i)
+        if ((mask & (1 << i)) != 0)
+            values[i] = all[i];
+
+    return values;
+}
+
+//==============================================================================
+void ColourSelector::update (juce::NotificationType notification, ChannelMask changed)
+{
+    publishSnapshot();
+
+    if (! keepModelValues)
+        changed |= updateModelValues();
+
+    // the colour itself is already up to date, only the views wait for the next frame
+    if ((flags & coalesceUpdates) != 0 && isShowing())
+        pendingChannels |= changed;
+    else
+        updateViews (changed);
+
+    if (notification != juce::dontSendNotification)
+        notifyListeners (notification);
+}
+
+void ColourSelector::notifyListeners (juce::NotificationType notification)
+{
+    auto now = juce::Time::getMillisecondCounterHiRes();
+
+    // too soon after the last one, so hold it back and send the latest colour later,
+    // unless the caller asked for the listeners to be called before this returns
+    if (notification != juce::sendNotificationSync && now < lastNotificationTime + minNotificationInterval)
+    {
+        if (! std::exchange (notificationPending, true))
+            notificationTimer.startTimer (juce::jmax (1, juce::roundToInt (lastNotificationTime + minNotificationInterval - now)));
+
+        return;
+    }
+
+    lastNotificationTime = now;
+    notificationPending = false;
+    notificationTimer.stopTimer();
+
+    listeners.call ([this] (Listener& l) { l.colourChanged (this, colour); });
+    sendChangeMessage();
+
+    if (notification == juce::sendNotificationSync)
+        dispatchPendingMessages();
+}
+
+void ColourSelector::sendPendingNotification()
+{
+    if (notificationPending)
+    {
+        lastNotificationTime = 0.0;
+        notifyListeners (juce::sendNotification);
+    }
+}
+
+void ColourSelector::setMaximumNotificationRate (double notificationsPerSecond)
+{
+    jassert (notificationsPerSecond >= 0.0);
+
+    minNotificationInterval = notificationsPerSecond > 0.0 ? 1000.0 / notificationsPerSecond : 0.0;
+    sendPendingNotification();
+}
+
+void ColourSelector::beginGesture()
+{
+    // a drag that starts while the hex field still has focus is a separate undo step
+    endHexEdit();
+
+    if (gestureDepth++ == 0)
+    {
+        gestureHasHistoryEntry = false;
+        listeners.call ([this] (Listener& l) { l.colourGestureStarted (this); });
+    }
+}
+
+void ColourSelector::endGesture()
+{
+    jassert (gestureDepth > 0);
+
+    if (gestureDepth > 0 && --gestureDepth == 0)
+    {
+        // the final colour of the gesture always goes out, and before the gesture ends
+        sendPendingNotification();
+        listeners.call ([this] (Listener& l) { l.colourGestureEnded (this); });
+    }
+}
+
+void ColourSelector::endHexEdit()
+{
+    if (std::exchange (hexEditInProgress, false))
+        endGesture();
+}
+
+//==============================================================================
+void ColourSelector::recordHistory()
+{
+    History::State state { colour, getActiveParam() };
+
+    // every state of a drag after the first replaces the one before it
+    if (gestureDepth > 0 && gestureHasHistoryEntry)
+    {
+        history->replaceCurrent (state);
+    }
+    else
+    {
+        history->push (state);
+        gestureHasHistoryEntry = gestureDepth > 0;
+    }
+}
+
+void ColourSelector::applyHistory (const DeepColour& newColour, Params activeParam)
+{
+    if (activeParam != getActiveParam())
+        setActiveParam (activeParam);
+
+    auto changed = getChangedChannels (colour, newColour);
+
+    colour = newColour;
+    update (juce::sendNotification, changed);
+}
+
+bool ColourSelector::undo()
+{
+    if (! history->canUndo())
+        return false;
+
+    auto& state = history->undo();
+    applyHistory (state.colour, state.activeParam);
+    return true;
+}
+
+bool ColourSelector::redo()
+{
+    if (! history->canRedo())
+        return false;
 
-    if ((flags & showReset) != 0)
-    {
-        resetButton = std::make_unique<juce::TextButton> ("reset");
-        resetButton->onClick = [this]
-        {
-            set (originalColour);
-        };
-        addAndMakeVisible (*resetButton);
-    }
+    auto& state = history->redo();
+    applyHistory (state.colour, state.activeParam);
+    return true;
+}
 
-    update (juce::dontSendNotification);
-    updateParameters();
+bool ColourSelector::canUndo() const noexcept
+{
+    return history->canUndo();
 }
 
-ColourSelector::~ColourSelector()
+bool ColourSelector::canRedo() const noexcept
 {
-    setLookAndFeel (nullptr);
-    dispatchPendingMessages();
-    swatchComponents.clear();
+    return history->canRedo();
 }
 
-//==============================================================================
-juce::Colour ColourSelector::getCurrentColour() const
+void ColourSelector::clearUndoHistory()
 {
-    return ((flags & showAlphaChannel) != 0) ? colour.getColour() : colour.getColour().withAlpha ((juce::uint8) 0xff);
+    history->reset ({ colour, getActiveParam() });
 }
 
-void ColourSelector::setCurrentColour (juce::Colour c, juce::NotificationType notification)
+void ColourSelector::setUndoHistorySize (int maxNumStates)
 {
-    if (DeepColour (c) != colour)
-    {
-        originalColour = c;
-        colour = ((flags & showAlphaChannel) != 0) ? c : c.withAlpha ((juce::uint8) 0xff);
-        update (notification);
-    }
+    history->setCapacity ((size_t) juce::jmax (1, maxNumStates));
 }
 
-void ColourSelector::setCurrentColour (DeepColour c, juce::NotificationType notification)
+void ColourSelector::publishSnapshot()
 {
-    if (c != colour)
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    auto hsb = colour.getHSB();
+    auto rgb = colour.getRGB();
+    const float values[] = { hsb.h, hsb.s, hsb.b, rgb.r, rgb.g, rgb.b, colour.getAlpha() };
+
+    auto sequence = snapshotSequence.load (std::memory_order_relaxed);
+    snapshotSequence.store (sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    for (size_t i = 0; i < snapshotValues.size(); ++i)
+        snapshotValues[i].store (values[i], std::memory_order_relaxed);
+
+    snapshotParam.store (int (getActiveParam()), std::memory_order_relaxed);
+    snapshotSequence.store (sequence + 2, std::memory_order_release);
+}
+
+ColourSelector::Snapshot ColourSelector::getSnapshot() const noexcept
+{
+    for (;;)
     {
-        originalColour = c;
-        colour = ((flags & showAlphaChannel) != 0) ? c : c.withAlpha (1.0f);
-        update (notification);
+        auto sequence = snapshotSequence.load (std::memory_order_acquire);
+
+        if ((sequence & 1) != 0)
+            continue;
+
+        float values[7];
+
+        for (size_t i = 0; i < snapshotValues.size(); ++i)
+            values[i] = snapshotValues[i].load (std::memory_order_relaxed);
+
+        auto param = (Params) snapshotParam.load (std::memory_order_relaxed);
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        if (snapshotSequence.load (std::memory_order_relaxed) == sequence)
+            return { DeepColour (HSB (values[0], values[1], values[2]), RGB (values[3], values[4], values[5]), values[6]),
+                     param,
+                     sequence / 2 };
     }
 }
 
-void ColourSelector::set (const DeepColour& newColour)
+void ColourSelector::updatePendingViews()
 {
-    colour = newColour;
-    update (juce::sendNotification);
+    if (pendingChannels != 0)
+        updateViews (std::exchange (pendingChannels, 0));
 }
 
-//==============================================================================
-void ColourSelector::update (juce::NotificationType notification)
+void ColourSelector::updateViews (ChannelMask changed)
 {
-    if (hueSlider)
+    if (hueSlider && (changed & hsbChannels) != 0)
     {
-        hueSlider->setValue (colour.getHue() * 360,                 juce::dontSendNotification);
-        saturationSlider->setValue (colour.getSaturation() * 100,   juce::dontSendNotification);
-        brightnessSlider->setValue (colour.getBrightness() * 100,   juce::dontSendNotification);
+        auto hsb = colour.getHSB();
+
+        hueSlider->setValue (hsb.h * 360,           juce::dontSendNotification);
+        saturationSlider->setValue (hsb.s * 100,    juce::dontSendNotification);
+        brightnessSlider->setValue (hsb.b * 100,    juce::dontSendNotification);
     }
 
-    if (redSlider)
+    if (redSlider && (changed & rgbChannels) != 0)
     {
-        redSlider->setValue (colour.getRed() * 255,     juce::dontSendNotification);
-        greenSlider->setValue (colour.getGreen() * 255, juce::dontSendNotification);
-        blueSlider->setValue (colour.getBlue() * 255,   juce::dontSendNotification);
+        auto rgb = colour.getRGB();
+
+        redSlider->setValue (rgb.r * 255,   juce::dontSendNotification);
+        greenSlider->setValue (rgb.g * 255, juce::dontSendNotification);
+        blueSlider->setValue (rgb.b * 255,  juce::dontSendNotification);
     }
 
-    if (alphaSlider)
+    if (alphaSlider && (changed & alphaChannel) != 0)
         alphaSlider->setValue (colour.getAlpha() * 255, juce::dontSendNotification);
 
-    if (hex && ! hex->hasKeyboardFocus (true))
-        hex->setText (colour.getColour().toDisplayString ((flags & showAlphaChannel) != 0), juce::dontSendNotification);
+    for (auto* slider : sliders)
+        slider->channelsChanged (changed);
+
+    const auto visibleChannels = rgbChannels | alphaChannel;
+
+    if (hex && ! hex->hasKeyboardFocus (true) && (changed & visibleChannels) != 0)
+    {
+        ColourText::Buffer buffer;
+        auto text = ColourText::format (colour, ColourText::Format::hex, (flags & showAlphaChannel) != 0, buffer);
+        hex->setText (juce::String::fromUTF8 (text.data(), (int) text.size()), juce::dontSendNotification);
+    }
 
     if (parameter2D != nullptr)
     {
-        parameter2D->updateIfNeeded();
-        parameter1D->updateIfNeeded();
+        parameter2D->channelsChanged (changed);
+        parameter1D->channelsChanged (changed);
     }
 
-    if (originalColourComponent != nullptr)
+    if (polarView != nullptr)
+        polarView->channelsChanged (changed);
+
+    if (originalColourComponent != nullptr && (changed & visibleChannels) != 0)
         originalColourComponent->repaint();
 
-    if (previewComponent != nullptr)
+    if (previewComponent != nullptr && (changed & visibleChannels) != 0)
         previewComponent->updateIfNeeded();
-
-    if (notification != juce::dontSendNotification)
-        sendChangeMessage();
-
-    if (notification == juce::sendNotificationSync)
-        dispatchPendingMessages();
 }
 
 //==============================================================================
@@ -844,13 +1939,20 @@ void ColourSelector::paint (juce::Graphics& g)
 
 void ColourSelector::resized()
 {
-    const int swatchesPerRow = 8;
-    const int swatchHeight = 22;
+    // a lightweight selector lays its components out once they exist
+    if (! componentsCreated)
+        return;
+
+    const int swatchesPerRow = SwatchGrid::swatchesPerRow;
+    const int swatchHeight = SwatchGrid::swatchHeight;
+    const int maxVisibleSwatchRows = 4;
 
     const float numSliders = sliders.size() + (hueSlider && redSlider ? 0.5f : 0.0f) + (alphaSlider ? 0.5f : 0.0f) + (hex ? 1.0f : 0.0f);
     const int numSwatches = getNumSwatches();
 
-    const int swatchSpace = numSwatches > 0 ? edgeGap + swatchHeight * ((numSwatches + 7) / swatchesPerRow) : 0;
+    const int numSwatchRows = (numSwatches + swatchesPerRow - 1) / swatchesPerRow;
+    const int visibleSwatchRows = juce::jmin (numSwatchRows, maxVisibleSwatchRows);
+    const int swatchSpace = numSwatches > 0 ? edgeGap + swatchHeight * visibleSwatchRows : 0;
     const int sliderSpace = ((flags & showRGBSliders) != 0)  ? juce::jmin (int (22 * numSliders + edgeGap), proportionOfHeight (0.3f)) : 0;
     const int topSpace = ((flags & showColourAtTop) != 0) ? juce::jmin (30 + edgeGap * 2, proportionOfHeight (0.2f)) : edgeGap;
 
@@ -871,6 +1973,11 @@ void ColourSelector::resized()
                                 getWidth() - edgeGap - (parameter2D->getRight() + 4),
                                 parameter2D->getHeight());
 
+        // the wheel keeps its brightness strip, the triangle takes the strip's place too
+        if (polarView != nullptr)
+            polarView->setBounds (planeShape == PlaneShape::triangle ? parameter2D->getBounds().getUnion (parameter1D->getBounds())
+                                                                     : parameter2D->getBounds());
+
         y = getHeight() - sliderSpace - swatchSpace - edgeGap;
     }
 
@@ -919,44 +2026,28 @@ void ColourSelector::resized()
     if (numSwatches > 0)
     {
         const int startX = 8;
-        const int xGap = 4;
-        const int yGap = 4;
-        const int swatchWidth = (getWidth() - startX * 2) / swatchesPerRow;
         y += edgeGap;
 
-        if (swatchComponents.size() != numSwatches)
+        if (swatchGrid == nullptr)
         {
-            swatchComponents.clear();
-
-            for (int i = 0; i < numSwatches; ++i)
-            {
-                auto* sc = new SwatchComponent (*this, i);
-                swatchComponents.add (sc);
-                addAndMakeVisible (sc);
-            }
+            swatchGrid = std::make_unique<SwatchGrid> (*this);
+            swatchViewport = std::make_unique<juce::Viewport>();
+            swatchViewport->setViewedComponent (swatchGrid.get(), false);
+            swatchViewport->setScrollBarsShown (true, false);
+            addAndMakeVisible (*swatchViewport);
         }
 
-        int x = startX;
-
-        for (int i = 0; i < swatchComponents.size(); ++i)
-        {
-            auto* sc = swatchComponents.getUnchecked(i);
+        swatchViewport->setBounds (startX, y, getWidth() - startX * 2, swatchHeight * visibleSwatchRows);
 
-            sc->setBounds (x + xGap / 2,
-                           y + yGap / 2,
-                           swatchWidth - xGap,
-                           swatchHeight - yGap);
+        auto gridWidth = swatchViewport->getWidth() - (numSwatchRows > visibleSwatchRows ? swatchViewport->getScrollBarThickness() : 0);
 
-            if (((i + 1) % swatchesPerRow) == 0)
-            {
-                x = startX;
-                y += swatchHeight;
-            }
-            else
-            {
-                x += swatchWidth;
-            }
-        }
+        swatchGrid->setNumSwatches (numSwatches);
+        swatchGrid->setSize (gridWidth, swatchHeight * numSwatchRows);
+    }
+    else if (swatchGrid != nullptr)
+    {
+        swatchViewport = nullptr;
+        swatchGrid = nullptr;
     }
 }
 
@@ -965,28 +2056,87 @@ void ColourSelector::changeColour (juce::Slider* slider)
     if (sliders[0] == nullptr)
         return;
 
+    // Start from the current colour rather than reading every slider, because with
+    // coalesceUpdates the other sliders may not have caught up with it yet.
+    auto value = float (slider->getValue());
+
     if (hueSlider == slider || saturationSlider == slider || brightnessSlider == slider)
     {
-        auto col = DeepColour::fromHSB (float (hueSlider->getValue() / 360.0),
-                                        float (saturationSlider->getValue() / 100.0),
-                                        float (brightnessSlider->getValue() / 100.0),
-                                        float (alphaSlider ? alphaSlider->getValue() / 255.0 : 1.0));
+        auto hsb = colour.getHSB();
 
-        set (col);
+        if (slider == hueSlider)             hsb.h = value / 360.0f;
+        else if (slider == saturationSlider) hsb.s = value / 100.0f;
+        else                                 hsb.b = value / 100.0f;
+
+        set (DeepColour::fromHSB (hsb.h, hsb.s, hsb.b, colour.getAlpha()));
     }
-    else
+    else if (redSlider == slider || greenSlider == slider || blueSlider == slider)
     {
-        auto col = DeepColour::fromRGBA (float (redSlider->getValue() / 255.0),
-                                         float (greenSlider->getValue() / 255.0),
-                                         float (blueSlider->getValue() / 255.0),
-                                         float (alphaSlider ? alphaSlider->getValue() / 255.0 : 1.0));
+        auto rgb = colour.getRGB();
 
-        set (col);
+        if (slider == redSlider)             rgb.r = value / 255.0f;
+        else if (slider == greenSlider)      rgb.g = value / 255.0f;
+        else                                 rgb.b = value / 255.0f;
+
+        set (DeepColour::fromRGBA (rgb.r, rgb.g, rgb.b, colour.getAlpha()));
+    }
+    else if (alphaSlider == slider)
+    {
+        set (colour.withAlpha (value / 255.0f));
     }
 }
 
 void ColourSelector::updateParameters()
 {
+    publishSnapshot();
+
+    auto isPolar = planeShape != PlaneShape::square && colourModel == nullptr;
+
+    for (auto* toggle : toggles)
+        toggle->setEnabled (colourModel == nullptr && ! isPolar);
+
+    if (parameter2D == nullptr)
+        return;
+
+    if (isPolar && polarView == nullptr)
+    {
+        polarView = std::make_unique<PolarView> (*this, colourspaceGap);
+        addChildComponent (*polarView);
+        resized();
+    }
+
+    if (polarView != nullptr)
+    {
+        polarView->setShape (planeShape);
+        polarView->setVisible (isPolar);
+    }
+
+    parameter2D->setVisible (! isPolar);
+    parameter1D->setVisible (! isPolar || planeShape == PlaneShape::wheel);
+
+    if (isPolar)
+    {
+        if (planeShape == PlaneShape::wheel)
+            parameter1D->setParameter (Params::brightness);
+
+        return;
+    }
+
+    if (colourModel != nullptr)
+    {
+        // the strip channel's two partners go on the plane, with lightness upwards
+        // and hue across wherever they're available
+        auto x = juce::jmin ((activeModelChannel + 1) % 3, (activeModelChannel + 2) % 3);
+        auto y = 3 - activeModelChannel - x;
+
+        if (x == colourModel->getLightnessChannel() || y == colourModel->getHueChannel())
+            std::swap (x, y);
+
+        parameter1D->setModelChannel (activeModelChannel);
+        parameter2D->setModelChannels (x, y);
+        return;
+    }
+
     auto state = getActiveParam();
 
     if (state == Params::hue)
@@ -1023,35 +2173,300 @@ void ColourSelector::updateParameters()
 
 ColourSelector::Params ColourSelector::getActiveParam ()
 {
-    for (auto t : toggles)
-        if (t->getToggleState())
-            return (Params) t->getName().getIntValue();
-
-    return Params::hue;
+    return selectedParam;
 }
 
 void ColourSelector::setActiveParam ( Params p )
 {
+    selectedParam = p;
+
     for (auto t : toggles)
         t->setToggleState ((Params) t->getName().getIntValue() == p, juce::dontSendNotification);
 
     updateParameters();
 }
 
+void ColourSelector::setColourModel (const ColourModel* newModel)
+{
+    if (colourModel != newModel)
+    {
+        colourModel = newModel;
+        updateModelValues();
+        updateParameters();
+    }
+}
+
+void ColourSelector::setPlaneShape (PlaneShape newShape)
+{
+    if (planeShape != newShape)
+    {
+        planeShape = newShape;
+        updateParameters();
+        resized();
+    }
+}
+
+void ColourSelector::setActiveModelChannel (int channel)
+{
+    jassert (juce::isPositiveAndBelow (channel, 3));
+
+    activeModelChannel = juce::jlimit (0, 2, channel);
+    updateParameters();
+}
+
+//==============================================================================
+class ColourSelector::Eyedropper  : private juce::MouseListener
+{
+public:
+    explicit Eyedropper (ColourSelector& cs)  : owner (cs) {}
+
+    ~Eyedropper() override
+    {
+        setSource (nullptr);
+    }
+
+    void setSource (juce::Component* newSource)
+    {
+        if (source != nullptr)
+            source->removeMouseListener (this);
+
+        source = newSource;
+        scale = 1.0f;
+
+        if (source != nullptr)
+        {
+            // captured at the scale the component is shown at, so that the pixels
+            // match what the user sees
+            scale = juce::Component::getApproximateScaleFactorForComponent (source);
+            sampler.setImage (source->createComponentSnapshot (source->getLocalBounds(), true, scale));
+            source->addMouseListener (this, true);
+        }
+    }
+
+    void setImage (const juce::Image& image)
+    {
+        setSource (nullptr);
+        sampler.setImage (image);
+    }
+
+    const ImageSampler& getSampler() const noexcept     { return sampler; }
+
+private:
+    ColourSelector& owner;
+    juce::Component::SafePointer<juce::Component> source;
+    ImageSampler sampler;
+    float scale = 1.0f;
+
+    void mouseDown (const juce::MouseEvent& e) override
+    {
+        owner.beginGesture();
+        mouseDrag (e);
+    }
+
+    void mouseDrag (const juce::MouseEvent& e) override
+    {
+        if (auto* c = source.getComponent())
+            owner.pickColour ((e.getEventRelativeTo (c).position * scale).toInt());
+    }
+
+    void mouseUp (const juce::MouseEvent&) override
+    {
+        owner.endGesture();
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (Eyedropper)
+};
+
+void ColourSelector::setEyedropperSource (juce::Component* source)
+{
+    if (source == nullptr)
+    {
+        eyedropper = nullptr;
+        return;
+    }
+
+    if (eyedropper == nullptr)
+        eyedropper = std::make_unique<Eyedropper> (*this);
+
+    eyedropper->setSource (source);
+}
+
+void ColourSelector::setEyedropperImage (const juce::Image& image)
+{
+    if (image.isNull())
+    {
+        eyedropper = nullptr;
+        return;
+    }
+
+    if (eyedropper == nullptr)
+        eyedropper = std::make_unique<Eyedropper> (*this);
+
+    eyedropper->setImage (image);
+}
+
+bool ColourSelector::pickColour (juce::Point<int> pixel)
+{
+    if (eyedropper == nullptr)
+        return false;
+
+    auto picked = eyedropper->getSampler().getAverage (pixel, int (sampleSize));
+
+    if (! picked.has_value())
+        return false;
+
+    if ((flags & showAlphaChannel) == 0)
+        picked = picked->withAlpha (1.0f);
+
+    if (*picked != colour)
+        set (*picked);
+
+    return true;
+}
+
 //==============================================================================
+void ColourSelector::setSwatchPalette (SwatchPalette* newPalette)
+{
+    if (swatchPalette == newPalette)
+        return;
+
+    if (swatchPalette != nullptr)
+        swatchPalette->removeListener (this);
+
+    swatchPalette = newPalette;
+
+    if (swatchPalette != nullptr)
+        swatchPalette->addListener (this);
+
+    // the new swatches may have the same count as the old ones, so the index can't
+    // tell by its size that it's out of date
+    swatchIndexIsValid = false;
+
+    resized();
+    repaint();
+}
+
+void ColourSelector::paletteChanged (SwatchPalette& palette, juce::Range<int> changedRange)
+{
+    // a change in size moves the layout, otherwise only the rows that changed need repainting
+    if (swatchGrid == nullptr || swatchGrid->getNumSwatches() != palette.size())
+    {
+        swatchIndexIsValid = false;
+        resized();
+    }
+    else
+    {
+        if (changedRange.getLength() == 1)
+            swatchColourChanged (changedRange.getStart());
+        else
+            swatchIndexIsValid = false;
+
+        swatchGrid->repaintSwatches (changedRange);
+    }
+}
+
+void ColourSelector::swatchesChanged()
+{
+    swatchIndexIsValid = false;
+    resized();
+
+    if (swatchGrid != nullptr)
+        swatchGrid->repaint();
+}
+
+void ColourSelector::generateSwatches (const juce::Image& image)
+{
+    if (swatchExtractor == nullptr)
+    {
+        swatchExtractor = std::make_unique<PaletteExtractor>();
+
+        swatchExtractor->onColoursReady = [this] (const std::vector<juce::Colour>& colours)
+        {
+            // a palette hears about all the new colours at once
+            std::optional<SwatchPalette::ScopedBatch> batch;
+
+            if (swatchPalette != nullptr)
+                batch.emplace (*swatchPalette);
+
+            const int numColours = juce::jmin ((int) colours.size(), getNumSwatches());
+
+            for (int i = 0; i < numColours; ++i)
+                setSwatchColour (i, colours[size_t (i)]);
+
+            if (swatchPalette == nullptr)
+                swatchesChanged();
+        };
+    }
+
+    swatchExtractor->extract (image, getNumSwatches());
+}
+
+void ColourSelector::cancelSwatchGeneration()
+{
+    if (swatchExtractor != nullptr)
+        swatchExtractor->cancel();
+}
+
+void ColourSelector::swatchColourChanged (int index)
+{
+    // a single edit moves one entry of the index rather than rebuilding it
+    if (swatchIndexIsValid && juce::isPositiveAndBelow (index, swatchIndex.size()))
+        swatchIndex.update (index, getSwatchColour (index));
+}
+
+DeepColour ColourSelector::getSnappedColour (const DeepColour& c)
+{
+    if (! snapToSwatches)
+        return c;
+
+    const int numSwatches = getNumSwatches();
+
+    if (! swatchIndexIsValid || swatchIndex.size() != numSwatches)
+    {
+        if (swatchPalette != nullptr)
+        {
+            swatchIndex.build (swatchPalette->getColours());
+        }
+        else
+        {
+            std::vector<juce::uint32> colours ((size_t) numSwatches);
+
+            for (int i = 0; i < numSwatches; ++i)
+                colours[size_t (i)] = getSwatchColour (i).getARGB();
+
+            swatchIndex.build (colours);
+        }
+
+        swatchIndexIsValid = true;
+    }
+
+    auto index = swatchIndex.findNearest (c);
+
+    return index >= 0 ? DeepColour (getSwatchColour (index)).withAlpha (c.getAlpha()) : c;
+}
+
 int ColourSelector::getNumSwatches() const
 {
-    return 0;
+    return swatchPalette != nullptr ? swatchPalette->size() : 0;
 }
 
-juce::Colour ColourSelector::getSwatchColour (int) const
+juce::Colour ColourSelector::getSwatchColour (int index) const
 {
+    if (swatchPalette != nullptr)
+        return swatchPalette->getColour (index);
+
     jassertfalse; // if you've overridden getNumSwatches(), you also need to implement this method
     return juce::Colours::black;
 }
 
-void ColourSelector::setSwatchColour (int, const juce::Colour&)
+void ColourSelector::setSwatchColour (int index, const juce::Colour& newColour)
 {
+    if (swatchPalette != nullptr)
+    {
+        swatchPalette->setColour (index, newColour);
+        return;
+    }
+
     jassertfalse; // if you've overridden getNumSwatches(), you also need to implement this method
 }
 
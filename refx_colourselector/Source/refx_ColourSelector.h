@@ -15,7 +15,8 @@ namespace reFX
     @tags{GUI}
 */
 class ColourSelector : public juce::Component,
-                       public juce::ChangeBroadcaster
+                       public juce::ChangeBroadcaster,
+                       private SwatchPalette::Listener
 {
 public:
     //==============================================================================
@@ -33,6 +34,8 @@ public:
         showOriginalColour  = 1 << 7,           /**< if set, show a swatch with original colour and current. */
         showColourspace     = 1 << 8,           /**< if set, a big HSV selector is shown. */
         showHexEdit         = 1 << 9,           /**< if set, a TextEditor with the colour in hex is shown **/
+        coalesceUpdates     = 1 << 10,          /**< if set, the sliders and other views follow colour changes at most once per display frame. */
+        lightweight         = 1 << 11,          /**< if set, the child components are only created when the selector is first shown, and its cached images are released while it's hidden. */
     };
 
     //==============================================================================
@@ -95,11 +98,256 @@ public:
     void setActiveParam ( Params );
 
     //==============================================================================
+    /**
+        Receives notifications about the colour of a ColourSelector, as an alternative
+        to listening to it as a ChangeBroadcaster.
+
+        Callbacks are made on the message thread, synchronously when the colour
+        changes.
+    */
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        /** Called when the colour changes.
+
+            With a maximum notification rate set, colours that change faster than that
+            are skipped, but the last colour of a gesture is always delivered before
+            colourGestureEnded().
+        */
+        virtual void colourChanged (ColourSelector* selector, const DeepColour& newColour) = 0;
+
+        /** Called when the user starts dragging the colourspace, the strip or a slider. */
+        virtual void colourGestureStarted (ColourSelector*)  {}
+
+        /** Called when the user stops dragging, after the final colour has been sent. */
+        virtual void colourGestureEnded (ColourSelector*)    {}
+    };
+
+    /** Registers a listener to be told about colour changes and gestures. */
+    void addListener (Listener* listener)           { listeners.add (listener); }
+
+    /** Removes a listener that was previously added with addListener(). */
+    void removeListener (Listener* listener)        { listeners.remove (listener); }
+
+    /** Limits how often listeners and change listeners are told about colour changes.
+
+        Changes that come faster than this are held back and merged into one
+        notification for the latest colour, sent once the interval has passed or when
+        the gesture ends, whichever comes first. Pass 0 to notify on every change,
+        which is the default.
+
+        A change made with juce::sendNotificationSync is never held back: its
+        listeners are always called before setCurrentColour() returns.
+    */
+    void setMaximumNotificationRate (double notificationsPerSecond);
+
+    /** Returns true while the user is dragging one of the controls. */
+    bool isGestureInProgress() const noexcept       { return gestureDepth > 0; }
+
+    //==============================================================================
+    /** Goes back to the colour and active parameter before the last edit.
+
+        Every edit the user makes is recorded, with a whole drag of the colourspace,
+        the strip or a slider counting as a single edit, and so does everything typed
+        into the hex field before return is pressed or it loses focus. Colours set with
+        setCurrentColour() aren't edits: they replace the current state of the
+        history instead of adding one.
+
+        @returns false if there was nothing to undo
+    */
+    bool undo();
+
+    /** Reapplies an edit that was undone.
+
+        @returns false if there was nothing to redo
+    */
+    bool redo();
+
+    /** Returns true if there is an edit to undo. */
+    bool canUndo() const noexcept;
+
+    /** Returns true if there is an undone edit to redo. */
+    bool canRedo() const noexcept;
+
+    /** Forgets all edits, keeping only the current state. */
+    void clearUndoHistory();
+
+    /** Sets how many states the history keeps, including the current one. The oldest
+        states are dropped once it is full. The default is 100.
+    */
+    void setUndoHistorySize (int maxNumStates);
+
+    //==============================================================================
+    /** The colour and active parameter of a selector at one moment. */
+    struct Snapshot
+    {
+        DeepColour colour;
+        Params activeParam = Params::hue;
+
+        /** Goes up whenever the colour or the active parameter changes, so that a
+            poller can tell whether anything is new since its last look.
+        */
+        juce::uint32 version = 0;
+    };
+
+    /** Returns the current colour and active parameter.
+
+        Unlike getCurrentColour(), this may be called from any thread, for example an
+        audio or render thread driving a visualiser. It never locks, allocates or waits
+        for the message thread: the selector publishes every change through a sequence
+        lock, and a reader that overlaps a change simply reads again, so it always gets
+        a colour and parameter that belong together.
+    */
+    Snapshot getSnapshot() const noexcept;
+
+    //==============================================================================
+    /** Shows the colourspace in a different colour model.
+
+        The strip then shows the channel chosen with setActiveModelChannel() and the
+        plane the other two, with the parts that sRGB can't show drawn in the
+        background colour. Passing nullptr goes back to the HSB and RGB layouts
+        chosen with setActiveParam().
+
+        The model must outlive the selector, which the built-in models returned by
+        ColourModel::getOKLCH() and the like always do.
+    */
+    void setColourModel (const ColourModel* newModel);
+
+    /** Returns the colour model set with setColourModel(), or nullptr. */
+    const ColourModel* getColourModel() const noexcept    { return colourModel; }
+
+    /** Chooses the channel of the colour model that the strip shows. */
+    void setActiveModelChannel (int channel);
+
+    /** Returns the channel of the colour model that the strip shows. */
+    int getActiveModelChannel() const noexcept           { return activeModelChannel; }
+
+    //==============================================================================
+    /** The shapes that the colourspace can be shown in. */
+    enum class PlaneShape
+    {
+        square,     /**< a plane of two channels beside a strip of the third, chosen with setActiveParam() */
+        wheel,      /**< hue round a circle and saturation outwards from its centre, beside a brightness strip */
+        triangle    /**< a hue ring around a triangle of saturation and brightness */
+    };
+
+    /** Chooses the shape of the colourspace.
+
+        The wheel and the triangle always show hue, saturation and brightness, so
+        while a colour model is set the square plane is shown instead.
+    */
+    void setPlaneShape (PlaneShape newShape);
+
+    /** Returns the shape chosen with setPlaneShape(). */
+    PlaneShape getPlaneShape() const noexcept            { return planeShape; }
+
+    /** Waits for the full-resolution plane that is being rendered in the background,
+        if there is one, so that the next paint shows it rather than the coarse plane.
+
+        On screen the plane arrives by itself a moment after the first paint. This is
+        for painting a selector offscreen, for example in tests, where there's no
+        message loop to deliver it. Call it on the message thread.
+    */
+    void finishBackgroundRendering();
+
+    //==============================================================================
+    /** The squares of pixels that the eyedropper can average. */
+    enum class SampleSize
+    {
+        point           = 1,    /**< the single pixel under the mouse */
+        average3x3      = 3,
+        average5x5      = 5,
+        average11x11    = 11
+    };
+
+    /** Lets the user pick colours by clicking or dragging on another component.
+
+        The component is captured into an image when it's set, at the scale it's
+        shown at, so set it again if its contents change. A drag makes a single
+        undo step. The component still receives its own mouse events. Passing
+        nullptr turns the eyedropper off.
+    */
+    void setEyedropperSource (juce::Component* source);
+
+    /** Picks colours from an image with pickColour() instead of from a component. */
+    void setEyedropperImage (const juce::Image& image);
+
+    /** Chooses how many pixels around the mouse the eyedropper averages. */
+    void setEyedropperSampleSize (SampleSize newSize)   { sampleSize = newSize; }
+
+    /** Returns the size chosen with setEyedropperSampleSize(). */
+    SampleSize getEyedropperSampleSize() const noexcept { return sampleSize; }
+
+    /** Picks the average colour of the square around a pixel of the eyedropper's image.
+
+        The square is clipped to the image, and the alpha of the result is kept only
+        when the selector shows an alpha channel.
+
+        @returns false if there's no image, or the pixel is outside it
+    */
+    bool pickColour (juce::Point<int> pixel);
+
+    //==============================================================================
+    /** Shows the colours of a palette as the swatches.
+
+        This is the simplest way to enable swatches: the selector shows the palette's
+        colours, stores colours the user puts into a swatch back into the palette, and
+        follows any changes made to the palette elsewhere. Passing nullptr goes back to
+        the swatches provided by getNumSwatches() and friends.
+
+        The palette must outlive the selector, or be removed from it first.
+    */
+    void setSwatchPalette (SwatchPalette* newPalette);
+
+    /** Returns the palette set with setSwatchPalette(), or nullptr. */
+    SwatchPalette* getSwatchPalette() const noexcept        { return swatchPalette; }
+
+    /** Makes dragging in the colourspace snap to the closest swatch colour.
+
+        The closest swatch is the one nearest in OKLab, found with a NearestColourIndex
+        over the swatches, so snapping stays fast with large palettes. The alpha of the
+        current colour is kept.
+    */
+    void setSnapToSwatches (bool shouldSnap)                { snapToSwatches = shouldSnap; }
+
+    /** Returns true if dragging in the colourspace snaps to the swatch colours. */
+    bool isSnappingToSwatches() const noexcept              { return snapToSwatches; }
+
+    /** Subclasses that provide their own swatches must call this when the swatch
+        colours change other than through setSwatchColour(), so that the swatches are
+        redrawn and snapping sees the new colours.
+    */
+    void swatchesChanged();
+
+    /** Fills the swatches with the dominant colours of an image, most common first.
+
+        The colours are found in the background by a PaletteExtractor and stored with
+        setSwatchColour(), so this works both with a palette and with swatches provided
+        by a subclass. If the image has fewer distinct colours than there are swatches,
+        the remaining swatches are left as they are. Calling this again abandons the
+        image that was being analysed.
+    */
+    void generateSwatches (const juce::Image& image);
+
+    /** Abandons the image passed to generateSwatches(), if it's still being analysed. */
+    void cancelSwatchGeneration();
+
+    /** Returns true while the image passed to generateSwatches() is being analysed. */
+    bool isGeneratingSwatches() const noexcept              { return swatchExtractor != nullptr && swatchExtractor->isExtracting(); }
+
+    /** Returns how far the analysis of the image passed to generateSwatches() has got,
+        from 0.0 to 1.0.
+    */
+    float getSwatchGenerationProgress() const noexcept      { return swatchExtractor != nullptr ? swatchExtractor->getProgress() : 0.0f; }
+
     /** Tells the selector how many preset colour swatches you want to have on the component.
 
         To enable swatches, you'll need to override getNumSwatches(), getSwatchColour(), and
         setSwatchColour(), to return the number of colours you want, and to set and retrieve
-        their values.
+        their values, or call setSwatchPalette(). By default this returns the size of the
+        palette, if there is one.
     */
     virtual int getNumSwatches() const;
 
@@ -142,27 +390,56 @@ public:
 
 private:
     //==============================================================================
-    class SwatchComponent;
+    class SwatchGrid;
     class Parameter2D;
     class Parameter1D;
+    class PolarView;
     class ColourPreviewComp;
     class OriginalColourComp;
+    class ColourComponentSlider;
+    class History;
+    class VisibilityWatcher;
+    class Eyedropper;
+
+    /** A set of bits, one per Params value plus one for alpha and one for each
+        channel of the colour model, naming the channels of the colour that a
+        view depends on or that an edit changed.
+    */
+    using ChannelMask = int;
+
+    static constexpr ChannelMask hsbChannels   = (1 << int (Params::hue)) | (1 << int (Params::saturation)) | (1 << int (Params::brightness));
+    static constexpr ChannelMask rgbChannels   = (1 << int (Params::red)) | (1 << int (Params::green)) | (1 << int (Params::blue));
+    static constexpr ChannelMask alphaChannel  = 1 << 6;
+    static constexpr ChannelMask modelChannels = 7 << 7;
+    static constexpr ChannelMask allChannels   = hsbChannels | rgbChannels | alphaChannel | modelChannels;
+
+    static ChannelMask getChannelMask (Params p)        { return 1 << int (p); }
+    static ChannelMask getModelChannelMask (int c)      { return 1 << (7 + c); }
+    static ChannelMask getChangedChannels (const DeepColour& oldColour, const DeepColour& newColour);
+    static std::array<float, 6> getChannelValues (const DeepColour&, ChannelMask);
 
-    ColourSelectorLF lf;
+    juce::SharedResourcePointer<ColourSelectorLF> lf;
     DeepColour colour;
     DeepColour originalColour;
 
     juce::OwnedArray<juce::ToggleButton> toggles;
-    juce::OwnedArray<juce::Slider> sliders;
+    juce::OwnedArray<ColourComponentSlider> sliders;
     std::unique_ptr<Parameter2D> parameter2D;
     std::unique_ptr<Parameter1D> parameter1D;
+    std::unique_ptr<PolarView> polarView;
+    PlaneShape planeShape = PlaneShape::square;
     std::unique_ptr<juce::TextEditor> hex;
     std::unique_ptr<ColourPreviewComp> previewComponent;
     std::unique_ptr<OriginalColourComp> originalColourComponent;
     std::unique_ptr<juce::TextButton> resetButton;
-    juce::OwnedArray<SwatchComponent> swatchComponents;
+    std::unique_ptr<SwatchGrid> swatchGrid;
+    std::unique_ptr<juce::Viewport> swatchViewport;
     const int flags;
     int edgeGap;
+    const int colourspaceGap;
+    Params selectedParam = Params::hue;
+    bool componentsCreated = false;
+    std::unique_ptr<VisibilityWatcher> visibilityWatcher;
 
     juce::Slider* redSlider = nullptr;
     juce::Slider* greenSlider = nullptr;
@@ -172,13 +449,65 @@ private:
     juce::Slider* brightnessSlider = nullptr;
     juce::Slider* alphaSlider = nullptr;
 
+    ChannelMask pendingChannels = 0;
+    juce::VBlankAttachment vBlankAttachment;
+
+    const ColourModel* colourModel = nullptr;
+    int activeModelChannel = 0;
+    ColourModel::Values modelValues {};
+    bool keepModelValues = false;
+
+    SwatchPalette* swatchPalette = nullptr;
+    // the snapshot, written only on the message thread; an odd sequence number means
+    // a write is in progress
+    std::atomic<juce::uint32> snapshotSequence { 0 };
+    std::array<std::atomic<float>, 7> snapshotValues {};
+    std::atomic<int> snapshotParam { int (Params::hue) };
+
+    juce::ListenerList<Listener> listeners;
+    double minNotificationInterval = 0.0;
+    double lastNotificationTime = 0.0;
+    bool notificationPending = false;
+    juce::TimedCallback notificationTimer;
+    int gestureDepth = 0;
+
+    std::unique_ptr<History> history;
+    bool gestureHasHistoryEntry = false;
+    bool hexEditInProgress = false;
+
+    NearestColourIndex swatchIndex;
+    bool swatchIndexIsValid = false;
+    bool snapToSwatches = false;
+    std::unique_ptr<PaletteExtractor> swatchExtractor;
+
+    std::unique_ptr<Eyedropper> eyedropper;
+    SampleSize sampleSize = SampleSize::point;
+
+    void createComponents();
+    void showingChanged();
+    void releaseImages();
     void updateParameters();
-    void update (juce::NotificationType);
+    void update (juce::NotificationType, ChannelMask changedChannels = allChannels);
+    void updateViews (ChannelMask changedChannels);
+    void updatePendingViews();
+    void publishSnapshot();
+    void notifyListeners (juce::NotificationType);
+    void sendPendingNotification();
+    void beginGesture();
+    void endGesture();
+    void endHexEdit();
+    void recordHistory();
+    void applyHistory (const DeepColour&, Params);
     void changeColour (juce::Slider*);
     void paint (juce::Graphics&) override;
     void resized() override;
 
     void set (const DeepColour&);
+    void setFromModel (const ColourModel::Values&);
+    ChannelMask updateModelValues();
+    void paletteChanged (SwatchPalette&, juce::Range<int>) override;
+    void swatchColourChanged (int index);
+    DeepColour getSnappedColour (const DeepColour&);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ColourSelector)
 };
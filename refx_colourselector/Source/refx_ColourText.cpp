@@ -0,0 +1,568 @@
+namespace reFX
+{
+
+namespace
+{
+
+//==============================================================================
+struct NamedColour
+{
+    std::string_view name;
+    juce::uint32 rgb;
+};
+
+/** The named colours of CSS Color Module Level 4. */
+constexpr NamedColour namedColours[] =
+{
+    { "aliceblue", 0xf0f8ff },              { "antiquewhite", 0xfaebd7 },           { "aqua", 0x00ffff },
+    { "aquamarine", 0x7fffd4 },             { "azure", 0xf0ffff },                  { "beige", 0xf5f5dc },
+    { "bisque", 0xffe4c4 },                 { "black", 0x000000 },                  { "blanchedalmond", 0xffebcd },
+    { "blue", 0x0000ff },                   { "blueviolet", 0x8a2be2 },             { "brown", 0xa52a2a },
+    { "burlywood", 0xdeb887 },              { "cadetblue", 0x5f9ea0 },              { "chartreuse", 0x7fff00 },
+    { "chocolate", 0xd2691e },              { "coral", 0xff7f50 },                  { "cornflowerblue", 0x6495ed },
+    { "cornsilk", 0xfff8dc },               { "crimson", 0xdc143c },                { "cyan", 0x00ffff },
+    { "darkblue", 0x00008b },               { "darkcyan", 0x008b8b },               { "darkgoldenrod", 0xb8860b },
+    { "darkgray", 0xa9a9a9 },               { "darkgreen", 0x006400 },              { "darkgrey", 0xa9a9a9 },
+    { "darkkhaki", 0xbdb76b },              { "darkmagenta", 0x8b008b },            { "darkolivegreen", 0x556b2f },
+    { "darkorange", 0xff8c00 },             { "darkorchid", 0x9932cc },             { "darkred", 0x8b0000 },
+    { "darksalmon", 0xe9967a },             { "darkseagreen", 0x8fbc8f },           { "darkslateblue", 0x483d8b },
+    { "darkslategray", 0x2f4f4f },          { "darkslategrey", 0x2f4f4f },          { "darkturquoise", 0x00ced1 },
+    { "darkviolet", 0x9400d3 },             { "deeppink", 0xff1493 },               { "deepskyblue", 0x00bfff },
+    { "dimgray", 0x696969 },                { "dimgrey", 0x696969 },                { "dodgerblue", 0x1e90ff },
+    { "firebrick", 0xb22222 },              { "floralwhite", 0xfffaf0 },            { "forestgreen", 0x228b22 },
+    { "fuchsia", 0xff00ff },                { "gainsboro", 0xdcdcdc },              { "ghostwhite", 0xf8f8ff },
+    { "gold", 0xffd700 },                   { "goldenrod", 0xdaa520 },              { "gray", 0x808080 },
+    { "green", 0x008000 },                  { "greenyellow", 0xadff2f },            { "grey", 0x808080 },
+    { "honeydew", 0xf0fff0 },               { "hotpink", 0xff69b4 },                { "indianred", 0xcd5c5c },
+    { "indigo", 0x4b0082 },                 { "ivory", 0xfffff0 },                  { "khaki", 0xf0e68c },
+    { "lavender", 0xe6e6fa },               { "lavenderblush", 0xfff0f5 },          { "lawngreen", 0x7cfc00 },
+    { "lemonchiffon", 0xfffacd },           { "lightblue", 0xadd8e6 },              { "lightcoral", 0xf08080 },
+    { "lightcyan", 0xe0ffff },              { "lightgoldenrodyellow", 0xfafad2 },   { "lightgray", 0xd3d3d3 },
+    { "lightgreen", 0x90ee90 },             { "lightgrey", 0xd3d3d3 },              { "lightpink", 0xffb6c1 },
+    { "lightsalmon", 0xffa07a },            { "lightseagreen", 0x20b2aa },          { "lightskyblue", 0x87cefa },
+    { "lightslategray", 0x778899 },         { "lightslategrey", 0x778899 },         { "lightsteelblue", 0xb0c4de },
+    { "lightyellow", 0xffffe0 },            { "lime", 0x00ff00 },                   { "limegreen", 0x32cd32 },
+    { "linen", 0xfaf0e6 },                  { "magenta", 0xff00ff },                { "maroon", 0x800000 },
+    { "mediumaquamarine", 0x66cdaa },       { "mediumblue", 0x0000cd },             { "mediumorchid", 0xba55d3 },
+    { "mediumpurple", 0x9370db },           { "mediumseagreen", 0x3cb371 },         { "mediumslateblue", 0x7b68ee },
+    { "mediumspringgreen", 0x00fa9a },      { "mediumturquoise", 0x48d1cc },        { "mediumvioletred", 0xc71585 },
+    { "midnightblue", 0x191970 },           { "mintcream", 0xf5fffa },              { "mistyrose", 0xffe4e1 },
+    { "moccasin", 0xffe4b5 },               { "navajowhite", 0xffdead },            { "navy", 0x000080 },
+    { "oldlace", 0xfdf5e6 },                { "olive", 0x808000 },                  { "olivedrab", 0x6b8e23 },
+    { "orange", 0xffa500 },                 { "orangered", 0xff4500 },              { "orchid", 0xda70d6 },
+    { "palegoldenrod", 0xeee8aa },          { "palegreen", 0x98fb98 },              { "paleturquoise", 0xafeeee },
+    { "palevioletred", 0xdb7093 },          { "papayawhip", 0xffefd5 },             { "peachpuff", 0xffdab9 },
+    { "peru", 0xcd853f },                   { "pink", 0xffc0cb },                   { "plum", 0xdda0dd },
+    { "powderblue", 0xb0e0e6 },             { "purple", 0x800080 },                 { "rebeccapurple", 0x663399 },
+    { "red", 0xff0000 },                    { "rosybrown", 0xbc8f8f },              { "royalblue", 0x4169e1 },
+    { "saddlebrown", 0x8b4513 },            { "salmon", 0xfa8072 },                 { "sandybrown", 0xf4a460 },
+    { "seagreen", 0x2e8b57 },               { "seashell", 0xfff5ee },               { "sienna", 0xa0522d },
+    { "silver", 0xc0c0c0 },                 { "skyblue", 0x87ceeb },                { "slateblue", 0x6a5acd },
+    { "slategray", 0x708090 },              { "slategrey", 0x708090 },              { "snow", 0xfffafa },
+    { "springgreen", 0x00ff7f },            { "steelblue", 0x4682b4 },              { "tan", 0xd2b48c },
+    { "teal", 0x008080 },                   { "thistle", 0xd8bfd8 },                { "tomato", 0xff6347 },
+    { "turquoise", 0x40e0d0 },              { "violet", 0xee82ee },                 { "wheat", 0xf5deb3 },
+    { "white", 0xffffff },                  { "whitesmoke", 0xf5f5f5 },             { "yellow", 0xffff00 },
+    { "yellowgreen", 0x9acd32 },
+};
+
+constexpr char toLower (char c) noexcept
+{
+    return (c >= 'A' && c <= 'Z') ? char (c - 'A' + 'a') : c;
+}
+
+constexpr bool equalsIgnoreCase (std::string_view a, std::string_view b) noexcept
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (size_t i = 0; i < a.size(); ++i)
+        if (toLower (a[i]) != toLower (b[i]))
+            return false;
+
+    return true;
+}
+
+//==============================================================================
+/** A perfect hash over the named colours, built at compile time with the hash and
+    displace method: names are split into buckets by one hash, and each bucket gets
+    a seed for a second hash that sends all its names to slots nobody else uses.
+    A lookup is then two hashes and a single string comparison.
+*/
+struct NamedColourTable
+{
+    static constexpr size_t numBuckets = 64;
+    static constexpr size_t numSlots = 256;
+
+    static constexpr juce::uint32 hash (std::string_view name, juce::uint32 seed) noexcept
+    {
+        auto h = 2166136261u ^ (seed * 0x9e3779b9u);
+
+        for (auto c : name)
+            h = (h ^ juce::uint8 (toLower (c))) * 16777619u;
+
+        return h ^ (h >> 15);
+    }
+
+    std::array<juce::uint16, numBuckets> seeds {};
+    std::array<juce::uint8, numSlots> slots {};     // index into namedColours + 1, or 0 if empty
+    bool isValid = true;
+
+    consteval NamedColourTable()
+    {
+        constexpr auto numNames = std::size (namedColours);
+        std::array<juce::uint8, numNames> bucketOf {};
+        std::array<size_t, numBuckets> bucketSizes {};
+
+        for (size_t i = 0; i < numNames; ++i)
+        {
+            bucketOf[i] = juce::uint8 (hash (namedColours[i].name, 0) % numBuckets);
+            ++bucketSizes[bucketOf[i]];
+        }
+
+        std::array<bool, numBuckets> done {};
+
+        // the fullest buckets first, while there are still plenty of free slots
+        for (size_t n = 0; n < numBuckets; ++n)
+        {
+            size_t bucket = 0;
+
+            for (size_t b = 0; b < numBuckets; ++b)
+                if (! done[b] && (done[bucket] || bucketSizes[b] > bucketSizes[bucket]))
+                    bucket = b;
+
+            done[bucket] = true;
+
+            if (bucketSizes[bucket] == 0)
+                continue;
+
+            bool placed = false;
+
+            for (juce::uint32 seed = 1; seed < 65536 && ! placed; ++seed)
+            {
+                std::array<bool, numSlots> taken {};
+                placed = true;
+
+                for (size_t i = 0; i < numNames && placed; ++i)
+                {
+                    if (bucketOf[i] != bucket)
+                        continue;
+
+                    auto slot = hash (namedColours[i].name, seed) % numSlots;
+
+                    if (slots[slot] != 0 || taken[slot])
+                        placed = false;
+                    else
+                        taken[slot] = true;
+                }
+
+                if (placed)
+                {
+                    seeds[bucket] = juce::uint16 (seed);
+
+                    for (size_t i = 0; i < numNames; ++i)
+                        if (bucketOf[i] == bucket)
+                            slots[hash (namedColours[i].name, seed) % numSlots] = juce::uint8 (i + 1);
+                }
+            }
+
+            isValid = isValid && placed;
+        }
+    }
+
+    const NamedColour* find (std::string_view name) const noexcept
+    {
+        auto seed = seeds[hash (name, 0) % numBuckets];
+        auto index = slots[hash (name, seed) % numSlots];
+
+        if (index == 0 || ! equalsIgnoreCase (namedColours[index - 1].name, name))
+            return nullptr;
+
+        return namedColours + (index - 1);
+    }
+};
+
+constexpr NamedColourTable namedColourTable;
+static_assert (namedColourTable.isValid, "no perfect hash found for the named colours");
+
+//==============================================================================
+/** Reads the tokens of a CSS colour function. */
+struct Scanner
+{
+    std::string_view text;
+
+    void skipSpace() noexcept
+    {
+        while (! text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            text.remove_prefix (1);
+    }
+
+    bool consume (char c) noexcept
+    {
+        skipSpace();
+
+        if (text.empty() || text.front() != c)
+            return false;
+
+        text.remove_prefix (1);
+        return true;
+    }
+
+    bool consumeWord (std::string_view word) noexcept
+    {
+        if (text.size() < word.size() || ! equalsIgnoreCase (text.substr (0, word.size()), word))
+            return false;
+
+        text.remove_prefix (word.size());
+        return true;
+    }
+
+    /** Reads a decimal number like 12, -0.5, .25 or 1e-3. This is written out rather
+        than using std::from_chars, which not every standard library has for floats.
+    */
+    std::optional<float> number() noexcept
+    {
+        skipSpace();
+
+        size_t i = 0;
+        auto isDigit = [this, &i] { return i < text.size() && text[i] >= '0' && text[i] <= '9'; };
+
+        auto negative = i < text.size() && text[i] == '-';
+
+        if (i < text.size() && (text[i] == '-' || text[i] == '+'))
+            ++i;
+
+        double value = 0.0;
+        int numDigits = 0;
+
+        for (; isDigit(); ++i, ++numDigits)
+            value = value * 10.0 + (text[i] - '0');
+
+        if (i < text.size() && text[i] == '.')
+        {
+            ++i;
+
+            for (double scale = 0.1; isDigit(); ++i, ++numDigits, scale *= 0.1)
+                value += (text[i] - '0') * scale;
+        }
+
+        if (numDigits == 0)
+            return std::nullopt;
+
+        if (i + 1 < text.size() && (text[i] == 'e' || text[i] == 'E'))
+        {
+            auto j = i + 1;
+            auto negativeExponent = text[j] == '-';
+
+            if (text[j] == '-' || text[j] == '+')
+                ++j;
+
+            if (j < text.size() && text[j] >= '0' && text[j] <= '9')
+            {
+                int exponent = 0;
+
+                for (i = j; isDigit() && exponent < 100; ++i)
+                    exponent = exponent * 10 + (text[i] - '0');
+
+                value *= std::pow (10.0, negativeExponent ? -exponent : exponent);
+            }
+        }
+
+        text.remove_prefix (i);
+        return float (negative ? -value : value);
+    }
+};
+
+enum class Unit { none, percent, degrees, radians, gradians, turns };
+
+struct Argument
+{
+    float value = 0.0f;
+    Unit unit = Unit::none;
+};
+
+/** Reads the arguments of a colour function up to its closing bracket: three
+    components separated either by commas or by spaces, then optionally an alpha
+    after a comma or a '/'.
+*/
+std::optional<std::array<Argument, 4>> parseArguments (Scanner& scanner) noexcept
+{
+    std::array<Argument, 4> arguments;
+    arguments[3] = { 1.0f, Unit::none };
+
+    auto read = [&scanner] (Argument& c)
+    {
+        auto value = scanner.number();
+
+        if (! value.has_value())
+            return false;
+
+        auto unit = scanner.consume ('%')           ? Unit::percent
+                  : scanner.consumeWord ("deg")     ? Unit::degrees
+                  : scanner.consumeWord ("grad")    ? Unit::gradians
+                  : scanner.consumeWord ("rad")     ? Unit::radians
+                  : scanner.consumeWord ("turn")    ? Unit::turns
+                                                    : Unit::none;
+
+        c = { *value, unit };
+        return true;
+    };
+
+    if (! read (arguments[0]))
+        return std::nullopt;
+
+    auto usesCommas = scanner.consume (',');
+
+    if (! read (arguments[1])
+         || (usesCommas && ! scanner.consume (','))
+         || ! read (arguments[2]))
+        return std::nullopt;
+
+    if (scanner.consume (usesCommas ? ',' : '/') && ! read (arguments[3]))
+        return std::nullopt;
+
+    if (! scanner.consume (')'))
+        return std::nullopt;
+
+    scanner.skipSpace();
+
+    if (! scanner.text.empty())
+        return std::nullopt;
+
+    return arguments;
+}
+
+float toProportion (const Argument& c, float scale) noexcept
+{
+    return juce::jlimit (0.0f, 1.0f, c.unit == Unit::percent ? c.value / 100.0f : c.value / scale);
+}
+
+/** Returns a hue in turns, from 0.0 up to 1.0. */
+float toHue (const Argument& c) noexcept
+{
+    auto turns = c.unit == Unit::radians  ? c.value / juce::MathConstants<float>::twoPi
+               : c.unit == Unit::gradians ? c.value / 400.0f
+               : c.unit == Unit::turns    ? c.value
+                                          : c.value / 360.0f;
+
+    return turns - std::floor (turns);
+}
+
+std::optional<DeepColour> parseFunction (std::string_view name, Scanner& scanner) noexcept
+{
+    auto args = parseArguments (scanner);
+
+    if (! args.has_value())
+        return std::nullopt;
+
+    auto& [c0, c1, c2, alpha] = *args;
+    auto a = toProportion (alpha, 1.0f);
+
+    if (name == "rgb" || name == "rgba")
+        return DeepColour::fromRGBA (toProportion (c0, 255.0f), toProportion (c1, 255.0f), toProportion (c2, 255.0f), a);
+
+    if (name == "hsl" || name == "hsla")
+    {
+        // HSL to HSB, which keeps the hue of greys
+        auto s = toProportion (c1, 100.0f);
+        auto l = toProportion (c2, 100.0f);
+        auto brightness = l + s * juce::jmin (l, 1.0f - l);
+        auto saturation = brightness > 0.0f ? 2.0f * (1.0f - l / brightness) : 0.0f;
+
+        return DeepColour::fromHSB (toHue (c0), saturation, brightness, a);
+    }
+
+    if (name == "oklch")
+    {
+        constexpr float maxChroma = 0.4f;
+
+        auto L = toProportion (c0, 1.0f);
+        auto C = c1.unit == Unit::percent ? c1.value / 100.0f : c1.value / maxChroma;
+
+        return ColourModel::getOKLCH().toColour ({ L, juce::jlimit (0.0f, 1.0f, C), toHue (c2) }, a);
+    }
+
+    return std::nullopt;
+}
+
+//==============================================================================
+/** Writes text into a buffer, silently stopping at its end. */
+struct Writer
+{
+    ColourText::Buffer& buffer;
+    size_t length = 0;
+
+    void add (std::string_view text) noexcept
+    {
+        auto n = juce::jmin (text.size(), buffer.size() - length);
+        std::copy_n (text.data(), n, buffer.data() + length);
+        length += n;
+    }
+
+    void addHexByte (float proportion) noexcept
+    {
+        constexpr std::string_view digits = "0123456789ABCDEF";
+        auto byte = juce::roundToInt (juce::jlimit (0.0f, 1.0f, proportion) * 255.0f);
+
+        add ({ digits.data() + (byte >> 4), 1 });
+        add ({ digits.data() + (byte & 15), 1 });
+    }
+
+    /** Writes a number with up to a number of decimals, leaving off trailing zeros. */
+    void addNumber (float value, int maxDecimals) noexcept
+    {
+        auto scale = juce::int64 (std::pow (10, maxDecimals));
+        auto scaled = juce::int64 (std::llround (double (value) * double (scale)));
+
+        if (scaled < 0)
+        {
+            add ("-");
+            scaled = -scaled;
+        }
+
+        char digits[24];
+        add ({ digits, size_t (std::to_chars (digits, digits + sizeof (digits), scaled / scale).ptr - digits) });
+
+        auto fraction = scaled % scale;
+
+        if (fraction == 0)
+            return;
+
+        char decimals[24];
+        int numDecimals = maxDecimals;
+
+        while (fraction % 10 == 0)
+        {
+            fraction /= 10;
+            --numDecimals;
+        }
+
+        for (int i = numDecimals; --i >= 0; fraction /= 10)
+            decimals[i] = char ('0' + fraction % 10);
+
+        add (".");
+        add ({ decimals, size_t (numDecimals) });
+    }
+
+    /** Writes a hue given in turns as degrees, so that it never reads 360. */
+    void addHue (float turns) noexcept
+    {
+        auto degrees = std::round (turns * 3600.0f) / 10.0f;
+        addNumber (degrees >= 360.0f ? 0.0f : degrees, 1);
+    }
+
+    void addAlpha (float alpha, bool includeAlpha) noexcept
+    {
+        if (includeAlpha)
+        {
+            add (" / ");
+            addNumber (alpha, 3);
+        }
+
+        add (")");
+    }
+
+    std::string_view getText() const noexcept   { return { buffer.data(), length }; }
+};
+
+} // namespace
+
+//==============================================================================
+std::optional<DeepColour> ColourText::parse (std::string_view text) noexcept
+{
+    Scanner scanner { text };
+    scanner.skipSpace();
+
+    while (! scanner.text.empty() && (scanner.text.back() == ' ' || scanner.text.back() == '\t'))
+        scanner.text.remove_suffix (1);
+
+    if (auto hex = DeepColour::fromHexString (scanner.text))
+        return hex;
+
+    auto nameEnd = std::min (scanner.text.find ('('), scanner.text.size());
+    auto name = scanner.text.substr (0, nameEnd);
+
+    if (nameEnd == scanner.text.size())
+    {
+        if (equalsIgnoreCase (name, "transparent"))
+            return DeepColour (juce::uint32 (0));
+
+        if (auto* named = namedColourTable.find (name))
+            return DeepColour (0xff000000u | named->rgb);
+
+        return std::nullopt;
+    }
+
+    // function names are short, so lower-case them on the stack
+    char lowerName[8];
+
+    if (name.size() > sizeof (lowerName))
+        return std::nullopt;
+
+    std::transform (name.begin(), name.end(), lowerName, toLower);
+    scanner.text.remove_prefix (nameEnd + 1);
+
+    return parseFunction ({ lowerName, name.size() }, scanner);
+}
+
+std::string_view ColourText::format (const DeepColour& colour, Format format, bool includeAlpha, Buffer& buffer) noexcept
+{
+    Writer w { buffer };
+
+    if (format == Format::hex)
+    {
+        auto rgb = colour.getRGB();
+
+        w.addHexByte (rgb.r);
+        w.addHexByte (rgb.g);
+        w.addHexByte (rgb.b);
+
+        if (includeAlpha)
+            w.addHexByte (colour.getAlpha());
+    }
+    else if (format == Format::rgb)
+    {
+        auto rgb = colour.getRGB();
+
+        w.add ("rgb(");
+        w.addNumber ((float) juce::roundToInt (rgb.r * 255.0f), 0);
+        w.add (" ");
+        w.addNumber ((float) juce::roundToInt (rgb.g * 255.0f), 0);
+        w.add (" ");
+        w.addNumber ((float) juce::roundToInt (rgb.b * 255.0f), 0);
+        w.addAlpha (colour.getAlpha(), includeAlpha);
+    }
+    else if (format == Format::hsl)
+    {
+        // HSB to HSL
+        auto hsb = colour.getHSB();
+        auto l = hsb.b * (1.0f - hsb.s * 0.5f);
+        auto s = (l > 0.0f && l < 1.0f) ? (hsb.b - l) / juce::jmin (l, 1.0f - l) : 0.0f;
+
+        w.add ("hsl(");
+        w.addHue (s > 0.0f ? hsb.h : 0.0f);
+        w.add (" ");
+        w.addNumber (s * 100.0f, 1);
+        w.add ("% ");
+        w.addNumber (l * 100.0f, 1);
+        w.add ("%");
+        w.addAlpha (colour.getAlpha(), includeAlpha);
+    }
+    else if (format == Format::oklch)
+    {
+        auto values = ColourModel::getOKLCH().fromColour (colour);
+        auto chroma = values[1] * 0.4f;
+
+        w.add ("oklch(");
+        w.addNumber (values[0], 3);
+        w.add (" ");
+        w.addNumber (chroma, 3);
+        w.add (" ");
+        w.addHue (chroma >= 0.0005f ? values[2] : 0.0f);
+        w.addAlpha (colour.getAlpha(), includeAlpha);
+    }
+
+    return w.getText();
+}
+
+} // namespace reFX
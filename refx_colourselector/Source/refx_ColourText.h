@@ -0,0 +1,55 @@
+#pragma once
+
+namespace reFX
+{
+
+//==============================================================================
+/**
+    Reading and writing colours as text, without allocating.
+
+    Both directions work on std::string_view and fixed-size buffers, so the
+    selector's text fields can parse every keystroke and reformat every change
+    without touching the heap.
+
+    @tags{Graphics}
+*/
+namespace ColourText
+{
+    /** Parses a colour written in any of these forms:
+
+        - hex digits in the order rgb, rgba, rrggbb or rrggbbaa, with or without a '#'
+        - CSS rgb() and rgba(), with components from 0 to 255 or as percentages
+        - CSS hsl() and hsla(), with the hue in degrees or with a deg, rad, grad or
+          turn unit, and saturation and lightness as percentages
+        - CSS oklch(), with lightness from 0 to 1 or as a percentage, chroma from 0
+          to 0.4 or as a percentage of that, and the hue as for hsl()
+        - the CSS named colours and "transparent", in any case
+
+        The functions accept both the comma-separated and the space-separated CSS
+        syntax, with an optional alpha after a comma or a '/'. Leading and trailing
+        whitespace is ignored.
+
+        @returns the colour, or std::nullopt if the text isn't one of these
+    */
+    std::optional<DeepColour> parse (std::string_view text) noexcept;
+
+    /** The ways that format() can write a colour. */
+    enum class Format
+    {
+        hex,        /**< RRGGBB, or RRGGBBAA with alpha, without a '#' */
+        rgb,        /**< rgb(255 136 0), or rgb(255 136 0 / 0.5) with alpha */
+        hsl,        /**< hsl(32 100% 50%) */
+        oklch       /**< oklch(0.732 0.173 54.6) */
+    };
+
+    /** A buffer that any formatted colour fits into. */
+    using Buffer = std::array<char, 64>;
+
+    /** Writes a colour into a buffer and returns the text, which points into the buffer.
+
+        The alpha is only written if includeAlpha is true.
+    */
+    std::string_view format (const DeepColour& colour, Format format, bool includeAlpha, Buffer& buffer) noexcept;
+}
+
+} // namespace reFX
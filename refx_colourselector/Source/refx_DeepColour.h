@@ -5,8 +5,8 @@ namespace reFX
 
 struct RGB
 {
-    RGB() = default;
-    RGB (float r_, float g_, float b_) : r (r_), g (g_), b (b_) {}
+    constexpr RGB() = default;
+    constexpr RGB (float r_, float g_, float b_) : r (r_), g (g_), b (b_) {}
 
     float r = 0.0f;
     float g = 0.0f;
@@ -15,19 +15,122 @@ struct RGB
 
 struct HSB
 {
-    HSB() = default;
-    HSB (float h_, float s_, float b_) : h (h_), s (s_), b (b_) {}
+    constexpr HSB() = default;
+    constexpr HSB (float h_, float s_, float b_) : h (h_), s (s_), b (b_) {}
 
     float h = 0.0f;
     float s = 0.0f;
     float b = 0.0f;
 };
 
+struct RGBA
+{
+    float r = 0.0f;
+    float g = 0.0f;
+    float b = 0.0f;
+    float a = 0.0f;
+};
+
+struct HSBA
+{
+    float h = 0.0f;
+    float s = 0.0f;
+    float b = 0.0f;
+    float a = 0.0f;
+};
+
+/** Converts a single colour from red, green and blue to hue, saturation and brightness.
+    @see ColourConversion::rgbToHsb
+*/
+constexpr HSB rgbToHsb (const RGB& rgb)
+{
+    auto maxVal = std::max ({rgb.r, rgb.g, rgb.b});
+    auto minVal = std::min ({rgb.r, rgb.g, rgb.b});
+    auto delta = maxVal - minVal;
+
+    auto h = 0.0f;
+    auto s = 0.0f;
+    auto b = maxVal;
+
+    if (delta == 0)
+    {
+        h = 0.0f;
+        s = 0.0f;
+    }
+    else
+    {
+        s = delta / maxVal;
+
+        if (maxVal == rgb.r)
+            h = (rgb.g - rgb.b) / delta;
+        else if (maxVal == rgb.g)
+            h = 2 + (rgb.b - rgb.r) / delta;
+        else
+            h = 4 + (rgb.r - rgb.g) / delta;
+
+        h *= 60;
+        if (h < 0)
+            h += 360;
+    }
+
+    return { h / 360.0f, s, b };
+}
+
+/** Wraps a hue into the range 0.0 to 1.0, turning a hue that is NaN or infinite into 0.0. */
+constexpr float wrapHue (float h)
+{
+    if (! (h - h == 0.0f))
+        return 0.0f;
+
+    if (std::is_constant_evaluated())
+    {
+        // std::floor isn't constexpr before C++23. Floats this large are whole numbers,
+        // and anything smaller fits an int64 without overflowing.
+        if (h >= 8388608.0f || h <= -8388608.0f)
+            return 0.0f;
+
+        auto whole = float (juce::int64 (h));
+        return h - (whole > h ? whole - 1.0f : whole);
+    }
+
+    return h - std::floor (h);
+}
+
+/** Converts a single colour from hue, saturation and brightness to red, green and blue.
+
+    Hue values outside 0.0 to 1.0 wrap around, and a hue that isn't finite is read as 0.0.
+
+    @see ColourConversion::hsbToRgb
+*/
+constexpr RGB hsbToRgb (const HSB& hsb)
+{
+    // Branch-free form of the six hue sectors, the same one the batch kernels use:
+    // channel(n) = b - b * s * clamp (min (k, 4 - k), 0, 1), where k = (n + 6h) mod 6
+    auto h = wrapHue (hsb.h);
+    auto h6 = h * 6.0f;
+    auto bs = hsb.b * hsb.s;
+
+    auto channel = [&] (float n)
+    {
+        auto k = n + h6;
+
+        if (k >= 6.0f)
+            k -= 6.0f;
+
+        return hsb.b - bs * std::max (std::min ({ k, 4.0f - k, 1.0f }), 0.0f);
+    };
+
+    return { channel (5.0f), channel (3.0f), channel (1.0f) };
+}
+
 //==============================================================================
 /**
     Represents a colour, also including a transparency value.
 
-    The colour is stored internally as float red, green, blue and alpha values.
+    The colour keeps whichever of HSB or RGB it was created from, so hue survives
+    while saturation or brightness is zero. The other representation is converted
+    once, when the colour is created, so the getters are plain reads: they never
+    convert twice, and a DeepColour can be read from several threads at once.
 
     @tags{Graphics}
 */
@@ -36,10 +139,10 @@ class DeepColour final
 public:
     //==============================================================================
     /** Creates a transparent black colour. */
-    DeepColour() = default;
+    constexpr DeepColour() = default;
 
     /** Creates a copy of another DeepColour object. */
-    DeepColour (const DeepColour&) = default;
+    constexpr DeepColour (const DeepColour&) = default;
 
     /** Creates a copy of a juce::Colour object. */
     DeepColour (const juce::Colour&);
@@ -54,33 +157,70 @@ public:
 
         @see getPixelARGB
     */
-    explicit DeepColour (juce::uint32 argb) noexcept;
-
-    explicit DeepColour (HSB hsb, float alpha = 1.0f) noexcept;
-
-    explicit DeepColour (RGB rgb, float alpha = 1.0f) noexcept;
+    constexpr explicit DeepColour (juce::uint32 argb) noexcept
+        : a (((argb >> 24) & 0xff) / 255.0f),
+          rgb ((((argb >> 16) & 0xff) / 255.0f), (((argb >> 8) & 0xff) / 255.0f), ((argb & 0xff) / 255.0f)),
+          hsb (rgbToHsb (rgb))
+    {
+    }
+
+    constexpr explicit DeepColour (HSB hsb_, float alpha = 1.0f) noexcept
+        : a (alpha), rgb (hsbToRgb (hsb_)), hsb (hsb_)
+    {
+    }
+
+    constexpr explicit DeepColour (RGB rgb_, float alpha = 1.0f) noexcept
+        : a (alpha), rgb (rgb_), hsb (rgbToHsb (rgb_))
+    {
+    }
+
+    /** Creates a colour from both its HSB and RGB forms, which must describe the same
+        colour. Neither is recomputed from the other, so this restores a colour exactly.
+    */
+    constexpr DeepColour (HSB hsb_, RGB rgb_, float alpha) noexcept
+        : a (alpha), rgb (rgb_), hsb (hsb_)
+    {
+    }
 
     /** Creates an opaque colour using float red, green and blue values */
-    static DeepColour fromRGB (float red, float green, float blue) noexcept;
+    static constexpr DeepColour fromRGB (float red, float green, float blue) noexcept
+    {
+        return DeepColour (RGB (red, green, blue), 1.0f);
+    }
 
-    /** Creates a colour using 8-bit red, green, blue and alpha values. */
-    static DeepColour fromRGBA (float red, float green, float blue, float alpha) noexcept;
+    /** Creates a colour using float red, green, blue and alpha values. */
+    static constexpr DeepColour fromRGBA (float red, float green, float blue, float alpha) noexcept
+    {
+        return DeepColour (RGB (red, green, blue), alpha);
+    }
 
     /** Creates a colour using floating point hue, saturation, brightness and alpha values.
 
         All values must be between 0.0 and 1.0.
         Numbers outside the valid range will be clipped.
     */
-    static DeepColour fromHSB (float hue,
-                               float saturation,
-                               float brightness,
-                               float alpha) noexcept;
+    static constexpr DeepColour fromHSB (float hue,
+                                         float saturation,
+                                         float brightness,
+                                         float alpha) noexcept
+    {
+        return DeepColour (HSB (hue, saturation, brightness), alpha);
+    }
+
+    /** Parses a CSS-style hex colour: an optional '#' followed by 3, 4, 6 or 8
+        hex digits in the order rgb, rgba, rrggbb or rrggbbaa.
+
+        This can run at compile time; see ColourLiterals for a literal that does.
+
+        @returns the colour, or std::nullopt if the text isn't a hex colour
+    */
+    static constexpr std::optional<DeepColour> fromHexString (std::string_view text) noexcept;
 
     /** Destructor. */
-    ~DeepColour() = default;
+    constexpr ~DeepColour() = default;
 
     /** Copies another Colour object. */
-    DeepColour& operator= (const DeepColour&) = default;
+    constexpr DeepColour& operator= (const DeepColour&) = default;
 
     /** Compares two colours. */
     bool operator== (const DeepColour& other) const noexcept;
@@ -112,7 +252,7 @@ public:
 
         Alpha of 0.0 is completely transparent, 1.0 is completely opaque.
     */
-    float getAlpha() const noexcept                     { return a; }
+    constexpr float getAlpha() const noexcept           { return a; }
 
     DeepColour withAlpha (float newAlpha) const noexcept;
 
@@ -135,12 +275,18 @@ public:
     /** Returns the colour's hue, saturation and brightness components all at once.
         The values returned are in the range 0.0 to 1.0
     */
-    HSB getHSB() const noexcept;
+    constexpr HSB getHSB() const noexcept               { return hsb; }
 
     /** Returns the colour's red, blue and green components all at once.
         The values returned are in the range 0.0 to 1.0
     */
-    RGB getRGB() const noexcept;
+    constexpr RGB getRGB() const noexcept               { return rgb; }
+
+    /** Returns the colour's hue, saturation, brightness and alpha all at once. */
+    HSBA getHSBA() const noexcept;
+
+    /** Returns the colour's red, green, blue and alpha all at once. */
+    RGBA getRGBA() const noexcept;
 
     /** Returns a juce::Colour */
     juce::Colour getColour () const;
@@ -150,7 +296,67 @@ public:
 private:
     //==============================================================================
     float a = 0.0f;
-    std::variant<HSB, RGB> col;
+    RGB rgb;
+    HSB hsb;
 };
 
+//==============================================================================
+constexpr std::optional<DeepColour> DeepColour::fromHexString (std::string_view text) noexcept
+{
+    if (text.starts_with ('#'))
+        text.remove_prefix (1);
+
+    juce::uint32 digits[8] = {};
+    auto numDigits = text.size();
+
+    if (numDigits != 3 && numDigits != 4 && numDigits != 6 && numDigits != 8)
+        return std::nullopt;
+
+    for (size_t i = 0; i < numDigits; ++i)
+    {
+        auto c = text[i];
+
+        if (c >= '0' && c <= '9')       digits[i] = juce::uint32 (c - '0');
+        else if (c >= 'a' && c <= 'f')  digits[i] = juce::uint32 (c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F')  digits[i] = juce::uint32 (c - 'A' + 10);
+        else                            return std::nullopt;
+    }
+
+    auto component = [&] (size_t index) -> juce::uint32
+    {
+        if (numDigits <= 4)
+            return digits[index] * 0x11;
+
+        return (digits[index * 2] << 4) | digits[index * 2 + 1];
+    };
+
+    auto hasAlpha = numDigits == 4 || numDigits == 8;
+    auto alpha = hasAlpha ? component (3) : 0xffu;
+
+    return DeepColour ((alpha << 24) | (component (0) << 16) | (component (1) << 8) | component (2));
+}
+
+/** User-defined literals for writing colour constants that are parsed at compile time.
+
+    @code
+    using namespace reFX::ColourLiterals;
+    constexpr auto accent = "#ff8800"_colour;
+    @endcode
+*/
+namespace ColourLiterals
+{
+    inline void hexColourLiteralIsInvalid() noexcept {}
+
+    consteval DeepColour operator""_colour (const char* text, size_t length)
+    {
+        auto c = DeepColour::fromHexString ({ text, length });
+
+        // a compile error pointing here means the literal isn't a valid hex colour
+        if (! c.has_value())
+            hexColourLiteralIsInvalid();
+
+        return *c;
+    }
+}
+
 } // namespace reFX
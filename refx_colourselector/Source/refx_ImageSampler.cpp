@@ -0,0 +1,103 @@
+namespace reFX
+{
+
+namespace
+{
+
+template <typename PixelType>
+void addRows (const juce::Image::BitmapData& pixels, std::vector<ImageSampler::Sums>& table)
+{
+    auto stride = size_t (pixels.width + 1);
+
+    for (int y = 0; y < pixels.height; ++y)
+    {
+        auto* source = pixels.getLinePointer (y);
+        auto* above = table.data() + size_t (y) * stride;
+        auto* row = above + stride;
+
+        ImageSampler::Sums rowSums {};
+
+        for (int x = 0; x < pixels.width; ++x, source += pixels.pixelStride)
+        {
+            auto& pixel = *reinterpret_cast<const PixelType*> (source);
+            const juce::uint8 channels[] = { pixel.getAlpha(), pixel.getRed(), pixel.getGreen(), pixel.getBlue() };
+
+            for (size_t c = 0; c < 4; ++c)
+            {
+                rowSums[c] = juce::uint16 (rowSums[c] + channels[c]);
+                row[x + 1][c] = juce::uint16 (above[x + 1][c] + rowSums[c]);
+            }
+        }
+    }
+}
+
+} // namespace
+
+//==============================================================================
+void ImageSampler::setImage (const juce::Image& image)
+{
+    clear();
+
+    if (image.isNull())
+        return;
+
+    width = image.getWidth();
+    height = image.getHeight();
+    table.assign (size_t (width + 1) * size_t (height + 1), {});
+
+    const juce::Image::BitmapData pixels (image, juce::Image::BitmapData::readOnly);
+
+    switch (pixels.pixelFormat)
+    {
+        case juce::Image::ARGB:             addRows<juce::PixelARGB> (pixels, table); break;
+        case juce::Image::RGB:              addRows<juce::PixelRGB> (pixels, table); break;
+        case juce::Image::SingleChannel:    addRows<juce::PixelAlpha> (pixels, table); break;
+        case juce::Image::UnknownFormat:
+        default:                            jassertfalse; clear(); break;
+    }
+}
+
+void ImageSampler::clear()
+{
+    width = height = 0;
+    table.clear();
+    table.shrink_to_fit();
+}
+
+std::optional<DeepColour> ImageSampler::getAverage (juce::Point<int> centre, int size) const noexcept
+{
+    jassert (size > 0 && size <= maxRegionSize);
+    size = juce::jlimit (1, maxRegionSize, size);
+
+    auto left = centre.x - size / 2;
+    auto top  = centre.y - size / 2;
+
+    auto x0 = juce::jlimit (0, width, left),    x1 = juce::jlimit (0, width, left + size);
+    auto y0 = juce::jlimit (0, height, top),    y1 = juce::jlimit (0, height, top + size);
+
+    if (x0 >= x1 || y0 >= y1)
+        return std::nullopt;
+
+    // the wrapped sums cancel out to the exact sum over the region
+    auto& a = at (x0, y0);
+    auto& b = at (x1, y0);
+    auto& c = at (x0, y1);
+    auto& d = at (x1, y1);
+
+    std::array<float, 4> sums;
+
+    for (size_t i = 0; i < 4; ++i)
+        sums[i] = (float) juce::uint16 (d[i] - b[i] - c[i] + a[i]);
+
+    if (sums[0] <= 0.0f)
+        return DeepColour();
+
+    auto count = (float) ((x1 - x0) * (y1 - y0));
+
+    return DeepColour::fromRGBA (juce::jmin (1.0f, sums[1] / sums[0]),
+                                 juce::jmin (1.0f, sums[2] / sums[0]),
+                                 juce::jmin (1.0f, sums[3] / sums[0]),
+                                 sums[0] / (255.0f * count));
+}
+
+} // namespace reFX
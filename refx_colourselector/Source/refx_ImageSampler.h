@@ -0,0 +1,62 @@
+#pragma once
+
+namespace reFX
+{
+
+//==============================================================================
+/**
+    Averages the colours of square regions of an image in constant time.
+
+    The image is turned into a summed-area table once, after which the average of
+    any region takes four lookups per channel, whatever its size and however large
+    the image. The table keeps 16-bit sums that are allowed to wrap around: the sum
+    over a region is still exact as long as it fits in 16 bits, which is what limits
+    regions to maxRegionSize pixels square. It takes eight bytes per pixel.
+
+    The averages are taken over premultiplied colours, so transparent pixels don't
+    darken the result.
+
+    @tags{Graphics}
+*/
+class ImageSampler
+{
+public:
+    //==============================================================================
+    ImageSampler() = default;
+
+    /** Builds the table for an image, replacing any previous one. A null image empties it. */
+    void setImage (const juce::Image& image);
+
+    /** Releases the table. */
+    void clear();
+
+    /** Returns true if there's no image. */
+    bool isEmpty() const noexcept               { return width == 0 || height == 0; }
+
+    int getWidth() const noexcept               { return width; }
+    int getHeight() const noexcept              { return height; }
+
+    /** The largest square whose sums still fit into the table's 16 bits. */
+    static constexpr int maxRegionSize = 16;
+
+    /** Returns the average colour of the size by size square centred on a pixel,
+        clipped to the image, or std::nullopt if none of it is inside the image.
+    */
+    std::optional<DeepColour> getAverage (juce::Point<int> centre, int size) const noexcept;
+
+    /** The alpha, red, green and blue sums, modulo 65536. */
+    using Sums = std::array<juce::uint16, 4>;
+
+private:
+    //==============================================================================
+    int width = 0, height = 0;
+
+    // (width + 1) by (height + 1) entries, with a row and a column of zeros in front
+    std::vector<Sums> table;
+
+    const Sums& at (int x, int y) const noexcept    { return table[size_t (y) * size_t (width + 1) + size_t (x)]; }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ImageSampler)
+};
+
+} // namespace reFX
@@ -0,0 +1,226 @@
+namespace reFX
+{
+
+namespace
+{
+
+// ColourModel::getOKLab() maps a and b from -abRange to abRange onto 0 to 1
+constexpr float abRange = 0.4f;
+
+// The grid spans the smallest OKLab box around sRGB. Colours outside it still work,
+// they are just kept in the cells on its faces.
+constexpr float minA = -0.24f, maxA = 0.28f;
+constexpr float minB = -0.32f, maxB = 0.20f;
+
+// about two colours per cell, up to 32768 cells
+constexpr float cellsPerColour = 0.5f;
+constexpr int maxResolution = 32;
+
+} // namespace
+
+//==============================================================================
+void NearestColourIndex::build (std::span<const juce::uint32> colours)
+{
+    auto& oklab = ColourModel::getOKLab();
+
+    constexpr size_t chunkSize = 256;
+    std::array<float, chunkSize> red, green, blue, L, a, b;
+
+    points.resize (colours.size());
+
+    for (size_t start = 0; start < colours.size(); start += chunkSize)
+    {
+        auto num = std::min (chunkSize, colours.size() - start);
+
+        for (size_t i = 0; i < num; ++i)
+        {
+            juce::Colour c (colours[start + i]);
+            red[i]   = c.getFloatRed();
+            green[i] = c.getFloatGreen();
+            blue[i]  = c.getFloatBlue();
+        }
+
+        oklab.fromRGB ({ red.data(), num }, { green.data(), num }, { blue.data(), num },
+                       { L.data(), num }, { a.data(), num }, { b.data(), num });
+
+        for (size_t i = 0; i < num; ++i)
+            points[start + i] = { L[i], (a[i] - 0.5f) * 2.0f * abRange, (b[i] - 0.5f) * 2.0f * abRange };
+    }
+
+    resolution = juce::jlimit (1, maxResolution, (int) std::cbrt ((float) colours.size() * cellsPerColour));
+    cells.assign (size_t (resolution * resolution * resolution), {});
+
+    for (int i = 0; i < size(); ++i)
+        cells[size_t (getCellIndex (points[size_t (i)]))].push_back (i);
+}
+
+void NearestColourIndex::update (int index, juce::Colour newColour)
+{
+    if (! juce::isPositiveAndBelow (index, size()))
+    {
+        jassertfalse;
+        return;
+    }
+
+    auto newPoint = toPoint (DeepColour (newColour));
+    auto& point = points[size_t (index)];
+
+    if (newPoint == point)
+        return;
+
+    auto oldCell = getCellIndex (point);
+    auto newCell = getCellIndex (newPoint);
+    point = newPoint;
+
+    if (oldCell != newCell)
+    {
+        auto& entries = cells[size_t (oldCell)];
+        auto it = std::find (entries.begin(), entries.end(), index);
+
+        jassert (it != entries.end());
+        *it = entries.back();
+        entries.pop_back();
+
+        cells[size_t (newCell)].push_back (index);
+    }
+}
+
+void NearestColourIndex::clear()
+{
+    points.clear();
+    cells.clear();
+    resolution = 1;
+}
+
+//==============================================================================
+int NearestColourIndex::findNearest (const DeepColour& colour) const noexcept
+{
+    Match match;
+    return findNearest (colour, { &match, 1 }) > 0 ? match.index : -1;
+}
+
+int NearestColourIndex::findNearest (const DeepColour& colour, std::span<Match> nearest) const noexcept
+{
+    auto numWanted = (int) nearest.size();
+
+    if (numWanted == 0 || points.empty())
+        return 0;
+
+    auto query = toPoint (colour);
+    auto [cx, cy, cz] = getCellCoordinates (query);
+    int numFound = 0;
+
+    // squared distances while searching, kept sorted by insertion
+    auto consider = [&] (int index)
+    {
+        auto& p = points[size_t (index)];
+        auto d = juce::square (p.L - query.L) + juce::square (p.a - query.a) + juce::square (p.b - query.b);
+
+        if (numFound == numWanted && d >= nearest[size_t (numWanted - 1)].distance)
+            return;
+
+        auto pos = numFound < numWanted ? numFound++ : numWanted - 1;
+
+        for (; pos > 0 && nearest[size_t (pos - 1)].distance > d; --pos)
+            nearest[size_t (pos)] = nearest[size_t (pos - 1)];
+
+        nearest[size_t (pos)] = { index, d };
+    };
+
+    auto visit = [&] (int x, int y, int z)
+    {
+        for (auto index : cells[size_t ((x * resolution + y) * resolution + z)])
+            consider (index);
+    };
+
+    // Visit shells of cells around the query's cell, one cell thicker each time, until
+    // the colours found are closer than anything outside the cells visited so far.
+    const float q[] = { query.L, query.a, query.b };
+    const int c[] = { cx, cy, cz };
+
+    auto getDistanceToUnvisitedCells = [&] (int numShells)
+    {
+        auto distance = std::numeric_limits<float>::max();
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            auto [minValue, maxValue] = getAxisRange (axis);
+            auto extent = (maxValue - minValue) / (float) resolution;
+
+            if (auto first = c[axis] - numShells + 1; first > 0)
+                distance = juce::jmin (distance, q[axis] - (minValue + (float) first * extent));
+
+            if (auto last = c[axis] + numShells - 1; last < resolution - 1)
+                distance = juce::jmin (distance, minValue + (float) (last + 1) * extent - q[axis]);
+        }
+
+        return distance;
+    };
+
+    for (int r = 0; r < resolution; ++r)
+    {
+        if (numFound == numWanted && r > 0)
+        {
+            auto distance = getDistanceToUnvisitedCells (r);
+
+            if (distance > 0.0f && nearest[size_t (numWanted - 1)].distance <= distance * distance)
+                break;
+        }
+
+        for (int x = juce::jmax (0, cx - r); x <= juce::jmin (resolution - 1, cx + r); ++x)
+        {
+            for (int y = juce::jmax (0, cy - r); y <= juce::jmin (resolution - 1, cy + r); ++y)
+            {
+                if (std::abs (x - cx) == r || std::abs (y - cy) == r)
+                {
+                    for (int z = juce::jmax (0, cz - r); z <= juce::jmin (resolution - 1, cz + r); ++z)
+                        visit (x, y, z);
+                }
+                else
+                {
+                    if (cz - r >= 0)            visit (x, y, cz - r);
+                    if (cz + r < resolution)    visit (x, y, cz + r);
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < numFound; ++i)
+        nearest[size_t (i)].distance = std::sqrt (nearest[size_t (i)].distance);
+
+    return numFound;
+}
+
+//==============================================================================
+NearestColourIndex::Point NearestColourIndex::toPoint (const DeepColour& colour) noexcept
+{
+    auto values = ColourModel::getOKLab().fromColour (colour);
+    return { values[0], (values[1] - 0.5f) * 2.0f * abRange, (values[2] - 0.5f) * 2.0f * abRange };
+}
+
+std::pair<float, float> NearestColourIndex::getAxisRange (int axis) noexcept
+{
+    if (axis == 1)  return { minA, maxA };
+    if (axis == 2)  return { minB, maxB };
+
+    return { 0.0f, 1.0f };
+}
+
+std::array<int, 3> NearestColourIndex::getCellCoordinates (const Point& p) const noexcept
+{
+    auto toCell = [this] (float value, int axis)
+    {
+        auto [minValue, maxValue] = getAxisRange (axis);
+        return juce::jlimit (0, resolution - 1, (int) ((value - minValue) / (maxValue - minValue) * (float) resolution));
+    };
+
+    return { toCell (p.L, 0), toCell (p.a, 1), toCell (p.b, 2) };
+}
+
+int NearestColourIndex::getCellIndex (const Point& p) const noexcept
+{
+    auto [x, y, z] = getCellCoordinates (p);
+    return (x * resolution + y) * resolution + z;
+}
+
+} // namespace reFX
@@ -0,0 +1,76 @@
+#pragma once
+
+namespace reFX
+{
+
+//==============================================================================
+/**
+    Finds the colours of a list that are closest to a given colour.
+
+    The colours are placed in a uniform grid over OKLab, so distances are
+    perceptual and a query only looks at the cells around the colour it is
+    given, growing outwards until nothing closer can be left. The grid's
+    resolution follows the number of colours when the index is built, which
+    keeps the number of colours per cell small whatever the size of the list.
+
+    A single colour can be changed with update() without rebuilding the rest.
+    Alpha is ignored.
+
+    @tags{Graphics}
+*/
+class NearestColourIndex
+{
+public:
+    //==============================================================================
+    NearestColourIndex() = default;
+
+    /** Replaces the colours with a list of packed ARGB values. */
+    void build (std::span<const juce::uint32> colours);
+
+    /** Changes one of the colours. */
+    void update (int index, juce::Colour newColour);
+
+    /** Removes all colours. */
+    void clear();
+
+    /** Returns the number of colours. */
+    int size() const noexcept                   { return (int) points.size(); }
+
+    //==============================================================================
+    /** A colour found by a query, with its distance in OKLab. */
+    struct Match
+    {
+        int index = -1;
+        float distance = 0.0f;
+    };
+
+    /** Returns the index of the colour closest to a colour, or -1 if there are none. */
+    int findNearest (const DeepColour& colour) const noexcept;
+
+    /** Fills an array with the colours closest to a colour, closest first, and
+        returns how many were found. The array's size is the number of colours asked for.
+    */
+    int findNearest (const DeepColour& colour, std::span<Match> nearest) const noexcept;
+
+private:
+    //==============================================================================
+    struct Point
+    {
+        float L = 0.0f, a = 0.0f, b = 0.0f;
+
+        bool operator== (const Point&) const = default;
+    };
+
+    std::vector<Point> points;
+    std::vector<std::vector<int>> cells;
+    int resolution = 1;
+
+    static Point toPoint (const DeepColour&) noexcept;
+    static std::pair<float, float> getAxisRange (int axis) noexcept;
+    int getCellIndex (const Point&) const noexcept;
+    std::array<int, 3> getCellCoordinates (const Point&) const noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NearestColourIndex)
+};
+
+} // namespace reFX
@@ -0,0 +1,533 @@
+namespace reFX
+{
+
+namespace
+{
+
+// ColourModel::getOKLab() maps a and b from -0.4 to 0.4 onto 0 to 1
+constexpr float oklabABScale = 0.8f;
+
+constexpr int histogramBits = 5;
+constexpr int histogramSize = 1 << (3 * histogramBits);
+constexpr juce::uint32 minAlpha = 128;
+constexpr int maxIterations = 16;
+
+// after the histogram, how much of the progress is left for the clustering
+constexpr float clusteringShare = 0.1f;
+
+constexpr int binShift = 8 - histogramBits;
+constexpr juce::uint32 lowBitsMask = (1u << binShift) - 1;
+
+// The pixels that fell into one bin: their number, and the sums of the bits of their
+// channels below the bin's, from which the bin's exact mean colour can be found.
+// As each of those is at most 7, a bin can count this many pixels without overflowing.
+enum BinField { binCount, binRed, binGreen, binBlue, numBinFields };
+
+using Bin = std::array<juce::uint32, numBinFields>;
+using Histogram = std::vector<Bin>;
+
+constexpr juce::uint64 maxPixelsPerHistogram = std::numeric_limits<juce::uint32>::max() / lowBitsMask;
+
+template <typename PixelType>
+void countPixels (const juce::Image::BitmapData& pixels, Histogram& histogram, int startRow, int endRow)
+{
+    for (int y = startRow; y < endRow; ++y)
+    {
+        auto* source = pixels.getLinePointer (y);
+
+        for (int x = 0; x < pixels.width; ++x, source += pixels.pixelStride)
+        {
+            auto& pixel = *reinterpret_cast<const PixelType*> (source);
+            juce::uint32 a = pixel.getAlpha(), r = pixel.getRed(), g = pixel.getGreen(), b = pixel.getBlue();
+
+            if (a < 255)
+            {
+                if (a < minAlpha)
+                    continue;
+
+                r = juce::jmin (255u, (r * 255 + a / 2) / a);
+                g = juce::jmin (255u, (g * 255 + a / 2) / a);
+                b = juce::jmin (255u, (b * 255 + a / 2) / a);
+            }
+
+            auto index = ((r >> binShift) << (2 * histogramBits)) | ((g >> binShift) << histogramBits) | (b >> binShift);
+
+            auto& bin = histogram[index];
+            ++bin[binCount];
+            bin[binRed]   += r & lowBitsMask;
+            bin[binGreen] += g & lowBitsMask;
+            bin[binBlue]  += b & lowBitsMask;
+        }
+    }
+}
+
+//==============================================================================
+/** Weighted points in OKLab, with a, b and the weights kept in separate arrays. */
+struct Points
+{
+    std::vector<float> L, a, b, weight;
+
+    size_t size() const noexcept                { return weight.size(); }
+    float get (int axis, size_t i) const noexcept  { return axis == 0 ? L[i] : (axis == 1 ? a[i] : b[i]); }
+};
+
+/** A range of the sorted point indices, and how much splitting it would reduce the error. */
+struct Box
+{
+    size_t begin, end;
+    int axis = 0;
+    float error = 0.0f;
+};
+
+void measureBox (const Points& points, const std::vector<size_t>& order, Box& box)
+{
+    std::array<double, 3> sum {}, sumSquares {};
+    double weight = 0.0;
+
+    for (auto i = box.begin; i < box.end; ++i)
+    {
+        auto p = order[i];
+        auto w = (double) points.weight[p];
+        weight += w;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            auto v = (double) points.get (axis, p);
+            sum[size_t (axis)] += w * v;
+            sumSquares[size_t (axis)] += w * v * v;
+        }
+    }
+
+    box.error = 0.0f;
+
+    if (box.end - box.begin < 2 || weight <= 0.0)
+        return;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        auto error = (float) (sumSquares[size_t (axis)] - sum[size_t (axis)] * sum[size_t (axis)] / weight);
+
+        if (error > box.error)
+        {
+            box.error = error;
+            box.axis = axis;
+        }
+    }
+}
+
+/** Splits the points into boxes by weighted median cut, returning the boxes' centres. */
+Points medianCut (const Points& points, int numColours)
+{
+    std::vector<size_t> order (points.size());
+    std::iota (order.begin(), order.end(), size_t (0));
+
+    std::vector<Box> boxes { { 0, points.size() } };
+    measureBox (points, order, boxes.front());
+
+    while ((int) boxes.size() < numColours)
+    {
+        auto& box = *std::max_element (boxes.begin(), boxes.end(), [] (auto& x, auto& y) { return x.error < y.error; });
+
+        if (box.error <= 0.0f)
+            break;
+
+        auto axis = box.axis;
+        std::sort (order.begin() + (ptrdiff_t) box.begin, order.begin() + (ptrdiff_t) box.end,
+                   [&] (size_t x, size_t y) { return points.get (axis, x) < points.get (axis, y); });
+
+        double total = 0.0;
+
+        for (auto i = box.begin; i < box.end; ++i)
+            total += points.weight[order[i]];
+
+        auto split = box.begin + 1;
+
+        for (double below = points.weight[order[box.begin]]; split < box.end - 1 && below < total * 0.5; ++split)
+            below += points.weight[order[split]];
+
+        Box upper { split, box.end };
+        box.end = split;
+
+        measureBox (points, order, box);
+        measureBox (points, order, upper);
+        boxes.push_back (upper);
+    }
+
+    Points centres;
+
+    for (auto& box : boxes)
+    {
+        double L = 0.0, a = 0.0, b = 0.0, weight = 0.0;
+
+        for (auto i = box.begin; i < box.end; ++i)
+        {
+            auto p = order[i];
+            auto w = (double) points.weight[p];
+            L += w * points.L[p];
+            a += w * points.a[p];
+            b += w * points.b[p];
+            weight += w;
+        }
+
+        centres.L.push_back ((float) (L / weight));
+        centres.a.push_back ((float) (a / weight));
+        centres.b.push_back ((float) (b / weight));
+        centres.weight.push_back ((float) weight);
+    }
+
+    return centres;
+}
+
+} // namespace
+
+//==============================================================================
+struct PaletteExtractor::Pool
+{
+    juce::ThreadPool threads { juce::ThreadPoolOptions {}
+                                   .withThreadName ("Palette extraction")
+                                   .withNumberOfThreads (juce::jmax (1, juce::SystemStats::getNumCpus() - 1)) };
+};
+
+/** The state shared between an extractor and the threads working for it. Each thread
+    counts the tiles it takes into a histogram of its own and adds that to the job's
+    totals when there are none left; whichever adds the last tile clusters the colours.
+*/
+struct PaletteExtractor::Job
+{
+    Job (PaletteExtractor* e, const juce::Image& source, int numColoursToFind)
+        : extractor (e), image (source),
+          pixels (std::make_unique<juce::Image::BitmapData> (image, juce::Image::BitmapData::readOnly)),
+          numColours (juce::jlimit (1, maxColours, numColoursToFind)),
+          numTiles ((pixels->height + rowsPerTile - 1) / rowsPerTile),
+          pixelsPerTile (juce::uint64 (pixels->width) * juce::uint64 (rowsPerTile))
+    {
+    }
+
+    void run()
+    {
+        Histogram counts;
+        int tilesCounted = 0;
+        juce::uint64 pixelsCounted = 0;
+
+        while (! cancelled)
+        {
+            auto tile = nextTile++;
+
+            if (tile >= numTiles)
+                break;
+
+            if (counts.empty())
+                counts.resize (histogramSize);
+
+            if (pixelsCounted + pixelsPerTile > maxPixelsPerHistogram)
+            {
+                addToTotals (counts, tilesCounted);
+                tilesCounted = 0;
+                pixelsCounted = 0;
+            }
+
+            auto startRow = tile * rowsPerTile;
+            auto endRow = juce::jmin (pixels->height, startRow + rowsPerTile);
+
+            switch (pixels->pixelFormat)
+            {
+                case juce::Image::RGB:              countPixels<juce::PixelRGB> (*pixels, counts, startRow, endRow); break;
+                case juce::Image::SingleChannel:    countPixels<juce::PixelAlpha> (*pixels, counts, startRow, endRow); break;
+                case juce::Image::ARGB:
+                case juce::Image::UnknownFormat:
+                default:                            countPixels<juce::PixelARGB> (*pixels, counts, startRow, endRow); break;
+            }
+
+            ++tilesCounted;
+            ++tilesDone;
+            pixelsCounted += pixelsPerTile;
+        }
+
+        if (tilesCounted > 0 && addToTotals (counts, tilesCounted) && ! cancelled)
+        {
+            pixels = nullptr;
+            cluster();
+            finish();
+        }
+    }
+
+    /** Adds a thread's counts to the job's and clears them, returning true if that
+        completed the histogram.
+    */
+    bool addToTotals (Histogram& counts, int tilesCounted)
+    {
+        const std::scoped_lock sl (totalsLock);
+
+        if (totals.empty())
+            totals.resize (histogramSize);
+
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            for (size_t field = 0; field < numBinFields; ++field)
+                totals[i][field] += counts[i][field];
+
+            counts[i] = {};
+        }
+
+        tilesAdded += tilesCounted;
+        return tilesAdded == numTiles;
+    }
+
+    void cluster()
+    {
+        // the mean colour of every bin that was hit, weighted by its number of pixels
+        std::vector<float> red, green, blue;
+        Points points;
+
+        for (size_t i = 0; i < totals.size(); ++i)
+        {
+            auto& bin = totals[i];
+
+            if (bin[binCount] == 0)
+                continue;
+
+            auto count = (double) bin[binCount];
+            auto getMean = [&] (size_t field, size_t position)
+            {
+                auto binStart = ((i >> (position * histogramBits)) & ((1u << histogramBits) - 1)) << binShift;
+                return (float) (((double) binStart + (double) bin[field] / count) / 255.0);
+            };
+
+            red.push_back (getMean (binRed, 2));
+            green.push_back (getMean (binGreen, 1));
+            blue.push_back (getMean (binBlue, 0));
+            points.weight.push_back ((float) count);
+        }
+
+        auto num = points.size();
+        points.L.resize (num);
+        points.a.resize (num);
+        points.b.resize (num);
+
+        auto& oklab = ColourModel::getOKLab();
+        oklab.fromRGB (red, green, blue, points.L, points.a, points.b);
+
+        for (size_t i = 0; i < num; ++i)
+        {
+            points.a[i] = (points.a[i] - 0.5f) * oklabABScale;
+            points.b[i] = (points.b[i] - 0.5f) * oklabABScale;
+        }
+
+        if (num == 0)
+            return;
+
+        auto centres = medianCut (points, numColours);
+        auto k = centres.size();
+
+        // weighted k-means, starting from the median cut boxes
+        std::vector<int> assignment (num, -1);
+        std::vector<float> errors (num);
+        std::vector<double> sums (k * 4);
+
+        for (int iteration = 0; iteration < maxIterations && ! cancelled; ++iteration)
+        {
+            bool changed = false;
+            std::fill (sums.begin(), sums.end(), 0.0);
+
+            for (size_t i = 0; i < num; ++i)
+            {
+                auto nearest = 0;
+                auto nearestDistance = std::numeric_limits<float>::max();
+
+                for (size_t c = 0; c < k; ++c)
+                {
+                    auto dL = points.L[i] - centres.L[c];
+                    auto da = points.a[i] - centres.a[c];
+                    auto db = points.b[i] - centres.b[c];
+                    auto distance = dL * dL + da * da + db * db;
+
+                    if (distance < nearestDistance)
+                    {
+                        nearestDistance = distance;
+                        nearest = (int) c;
+                    }
+                }
+
+                if (assignment[i] != nearest)
+                {
+                    assignment[i] = nearest;
+                    changed = true;
+                }
+
+                errors[i] = points.weight[i] * nearestDistance;
+
+                auto w = (double) points.weight[i];
+                auto* sum = sums.data() + size_t (nearest) * 4;
+                sum[0] += w * points.L[i];
+                sum[1] += w * points.a[i];
+                sum[2] += w * points.b[i];
+                sum[3] += w;
+            }
+
+            for (size_t c = 0; c < k; ++c)
+            {
+                auto* sum = sums.data() + c * 4;
+                centres.weight[c] = (float) sum[3];
+
+                if (sum[3] > 0.0)
+                {
+                    centres.L[c] = (float) (sum[0] / sum[3]);
+                    centres.a[c] = (float) (sum[1] / sum[3]);
+                    centres.b[c] = (float) (sum[2] / sum[3]);
+                }
+                else
+                {
+                    // a cluster that lost all its points moves to the worst fitting one
+                    auto worst = (size_t) std::distance (errors.begin(), std::max_element (errors.begin(), errors.end()));
+
+                    if (errors[worst] > 0.0f)
+                    {
+                        centres.L[c] = points.L[worst];
+                        centres.a[c] = points.a[worst];
+                        centres.b[c] = points.b[worst];
+                        errors[worst] = 0.0f;
+                        changed = true;
+                    }
+                }
+            }
+
+            clusteringProgress = float (iteration + 1) / float (maxIterations);
+
+            if (! changed)
+                break;
+        }
+
+        std::vector<size_t> order (k);
+        std::iota (order.begin(), order.end(), size_t (0));
+        auto& weights = centres.weight;
+        std::stable_sort (order.begin(), order.end(), [&weights] (size_t x, size_t y) { return weights[x] > weights[y]; });
+
+        for (auto c : order)
+            if (centres.weight[c] > 0.0f)
+                colours.push_back (oklab.toColour ({ centres.L[c],
+                                                     centres.a[c] / oklabABScale + 0.5f,
+                                                     centres.b[c] / oklabABScale + 0.5f }, 1.0f).getColour());
+    }
+
+    void finish()
+    {
+        clusteringProgress = 1.0f;
+        complete = true;
+
+        {
+            const std::scoped_lock sl (lock);
+
+            if (extractor != nullptr)
+                extractor->triggerAsyncUpdate();
+        }
+
+        finished.signal();
+    }
+
+    void cancel()
+    {
+        cancelled = true;
+
+        const std::scoped_lock sl (lock);
+        extractor = nullptr;
+    }
+
+    float getProgress() const noexcept
+    {
+        return (1.0f - clusteringShare) * (float) tilesDone.load() / (float) juce::jmax (1, numTiles)
+                 + clusteringShare * clusteringProgress.load();
+    }
+
+    std::mutex lock;
+    PaletteExtractor* extractor;
+
+    juce::Image image;
+    std::unique_ptr<juce::Image::BitmapData> pixels;
+    const int numColours;
+    const int numTiles;
+    const juce::uint64 pixelsPerTile;
+
+    std::mutex totalsLock;
+    std::vector<std::array<juce::uint64, numBinFields>> totals;
+    int tilesAdded = 0;
+
+    std::vector<juce::Colour> colours;
+    juce::WaitableEvent finished;
+
+    std::atomic<int> nextTile { 0 }, tilesDone { 0 };
+    std::atomic<float> clusteringProgress { 0.0f };
+    std::atomic<bool> cancelled { false }, complete { false };
+};
+
+//==============================================================================
+PaletteExtractor::PaletteExtractor() = default;
+
+PaletteExtractor::~PaletteExtractor()
+{
+    cancel();
+}
+
+void PaletteExtractor::startWorkers (Pool& p, const std::shared_ptr<Job>& j, int numWorkers)
+{
+    numWorkers = juce::jmin (numWorkers, j->numTiles, p.threads.getNumThreads());
+
+    for (int i = 0; i < numWorkers; ++i)
+        p.threads.addJob ([j] { j->run(); });
+}
+
+void PaletteExtractor::extract (const juce::Image& image, int numColours)
+{
+    cancel();
+
+    if (image.isNull() || numColours <= 0)
+        return;
+
+    job = std::make_shared<Job> (this, image, numColours);
+    startWorkers (*pool, job, job->numTiles);
+}
+
+std::vector<juce::Colour> PaletteExtractor::extractColours (const juce::Image& image, int numColours)
+{
+    if (image.isNull() || numColours <= 0)
+        return {};
+
+    juce::SharedResourcePointer<Pool> sharedPool;
+    auto j = std::make_shared<Job> (nullptr, image, numColours);
+
+    // this thread takes tiles too, so the result doesn't depend on the pool being idle
+    startWorkers (*sharedPool, j, j->numTiles - 1);
+    j->run();
+    j->finished.wait();
+
+    return std::move (j->colours);
+}
+
+void PaletteExtractor::cancel()
+{
+    if (job != nullptr)
+    {
+        job->cancel();
+        job = nullptr;
+    }
+
+    cancelPendingUpdate();
+}
+
+float PaletteExtractor::getProgress() const noexcept
+{
+    return job != nullptr ? job->getProgress() : 0.0f;
+}
+
+void PaletteExtractor::handleAsyncUpdate()
+{
+    if (job == nullptr || ! job->complete)
+        return;
+
+    auto colours = std::move (job->colours);
+    job = nullptr;
+
+    if (onColoursReady != nullptr)
+        onColoursReady (colours);
+}
+
+} // namespace reFX
@@ -0,0 +1,78 @@
+#pragma once
+
+namespace reFX
+{
+
+//==============================================================================
+/**
+    Finds the dominant colours of an image, for example to generate swatches from a photo.
+
+    The image is first reduced to a histogram of 32768 bins, 5 bits per channel,
+    which every thread of a shared pool fills from its own bands of rows. The
+    bins that were hit, weighted by their pixel counts, are then split into boxes
+    by median cut in OKLab, and the boxes' centres refined with weighted k-means,
+    so the colours are grouped perceptually. Since clustering only sees the bins,
+    its cost doesn't grow with the size of the image.
+
+    Pixels that are less than half opaque are ignored, and the colours found are
+    opaque.
+
+    Requesting new colours, or calling cancel(), abandons the extraction in flight.
+
+    @tags{Graphics}
+*/
+class PaletteExtractor  : private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    PaletteExtractor();
+    ~PaletteExtractor() override;
+
+    /** Starts finding the dominant colours of an image in the background, cancelling
+        the extraction in flight, if any. Does nothing for a null image or
+        if no colours are asked for.
+    */
+    void extract (const juce::Image& image, int numColours);
+
+    /** Abandons the extraction in flight, if any. */
+    void cancel();
+
+    /** Returns true while colours are being extracted. */
+    bool isExtracting() const noexcept          { return job != nullptr; }
+
+    /** Returns how far the extraction in flight has got, from 0.0 to 1.0. This can be
+        polled from a timer to show a progress bar.
+    */
+    float getProgress() const noexcept;
+
+    /** Called on the message thread with the colours that were found, most common
+        first. There may be fewer than were asked for if the image has fewer
+        distinct colours.
+    */
+    std::function<void (const std::vector<juce::Colour>&)> onColoursReady;
+
+    /** Finds the dominant colours of an image and waits for the result. The calling
+        thread helps fill the histogram, so this can be called from any thread.
+    */
+    static std::vector<juce::Colour> extractColours (const juce::Image& image, int numColours);
+
+    /** The most colours that can be asked for. */
+    static constexpr int maxColours = 256;
+
+    static constexpr int rowsPerTile = 32;
+
+private:
+    //==============================================================================
+    struct Job;
+    struct Pool;
+
+    juce::SharedResourcePointer<Pool> pool;
+    std::shared_ptr<Job> job;
+
+    static void startWorkers (Pool&, const std::shared_ptr<Job>&, int numWorkers);
+    void handleAsyncUpdate() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PaletteExtractor)
+};
+
+} // namespace reFX
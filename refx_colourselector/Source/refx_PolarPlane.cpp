@@ -0,0 +1,316 @@
+namespace reFX
+{
+
+namespace PolarPlane
+{
+
+namespace
+{
+
+float toTurns (juce::Point<float> position) noexcept
+{
+    auto turns = std::atan2 (position.y, position.x) / juce::MathConstants<float>::twoPi;
+    return turns < 0.0f ? turns + 1.0f : turns;
+}
+
+//==============================================================================
+/** The angle, in turns, and the radius, in unit coordinates, of the centre of every
+    pixel of a square image. These are the only places that need atan2 and sqrt.
+*/
+struct PolarLUT
+{
+    explicit PolarLUT (int size)
+        : num (size_t (size)), angles (num * num), radii (num * num)
+    {
+        for (size_t y = 0; y < num; ++y)
+        {
+            for (size_t x = 0; x < num; ++x)
+            {
+                auto position = getUnitPosition (x, y);
+
+                angles[y * num + x] = toTurns (position);
+                radii[y * num + x]  = position.getDistanceFromOrigin();
+            }
+        }
+    }
+
+    juce::Point<float> getUnitPosition (size_t x, size_t y) const noexcept
+    {
+        auto half = (float) num * 0.5f;
+        return { ((float) x + 0.5f - half) / half, (half - (float) y - 0.5f) / half };
+    }
+
+    std::span<const float> getAngles (size_t y) const noexcept     { return { angles.data() + y * num, num }; }
+    std::span<const float> getRadii (size_t y) const noexcept      { return { radii.data() + y * num, num }; }
+
+    size_t num;
+    std::vector<float> angles, radii;
+};
+
+//==============================================================================
+/** Converts a coverage or a brightness to the factor that multiply() takes. */
+juce::uint32 toScale (float amount) noexcept
+{
+    return (juce::uint32) juce::roundToInt (juce::jlimit (0.0f, 1.0f, amount) * 256.0f);
+}
+
+/** Multiplies all four channels of a pixel by scale / 256, two at a time. */
+juce::uint32 multiply (juce::uint32 pixel, juce::uint32 scale) noexcept
+{
+    auto rb = (((pixel & 0x00ff00ffu) * scale + 0x00800080u) >> 8) & 0x00ff00ffu;
+    auto ag =  (((pixel >> 8) & 0x00ff00ffu) * scale + 0x00800080u)       & 0xff00ff00u;
+
+    return ag | rb;
+}
+
+/** Fades a premultiplied pixel out by the fraction of it that a shape covers,
+    given the distance of its centre inside the shape's edge in pixels.
+*/
+juce::uint32 applyCoverage (juce::uint32 pixel, float distanceInside) noexcept
+{
+    auto coverage = distanceInside + 0.5f;
+
+    if (coverage >= 1.0f)   return pixel;
+    if (coverage <= 0.0f)   return 0;
+
+    return multiply (pixel, toScale (coverage));
+}
+
+juce::uint32* getLine (const juce::Image::BitmapData& pixels, int y) noexcept
+{
+    return reinterpret_cast<juce::uint32*> (pixels.getLinePointer (y));
+}
+
+//==============================================================================
+juce::Point<float> getCorner (int index) noexcept
+{
+    auto angle = (float) index * juce::MathConstants<float>::twoPi / 3.0f;
+    return { std::cos (angle) * Triangle::triangleRadius, std::sin (angle) * Triangle::triangleRadius };
+}
+
+/** The barycentric weights of the hue, white and black corners. In an equilateral
+    triangle centred on the origin, they are linear in the position's dot product
+    with each corner.
+*/
+std::array<float, 3> getWeights (juce::Point<float> position) noexcept
+{
+    std::array<float, 3> weights;
+    auto rSquared = Triangle::triangleRadius * Triangle::triangleRadius;
+
+    for (int i = 0; i < 3; ++i)
+        weights[size_t (i)] = (1.0f + 2.0f * position.getDotProduct (getCorner (i)) / rSquared) / 3.0f;
+
+    return weights;
+}
+
+/** Moves weights that describe a point outside the triangle onto its nearest edge or corner. */
+std::array<float, 3> clampWeights (std::array<float, 3> weights) noexcept
+{
+    auto sum = 0.0f;
+
+    for (auto& w : weights)
+        sum += (w = juce::jmax (0.0f, w));
+
+    for (auto& w : weights)
+        w /= sum;
+
+    return weights;
+}
+
+} // namespace
+
+//==============================================================================
+juce::Image Wheel::render (float brightness, int newSize)
+{
+    if (newSize <= 0)
+        return {};
+
+    if (newSize != size)
+        prepare (newSize);
+
+    juce::Image image (juce::Image::ARGB, size, size, false);
+    juce::Image::BitmapData pixels (image, juce::Image::BitmapData::writeOnly);
+
+    auto scale = toScale (brightness);
+
+    for (int y = 0; y < size; ++y)
+    {
+        auto* line = getLine (pixels, y);
+        auto* source = fullBrightness.data() + size_t (y * size);
+
+        for (int x = 0; x < size; ++x)
+            line[x] = (source[x] & 0xff000000u) | (multiply (source[x], scale) & 0x00ffffffu);
+    }
+
+    return image;
+}
+
+void Wheel::clear()
+{
+    size = 0;
+    fullBrightness.clear();
+    fullBrightness.shrink_to_fit();
+}
+
+juce::Point<float> Wheel::getPosition (float hue, float saturation) noexcept
+{
+    auto angle = hue * juce::MathConstants<float>::twoPi;
+    return { std::cos (angle) * saturation, std::sin (angle) * saturation };
+}
+
+std::pair<float, float> Wheel::getHueAndSaturation (juce::Point<float> position) noexcept
+{
+    return { toTurns (position), juce::jmin (1.0f, position.getDistanceFromOrigin()) };
+}
+
+void Wheel::prepare (int newSize)
+{
+    size = newSize;
+
+    auto num = size_t (size);
+    auto half = (float) size * 0.5f;
+    PolarLUT lut (size);
+
+    fullBrightness.resize (num * num);
+    std::vector<float> saturation (num), brightness (num, 1.0f);
+
+    for (size_t y = 0; y < num; ++y)
+    {
+        auto radii = lut.getRadii (y);
+        std::span<juce::uint32> row (fullBrightness.data() + y * num, num);
+
+        for (size_t x = 0; x < num; ++x)
+            saturation[x] = juce::jmin (1.0f, radii[x]);
+
+        ColourConversion::hsbToARGB (lut.getAngles (y), saturation, brightness, 1.0f, row);
+
+        for (size_t x = 0; x < num; ++x)
+            row[x] = applyCoverage (row[x], (1.0f - radii[x]) * half);
+    }
+}
+
+//==============================================================================
+juce::Image Triangle::render (float hue, int newSize)
+{
+    if (newSize <= 0)
+        return {};
+
+    if (newSize != size)
+        prepare (newSize);
+
+    juce::Image image (juce::Image::ARGB, size, size, false);
+    juce::Image::BitmapData pixels (image, juce::Image::BitmapData::writeOnly);
+
+    auto pure = hsbToRgb ({ hue, 1.0f, 1.0f });
+    const juce::uint32 channels[] = { (juce::uint32) juce::roundToInt (pure.r * 255.0f),
+                                      (juce::uint32) juce::roundToInt (pure.g * 255.0f),
+                                      (juce::uint32) juce::roundToInt (pure.b * 255.0f) };
+
+    for (int y = 0; y < size; ++y)
+    {
+        auto* line = getLine (pixels, y);
+        auto index = size_t (y * size);
+
+        for (int x = 0; x < size; ++x, ++index)
+        {
+            auto w = weights[index];
+
+            if (w == 0)
+            {
+                line[x] = ring[index];
+                continue;
+            }
+
+            auto white = (w >> 8) & 0xff;
+            auto amount = w & 0xff;
+
+            auto blend = [&] (juce::uint32 c) { return white + (amount * c + 127) / 255; };
+
+            line[x] = (w & 0xff000000u) | (blend (channels[0]) << 16) | (blend (channels[1]) << 8) | blend (channels[2]);
+        }
+    }
+
+    return image;
+}
+
+void Triangle::clear()
+{
+    size = 0;
+    ring.clear();
+    ring.shrink_to_fit();
+    weights.clear();
+    weights.shrink_to_fit();
+}
+
+bool Triangle::isInRing (juce::Point<float> position) noexcept
+{
+    return position.getDistanceFromOrigin() > (ringInnerRadius + triangleRadius) * 0.5f;
+}
+
+float Triangle::getHue (juce::Point<float> position) noexcept
+{
+    return toTurns (position);
+}
+
+juce::Point<float> Triangle::getPosition (float saturation, float brightness) noexcept
+{
+    return getCorner (0) * (brightness * saturation)
+         + getCorner (1) * (brightness * (1.0f - saturation))
+         + getCorner (2) * (1.0f - brightness);
+}
+
+std::pair<float, float> Triangle::getSaturationAndBrightness (juce::Point<float> position) noexcept
+{
+    auto w = clampWeights (getWeights (position));
+    auto brightness = juce::jlimit (0.0f, 1.0f, w[0] + w[1]);
+
+    // saturation means nothing at the black corner, and is only noise near it
+    return { brightness > 1.0e-3f ? juce::jlimit (0.0f, 1.0f, w[0] / brightness) : 0.0f, brightness };
+}
+
+void Triangle::prepare (int newSize)
+{
+    size = newSize;
+
+    auto num = size_t (size);
+    auto half = (float) size * 0.5f;
+    PolarLUT lut (size);
+
+    ring.resize (num * num);
+    weights.assign (num * num, 0);
+
+    // the distance from an edge to the opposite corner, in pixels
+    auto height = 1.5f * triangleRadius * half;
+    std::vector<float> ones (num, 1.0f);
+
+    for (size_t y = 0; y < num; ++y)
+    {
+        auto radii = lut.getRadii (y);
+        std::span<juce::uint32> row (ring.data() + y * num, num);
+
+        ColourConversion::hsbToARGB (lut.getAngles (y), ones, ones, 1.0f, row);
+
+        for (size_t x = 0; x < num; ++x)
+        {
+            row[x] = applyCoverage (row[x], juce::jmin (1.0f - radii[x], radii[x] - ringInnerRadius) * half);
+
+            auto w = getWeights (lut.getUnitPosition (x, y));
+            auto coverage = juce::jlimit (0.0f, 1.0f, juce::jmin (w[0], w[1], w[2]) * height + 0.5f);
+
+            if (coverage <= 0.0f)
+                continue;
+
+            w = clampWeights (w);
+
+            auto alpha = (juce::uint32) juce::roundToInt (coverage * 255.0f);
+            auto white = juce::jmin (alpha, (juce::uint32) juce::roundToInt (coverage * w[1] * 255.0f));
+            auto amount = juce::jmin (alpha - white, (juce::uint32) juce::roundToInt (coverage * w[0] * 255.0f));
+
+            weights[y * num + x] = (alpha << 24) | (white << 8) | amount;
+        }
+    }
+}
+
+} // namespace PolarPlane
+
+} // namespace reFX
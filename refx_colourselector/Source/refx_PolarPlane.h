@@ -0,0 +1,108 @@
+#pragma once
+
+namespace reFX
+{
+
+//==============================================================================
+/**
+    Renders the round colourspaces that ColourSelector can show instead of its
+    square plane.
+
+    Both shapes are drawn in a square image, in unit coordinates that run from -1.0
+    to 1.0 across it with y pointing upwards, and angles that are measured in turns
+    counter-clockwise from the positive x axis. Pixels outside the shape are
+    transparent.
+
+    The angle and radius of every pixel are worked out once for each size, and
+    everything that doesn't depend on the colour is baked into per-pixel tables
+    along with them, so rendering for a new colour is only a few integer operations
+    per pixel.
+
+    @tags{Graphics}
+*/
+namespace PolarPlane
+{
+    //==============================================================================
+    /** A colour wheel: hue runs round the circle from red at angle 0, and saturation
+        from 0.0 at the centre to 1.0 at the edge.
+
+        The wheel at full brightness is kept, so a wheel for another brightness is a
+        single multiply per pixel.
+    */
+    class Wheel
+    {
+    public:
+        Wheel() = default;
+
+        /** Renders the wheel at a brightness into a new square ARGB image. */
+        juce::Image render (float brightness, int size);
+
+        /** Releases the tables, which are rebuilt by the next render(). */
+        void clear();
+
+        /** Returns the position of a hue and saturation, in unit coordinates. */
+        static juce::Point<float> getPosition (float hue, float saturation) noexcept;
+
+        /** Returns the hue and saturation at a position, with the saturation limited to 1.0. */
+        static std::pair<float, float> getHueAndSaturation (juce::Point<float> position) noexcept;
+
+    private:
+        int size = 0;
+        std::vector<juce::uint32> fullBrightness;
+
+        void prepare (int newSize);
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Wheel)
+    };
+
+    //==============================================================================
+    /** A hue ring around a triangle of saturation and brightness for one hue.
+
+        The triangle's corners are the pure hue at angle 0, white at 1/3 and black at
+        2/3, and it doesn't turn with the hue. The ring is the same for every colour,
+        and each pixel of the triangle is kept as its weights of white and of the pure
+        hue, so a triangle for another hue is a multiply-add per channel.
+    */
+    class Triangle
+    {
+    public:
+        Triangle() = default;
+
+        /** Renders the ring and the triangle for a hue into a new square ARGB image. */
+        juce::Image render (float hue, int size);
+
+        /** Releases the tables, which are rebuilt by the next render(). */
+        void clear();
+
+        /** The ring runs from this radius to 1.0, in unit coordinates. */
+        static constexpr float ringInnerRadius = 0.8f;
+
+        /** The distance of the triangle's corners from the centre, in unit coordinates. */
+        static constexpr float triangleRadius = 0.76f;
+
+        /** Returns true if a position is nearer the ring than the triangle. */
+        static bool isInRing (juce::Point<float> position) noexcept;
+
+        /** Returns the hue at a position on the ring. */
+        static float getHue (juce::Point<float> position) noexcept;
+
+        /** Returns the position of a saturation and brightness in the triangle, in unit coordinates. */
+        static juce::Point<float> getPosition (float saturation, float brightness) noexcept;
+
+        /** Returns the saturation and brightness at a position, moved into the triangle
+            if it's outside.
+        */
+        static std::pair<float, float> getSaturationAndBrightness (juce::Point<float> position) noexcept;
+
+    private:
+        int size = 0;
+        std::vector<juce::uint32> ring;
+        std::vector<juce::uint32> weights;
+
+        void prepare (int newSize);
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Triangle)
+    };
+}
+
+} // namespace reFX
@@ -0,0 +1,817 @@
+namespace reFX
+{
+
+namespace
+{
+
+//==============================================================================
+/** The entries of a palette being read, which replace the old ones only once the
+    whole file has been read successfully.
+*/
+struct ParsedPalette
+{
+    std::vector<juce::uint32> colours;
+    std::vector<juce::uint32> nameOffsets { 0 };
+    std::vector<char> names;
+
+    void add (juce::uint32 argb)
+    {
+        colours.push_back (argb);
+        nameOffsets.push_back ((juce::uint32) names.size());
+    }
+
+    void add (juce::uint32 argb, std::string_view name)
+    {
+        names.insert (names.end(), name.begin(), name.end());
+        add (argb);
+    }
+};
+
+/** Splits a stream into lines, reading it through a fixed buffer so that parsing a
+    large text palette allocates nothing per line. Lines longer than the buffer are
+    cut short.
+*/
+class LineReader
+{
+public:
+    explicit LineReader (juce::InputStream& s)  : stream (s) {}
+
+    bool next (std::string_view& line)
+    {
+        if (std::exchange (skipping, false))
+            skipRestOfLine();
+
+        for (;;)
+        {
+            auto* begin = buffer.data() + start;
+            auto* end = buffer.data() + used;
+            auto* newline = std::find (begin, end, '\n');
+
+            if (newline != end || exhausted || (start == 0 && used == buffer.size()))
+            {
+                if (begin == end && exhausted)
+                    return false;
+
+                line = trimLineEnd ({ begin, size_t (newline - begin) });
+                start = juce::jmin (used, size_t (newline - buffer.data()) + 1);
+
+                // the rest of an overlong line is skipped on the next call, as it would overwrite this one
+                skipping = newline == end && ! exhausted;
+                return true;
+            }
+
+            refill();
+        }
+    }
+
+private:
+    juce::InputStream& stream;
+    std::array<char, 16384> buffer;
+    size_t start = 0, used = 0;
+    bool exhausted = false, skipping = false;
+
+    void refill()
+    {
+        std::memmove (buffer.data(), buffer.data() + start, used - start);
+        used -= start;
+        start = 0;
+
+        auto numRead = stream.read (buffer.data() + used, int (buffer.size() - used));
+
+        if (numRead <= 0)
+            exhausted = true;
+        else
+            used += size_t (numRead);
+    }
+
+    void skipRestOfLine()
+    {
+        for (;;)
+        {
+            start = used;
+            refill();
+
+            auto* newline = std::find (buffer.data(), buffer.data() + used, '\n');
+
+            if (newline != buffer.data() + used || exhausted)
+            {
+                start = juce::jmin (used, size_t (newline - buffer.data()) + 1);
+                return;
+            }
+        }
+    }
+
+    static std::string_view trimLineEnd (std::string_view s)
+    {
+        while (! s.empty() && (s.back() == '\r' || s.back() == '\n'))
+            s.remove_suffix (1);
+
+        return s;
+    }
+};
+
+std::string_view trim (std::string_view s)
+{
+    auto isSpace = [] (char c) { return c == ' ' || c == '\t' || c == '\r'; };
+
+    while (! s.empty() && isSpace (s.front()))   s.remove_prefix (1);
+    while (! s.empty() && isSpace (s.back()))    s.remove_suffix (1);
+
+    return s;
+}
+
+bool parseInt (std::string_view& s, int& value)
+{
+    s = trim (s);
+    auto result = std::from_chars (s.data(), s.data() + s.size(), value);
+
+    if (result.ec != std::errc())
+        return false;
+
+    s.remove_prefix (size_t (result.ptr - s.data()));
+    return true;
+}
+
+//==============================================================================
+juce::Result readGimp (juce::InputStream& stream, ParsedPalette& palette)
+{
+    LineReader reader (stream);
+    std::string_view line;
+
+    if (! reader.next (line) || trim (line) != "GIMP Palette")
+        return juce::Result::fail ("Not a GIMP palette");
+
+    for (int lineNumber = 2; reader.next (line); ++lineNumber)
+    {
+        auto text = trim (line);
+
+        if (text.empty() || text.front() == '#' || text.starts_with ("Name:") || text.starts_with ("Columns:"))
+            continue;
+
+        int r, g, b;
+
+        if (! parseInt (text, r) || ! parseInt (text, g) || ! parseInt (text, b))
+            return juce::Result::fail ("Invalid colour on line " + juce::String (lineNumber));
+
+        palette.add (0xff000000u
+                       | (juce::uint32 (juce::jlimit (0, 255, r)) << 16)
+                       | (juce::uint32 (juce::jlimit (0, 255, g)) << 8)
+                       |  juce::uint32 (juce::jlimit (0, 255, b)),
+                     trim (text));
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result writeGimp (juce::OutputStream& stream, std::span<const juce::uint32> colours,
+                        const std::function<std::string_view (int)>& getName)
+{
+    constexpr std::string_view header = "GIMP Palette\n#\n";
+
+    if (! stream.write (header.data(), header.size()))
+        return juce::Result::fail ("Couldn't write to the stream");
+
+    char text[48];
+
+    for (size_t i = 0; i < colours.size(); ++i)
+    {
+        auto* end = text + sizeof (text);
+        auto* p = text;
+
+        for (int shift : { 16, 8, 0 })
+        {
+            auto component = int ((colours[i] >> shift) & 0xff);
+
+            // right-align in three columns like GIMP does
+            *p++ = ' ';
+            if (component < 100)  *p++ = ' ';
+            if (component < 10)   *p++ = ' ';
+
+            p = std::to_chars (p, end, component).ptr;
+        }
+
+        *p++ = '\t';
+
+        auto name = getName (int (i));
+
+        if (! stream.write (text + 1, size_t (p - text - 1))
+             || ! (name.empty() || stream.write (name.data(), name.size()))
+             || ! stream.writeByte ('\n'))
+            return juce::Result::fail ("Couldn't write to the stream");
+    }
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+// Adobe Swatch Exchange: big-endian blocks, names in UTF-16 with a terminating null
+constexpr juce::uint16 aseColourEntry = 0x0001;
+
+float readFloatBigEndian (juce::InputStream& stream)
+{
+    return std::bit_cast<float> ((juce::uint32) stream.readIntBigEndian());
+}
+
+void appendUTF8 (std::vector<char>& dest, juce::uint32 codePoint)
+{
+    if (codePoint < 0x80)
+    {
+        dest.push_back ((char) codePoint);
+    }
+    else if (codePoint < 0x800)
+    {
+        dest.push_back ((char) (0xc0 | (codePoint >> 6)));
+        dest.push_back ((char) (0x80 | (codePoint & 0x3f)));
+    }
+    else if (codePoint < 0x10000)
+    {
+        dest.push_back ((char) (0xe0 | (codePoint >> 12)));
+        dest.push_back ((char) (0x80 | ((codePoint >> 6) & 0x3f)));
+        dest.push_back ((char) (0x80 | (codePoint & 0x3f)));
+    }
+    else
+    {
+        dest.push_back ((char) (0xf0 | (codePoint >> 18)));
+        dest.push_back ((char) (0x80 | ((codePoint >> 12) & 0x3f)));
+        dest.push_back ((char) (0x80 | ((codePoint >> 6) & 0x3f)));
+        dest.push_back ((char) (0x80 | (codePoint & 0x3f)));
+    }
+}
+
+/** Calls fn with each UTF-16 code unit of some UTF-8 text. */
+template <typename Fn>
+void forEachUTF16 (std::string_view utf8, Fn&& fn)
+{
+    for (size_t i = 0; i < utf8.size();)
+    {
+        auto lead = (juce::uint8) utf8[i];
+        auto numExtra = lead >= 0xf0 ? 3 : (lead >= 0xe0 ? 2 : (lead >= 0xc0 ? 1 : 0));
+        auto codePoint = juce::uint32 (numExtra == 0 ? lead : (lead & (0x3f >> numExtra)));
+
+        for (int n = 0; n < numExtra && ++i < utf8.size(); ++n)
+            codePoint = (codePoint << 6) | ((juce::uint8) utf8[i] & 0x3f);
+
+        ++i;
+
+        if (codePoint >= 0x10000)
+        {
+            codePoint -= 0x10000;
+            fn (juce::uint16 (0xd800 + (codePoint >> 10)));
+            fn (juce::uint16 (0xdc00 + (codePoint & 0x3ff)));
+        }
+        else
+        {
+            fn (juce::uint16 (codePoint));
+        }
+    }
+}
+
+/** Moves a stream to a position, returning false if the stream ends before it. Streams
+    stop at their end rather than failing a seek past it, so this checks where it stopped.
+*/
+bool skipTo (juce::InputStream& stream, juce::int64 position)
+{
+    if (stream.getPosition() != position)
+        stream.setPosition (position);
+
+    return stream.getPosition() == position;
+}
+
+juce::Result readASE (juce::InputStream& stream, ParsedPalette& palette)
+{
+    // the magic number, the major and minor versions, and the number of blocks
+    char header[12];
+
+    if (stream.read (header, 12) != 12 || std::string_view (header, 4) != "ASEF")
+        return juce::Result::fail ("Not an Adobe Swatch Exchange file");
+
+    auto numBlocks = juce::ByteOrder::bigEndianInt (header + 8);
+
+    for (juce::uint32 block = 0; block < numBlocks; ++block)
+    {
+        char blockHeader[6];
+
+        if (stream.read (blockHeader, 6) != 6)
+            return juce::Result::fail ("The file is truncated");
+
+        auto type = juce::ByteOrder::bigEndianShort (blockHeader);
+        auto length = (juce::int64) juce::ByteOrder::bigEndianInt (blockHeader + 2);
+        auto blockEnd = stream.getPosition() + length;
+
+        if (type != aseColourEntry)
+        {
+            if (! skipTo (stream, blockEnd))
+                return juce::Result::fail ("The file is truncated");
+
+            continue;
+        }
+
+        auto nameStart = palette.names.size();
+        auto numUnits = (int) (juce::uint16) stream.readShortBigEndian();
+        juce::uint32 highSurrogate = 0;
+
+        for (int i = 0; i < numUnits; ++i)
+        {
+            auto unit = (juce::uint32) (juce::uint16) stream.readShortBigEndian();
+
+            if (unit >= 0xd800 && unit < 0xdc00)
+                highSurrogate = unit;
+            else if (unit >= 0xdc00 && unit < 0xe000 && highSurrogate != 0)
+                appendUTF8 (palette.names, 0x10000 + ((std::exchange (highSurrogate, 0) - 0xd800) << 10) + (unit - 0xdc00));
+            else if (unit != 0)
+                appendUTF8 (palette.names, unit);
+        }
+
+        char model[4];
+        stream.read (model, 4);
+
+        juce::Colour colour;
+        std::string_view modelName (model, 4);
+
+        if (modelName == "RGB ")
+        {
+            auto r = readFloatBigEndian (stream);
+            auto g = readFloatBigEndian (stream);
+            auto b = readFloatBigEndian (stream);
+            colour = juce::Colour::fromFloatRGBA (r, g, b, 1.0f);
+        }
+        else if (modelName == "CMYK")
+        {
+            auto c = readFloatBigEndian (stream);
+            auto m = readFloatBigEndian (stream);
+            auto y = readFloatBigEndian (stream);
+            auto k = 1.0f - readFloatBigEndian (stream);
+            colour = juce::Colour::fromFloatRGBA ((1.0f - c) * k, (1.0f - m) * k, (1.0f - y) * k, 1.0f);
+        }
+        else if (modelName == "LAB ")
+        {
+            auto L = readFloatBigEndian (stream);
+            auto a = readFloatBigEndian (stream);
+            auto b = readFloatBigEndian (stream);
+            colour = ColourModel::getCIELab().toColour ({ L, (a + 128.0f) / 255.0f, (b + 128.0f) / 255.0f }, 1.0f).getColour();
+        }
+        else if (modelName == "Gray")
+        {
+            colour = juce::Colour::greyLevel (readFloatBigEndian (stream));
+        }
+        else
+        {
+            palette.names.resize (nameStart);
+
+            if (! skipTo (stream, blockEnd))
+                return juce::Result::fail ("The file is truncated");
+
+            continue;
+        }
+
+        palette.add (colour.getARGB());
+
+        // skip the colour type and anything a newer version may have added; reads past
+        // the end of a truncated block return zeros, so this is where it's noticed
+        if (! skipTo (stream, blockEnd))
+            return juce::Result::fail ("The file is truncated");
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result writeASE (juce::OutputStream& stream, std::span<const juce::uint32> colours,
+                       const std::function<std::string_view (int)>& getName)
+{
+    auto ok = stream.write ("ASEF", 4)
+           && stream.writeShortBigEndian (1)
+           && stream.writeShortBigEndian (0)
+           && stream.writeIntBigEndian ((int) colours.size());
+
+    for (size_t i = 0; i < colours.size() && ok; ++i)
+    {
+        auto name = getName (int (i));
+
+        int numUnits = 1;
+        forEachUTF16 (name, [&] (juce::uint16) { ++numUnits; });
+
+        auto length = 2 + numUnits * 2 + 4 + 3 * 4 + 2;
+
+        ok = stream.writeShortBigEndian ((short) aseColourEntry)
+          && stream.writeIntBigEndian (length)
+          && stream.writeShortBigEndian ((short) numUnits);
+
+        forEachUTF16 (name, [&] (juce::uint16 unit) { ok = ok && stream.writeShortBigEndian ((short) unit); });
+
+        juce::Colour colour (colours[i]);
+
+        ok = ok && stream.writeShortBigEndian (0)
+                && stream.write ("RGB ", 4)
+                && stream.writeIntBigEndian ((int) std::bit_cast<juce::uint32> (colour.getFloatRed()))
+                && stream.writeIntBigEndian ((int) std::bit_cast<juce::uint32> (colour.getFloatGreen()))
+                && stream.writeIntBigEndian ((int) std::bit_cast<juce::uint32> (colour.getFloatBlue()))
+                && stream.writeShortBigEndian (2);  // a normal, rather than global or spot, colour
+    }
+
+    return ok ? juce::Result::ok() : juce::Result::fail ("Couldn't write to the stream");
+}
+
+//==============================================================================
+// The binary format is the in-memory layout, little-endian and 4-byte aligned:
+// a header, the ARGB values, numColours + 1 name offsets, then the UTF-8 names.
+struct BinaryHeader
+{
+    char magic[4];
+    juce::uint32 version;
+    juce::uint32 numColours;
+    juce::uint32 numNameBytes;
+};
+
+static_assert (sizeof (BinaryHeader) == 16);
+
+constexpr juce::uint32 binaryVersion = 1;
+constexpr std::string_view binaryMagic = "RFXP";
+
+bool isValidHeader (const BinaryHeader& header)
+{
+    return std::string_view (header.magic, 4) == binaryMagic
+        && juce::ByteOrder::swapIfBigEndian (header.version) == binaryVersion;
+}
+
+/** Checks that the offsets only ever increase and stay inside the name block, so
+    that a corrupt file can't make getNameUTF8() read out of bounds.
+*/
+bool areValidOffsets (std::span<const juce::uint32> offsets, juce::uint32 numNameBytes)
+{
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != numNameBytes)
+        return false;
+
+    return std::is_sorted (offsets.begin(), offsets.end());
+}
+
+template <typename T>
+bool readLittleEndian (juce::InputStream& stream, std::vector<T>& dest, size_t num)
+{
+    // grown a chunk at a time as the data arrives, so that the sizes in a corrupt header
+    // can't make a stream of unknown length allocate more than it really holds
+    constexpr size_t chunkSize = (size_t (1) << 20) / sizeof (T);
+
+    dest.clear();
+
+    while (dest.size() < num)
+    {
+        auto start = dest.size();
+        auto numInChunk = std::min (chunkSize, num - start);
+        auto numBytes = numInChunk * sizeof (T);
+
+        dest.resize (start + numInChunk);
+
+        if ((size_t) stream.read (dest.data() + start, (int) numBytes) != numBytes)
+            return false;
+    }
+
+    if constexpr (std::endian::native == std::endian::big && sizeof (T) == 4)
+        for (auto& v : dest)
+            v = juce::ByteOrder::swap (v);
+
+    return true;
+}
+
+juce::Result readBinary (juce::InputStream& stream, ParsedPalette& palette)
+{
+    BinaryHeader header;
+
+    if (stream.read (&header, sizeof (header)) != (int) sizeof (header) || ! isValidHeader (header))
+        return juce::Result::fail ("Not a palette file");
+
+    auto numColours = juce::ByteOrder::swapIfBigEndian (header.numColours);
+    auto numNameBytes = juce::ByteOrder::swapIfBigEndian (header.numNameBytes);
+
+    auto numBytesNeeded = (juce::uint64 (numColours) * 2 + 1) * 4 + numNameBytes;
+    auto totalLength = stream.getTotalLength();
+
+    if (totalLength >= 0 && juce::uint64 (juce::jmax (juce::int64 (0), totalLength - stream.getPosition())) < numBytesNeeded)
+        return juce::Result::fail ("The file is truncated");
+
+    if (! readLittleEndian (stream, palette.colours, numColours)
+         || ! readLittleEndian (stream, palette.nameOffsets, size_t (numColours) + 1)
+         || ! readLittleEndian (stream, palette.names, numNameBytes))
+        return juce::Result::fail ("The file is truncated");
+
+    if (! areValidOffsets (palette.nameOffsets, numNameBytes))
+        return juce::Result::fail ("The file is corrupt");
+
+    return juce::Result::ok();
+}
+
+template <typename T>
+bool writeLittleEndian (juce::OutputStream& stream, std::span<const T> values)
+{
+    if constexpr (std::endian::native == std::endian::big && sizeof (T) == 4)
+    {
+        for (auto v : values)
+            if (! stream.writeInt ((int) v))
+                return false;
+
+        return true;
+    }
+    else
+    {
+        // an empty vector's data() may be null, which the streams assert on
+        return values.empty() || stream.write (values.data(), values.size_bytes());
+    }
+}
+
+} // namespace
+
+//==============================================================================
+SwatchPalette::SwatchPalette()
+{
+    updateViews();
+}
+
+SwatchPalette::~SwatchPalette() = default;
+
+//==============================================================================
+juce::Colour SwatchPalette::getColour (int index) const noexcept
+{
+    if (! juce::isPositiveAndBelow (index, size()))
+    {
+        jassertfalse;
+        return {};
+    }
+
+    return juce::Colour (colours[size_t (index)]);
+}
+
+std::string_view SwatchPalette::getNameUTF8 (int index) const noexcept
+{
+    if (! juce::isPositiveAndBelow (index, size()))
+        return {};
+
+    auto start = nameOffsets[size_t (index)];
+    return { names.data() + start, size_t (nameOffsets[size_t (index) + 1] - start) };
+}
+
+juce::String SwatchPalette::getName (int index) const
+{
+    auto name = getNameUTF8 (index);
+    return juce::String::fromUTF8 (name.data(), (int) name.size());
+}
+
+void SwatchPalette::setColour (int index, juce::Colour newColour)
+{
+    if (! juce::isPositiveAndBelow (index, size()))
+    {
+        jassertfalse;
+        return;
+    }
+
+    if (colours[size_t (index)] != newColour.getARGB())
+    {
+        makeWritable();
+        colourStorage[size_t (index)] = newColour.getARGB();
+        changed ({ index, index + 1 });
+    }
+}
+
+void SwatchPalette::add (juce::Colour colour, std::string_view nameUTF8)
+{
+    makeWritable();
+
+    nameStorage.insert (nameStorage.end(), nameUTF8.begin(), nameUTF8.end());
+    nameOffsetStorage.push_back ((juce::uint32) nameStorage.size());
+    colourStorage.push_back (colour.getARGB());
+    updateViews();
+
+    changed ({ size() - 1, size() });
+}
+
+void SwatchPalette::remove (int index)
+{
+    if (! juce::isPositiveAndBelow (index, size()))
+    {
+        jassertfalse;
+        return;
+    }
+
+    makeWritable();
+
+    auto oldSize = size();
+    auto start = nameOffsetStorage[size_t (index)];
+    auto length = nameOffsetStorage[size_t (index) + 1] - start;
+
+    nameStorage.erase (nameStorage.begin() + start, nameStorage.begin() + start + length);
+    nameOffsetStorage.erase (nameOffsetStorage.begin() + index + 1);
+    colourStorage.erase (colourStorage.begin() + index);
+
+    for (auto i = size_t (index) + 1; i < nameOffsetStorage.size(); ++i)
+        nameOffsetStorage[i] -= length;
+
+    updateViews();
+    changed ({ index, oldSize });
+}
+
+void SwatchPalette::clear()
+{
+    auto oldSize = size();
+
+    mappedFile = nullptr;
+    colourStorage.clear();
+    nameOffsetStorage.assign (1, 0);
+    nameStorage.clear();
+    updateViews();
+
+    if (oldSize > 0)
+        changed ({ 0, oldSize });
+}
+
+void SwatchPalette::reserve (int numColours, size_t numNameBytes)
+{
+    makeWritable();
+
+    colourStorage.reserve (size_t (numColours));
+    nameOffsetStorage.reserve (size_t (numColours) + 1);
+    nameStorage.reserve (numNameBytes);
+    updateViews();
+}
+
+//==============================================================================
+std::optional<SwatchPalette::Format> SwatchPalette::getFormatForFile (const juce::File& file)
+{
+    if (file.hasFileExtension ("gpl"))      return Format::gimp;
+    if (file.hasFileExtension ("ase"))      return Format::ase;
+    if (file.hasFileExtension ("rfxpal"))   return Format::binary;
+
+    return {};
+}
+
+juce::Result SwatchPalette::loadFrom (juce::InputStream& stream, Format format)
+{
+    ParsedPalette parsed;
+
+    auto result = format == Format::gimp ? readGimp (stream, parsed)
+                : format == Format::ase  ? readASE (stream, parsed)
+                                         : readBinary (stream, parsed);
+
+    if (result.failed())
+        return result;
+
+    auto oldSize = size();
+
+    mappedFile = nullptr;
+    colourStorage = std::move (parsed.colours);
+    nameOffsetStorage = std::move (parsed.nameOffsets);
+    nameStorage = std::move (parsed.names);
+    updateViews();
+
+    changed ({ 0, juce::jmax (oldSize, size()) });
+    return result;
+}
+
+juce::Result SwatchPalette::loadFrom (const juce::File& file)
+{
+    auto format = getFormatForFile (file);
+
+    if (! format.has_value())
+        return juce::Result::fail ("Unknown palette format: " + file.getFileExtension());
+
+    if (*format == Format::binary && std::endian::native == std::endian::little)
+    {
+        // use the file in place, it has exactly the layout of the spans
+        auto mapped = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readOnly);
+        auto* data = static_cast<const char*> (mapped->getData());
+        auto numBytes = mapped->getSize();
+
+        if (data == nullptr || numBytes < sizeof (BinaryHeader))
+            return juce::Result::fail ("Couldn't open " + file.getFullPathName());
+
+        BinaryHeader header;
+        std::memcpy (&header, data, sizeof (header));
+
+        auto numColours = size_t (header.numColours);
+        auto coloursStart = sizeof (BinaryHeader);
+        auto offsetsStart = coloursStart + numColours * 4;
+        auto namesStart = offsetsStart + (numColours + 1) * 4;
+
+        if (! isValidHeader (header) || numBytes < namesStart + header.numNameBytes)
+            return juce::Result::fail ("Not a palette file");
+
+        std::span<const juce::uint32> offsets (reinterpret_cast<const juce::uint32*> (data + offsetsStart), numColours + 1);
+
+        if (! areValidOffsets (offsets, header.numNameBytes))
+            return juce::Result::fail ("The file is corrupt");
+
+        auto oldSize = size();
+
+        mappedFile = std::move (mapped);
+        colours = { reinterpret_cast<const juce::uint32*> (data + coloursStart), numColours };
+        nameOffsets = offsets;
+        names = { data + namesStart, size_t (header.numNameBytes) };
+
+        colourStorage.clear();
+        nameOffsetStorage.clear();
+        nameStorage.clear();
+
+        changed ({ 0, juce::jmax (oldSize, size()) });
+        return juce::Result::ok();
+    }
+
+    juce::FileInputStream stream (file);
+
+    if (! stream.openedOk())
+        return juce::Result::fail ("Couldn't open " + file.getFullPathName());
+
+    return loadFrom (stream, *format);
+}
+
+juce::Result SwatchPalette::writeTo (juce::OutputStream& stream, Format format) const
+{
+    auto getName = [this] (int index) { return getNameUTF8 (index); };
+
+    if (format == Format::gimp)
+        return writeGimp (stream, colours, getName);
+
+    if (format == Format::ase)
+        return writeASE (stream, colours, getName);
+
+    BinaryHeader header;
+    std::memcpy (header.magic, binaryMagic.data(), 4);
+    header.version = juce::ByteOrder::swapIfBigEndian (binaryVersion);
+    header.numColours = juce::ByteOrder::swapIfBigEndian ((juce::uint32) colours.size());
+    header.numNameBytes = juce::ByteOrder::swapIfBigEndian ((juce::uint32) names.size());
+
+    auto ok = stream.write (&header, sizeof (header))
+           && writeLittleEndian (stream, colours)
+           && writeLittleEndian (stream, nameOffsets)
+           && writeLittleEndian (stream, names);
+
+    return ok ? juce::Result::ok() : juce::Result::fail ("Couldn't write to the stream");
+}
+
+juce::Result SwatchPalette::saveTo (const juce::File& file) const
+{
+    auto format = getFormatForFile (file);
+
+    if (! format.has_value())
+        return juce::Result::fail ("Unknown palette format: " + file.getFileExtension());
+
+    // written next to the file and then moved over it: a palette loaded from this file
+    // may still be mapped from it, and truncating the file in place would pull the
+    // colours out from under writeTo()
+    juce::TemporaryFile temporary (file);
+
+    {
+        juce::FileOutputStream stream (temporary.getFile());
+
+        if (! stream.openedOk())
+            return juce::Result::fail ("Couldn't open " + temporary.getFile().getFullPathName());
+
+        auto result = writeTo (stream, *format);
+
+        if (result.failed())
+            return result;
+
+        stream.flush();
+
+        if (stream.getStatus().failed())
+            return stream.getStatus();
+    }
+
+    if (! temporary.overwriteTargetFileWithTemporary())
+        return juce::Result::fail ("Couldn't write " + file.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+void SwatchPalette::makeWritable()
+{
+    if (mappedFile == nullptr)
+        return;
+
+    colourStorage.assign (colours.begin(), colours.end());
+    nameOffsetStorage.assign (nameOffsets.begin(), nameOffsets.end());
+    nameStorage.assign (names.begin(), names.end());
+
+    mappedFile = nullptr;
+    updateViews();
+}
+
+void SwatchPalette::updateViews() noexcept
+{
+    colours = colourStorage;
+    nameOffsets = nameOffsetStorage;
+    names = nameStorage;
+}
+
+void SwatchPalette::changed (juce::Range<int> range)
+{
+    pendingChange = pendingChange.has_value() ? pendingChange->getUnionWith (range) : range;
+
+    if (batchDepth == 0)
+        sendPendingChange();
+}
+
+void SwatchPalette::sendPendingChange()
+{
+    if (auto range = std::exchange (pendingChange, std::nullopt))
+        listeners.call ([this, r = *range] (Listener& l) { l.paletteChanged (*this, r); });
+}
+
+} // namespace reFX
@@ -0,0 +1,153 @@
+#pragma once
+
+namespace reFX
+{
+
+//==============================================================================
+/**
+    A list of named colours, stored contiguously.
+
+    Colours are kept as packed 32-bit ARGB values in one array, and their names
+    as UTF-8 in one block of text with an offset per entry, so a palette of tens
+    of thousands of colours is a few allocations rather than one per entry.
+    Names are only turned into juce::String objects when getName() asks for
+    one.
+
+    Palettes can be read and written as GIMP palettes (.gpl), Adobe Swatch
+    Exchange files (.ase), and a compact binary format (.rfxpal) whose layout
+    matches the in-memory one. A binary palette loaded from a file is
+    memory-mapped and used in place until it is first modified.
+
+    Listeners are told about changes once per batch: every change made while a
+    ScopedBatch is alive, or by a single call such as loadFrom(), produces one
+    callback with the range of entries that changed.
+
+    @tags{GUI}
+*/
+class SwatchPalette
+{
+public:
+    //==============================================================================
+    SwatchPalette();
+    ~SwatchPalette();
+
+    //==============================================================================
+    /** Returns the number of colours. */
+    int size() const noexcept                       { return (int) colours.size(); }
+
+    /** Returns true if the palette has no colours. */
+    bool isEmpty() const noexcept                   { return colours.empty(); }
+
+    /** Returns one of the colours. */
+    juce::Colour getColour (int index) const noexcept;
+
+    /** Returns the packed ARGB values of all colours. */
+    std::span<const juce::uint32> getColours() const noexcept   { return colours; }
+
+    /** Returns a colour's name as UTF-8, without copying it. */
+    std::string_view getNameUTF8 (int index) const noexcept;
+
+    /** Returns a colour's name. */
+    juce::String getName (int index) const;
+
+    /** Changes one of the colours. */
+    void setColour (int index, juce::Colour newColour);
+
+    /** Adds a colour to the end of the palette. */
+    void add (juce::Colour colour, std::string_view nameUTF8 = {});
+
+    /** Removes a colour. */
+    void remove (int index);
+
+    /** Removes all colours. */
+    void clear();
+
+    /** Reserves space for a number of colours and bytes of name text. */
+    void reserve (int numColours, size_t numNameBytes = 0);
+
+    //==============================================================================
+    /** The file formats that palettes can be read from and written to. */
+    enum class Format
+    {
+        gimp,       /**< GIMP palette, .gpl */
+        ase,        /**< Adobe Swatch Exchange, .ase */
+        binary      /**< this class's own format, .rfxpal */
+    };
+
+    /** Returns the format that a file's extension stands for, if any. */
+    static std::optional<Format> getFormatForFile (const juce::File& file);
+
+    /** Replaces the contents of the palette with a palette read from a stream. */
+    juce::Result loadFrom (juce::InputStream& stream, Format format);
+
+    /** Replaces the contents of the palette with a palette file, choosing the format
+        from the file's extension. Binary palettes are memory-mapped.
+    */
+    juce::Result loadFrom (const juce::File& file);
+
+    /** Writes the palette to a stream. */
+    juce::Result writeTo (juce::OutputStream& stream, Format format) const;
+
+    /** Writes the palette to a file, choosing the format from the file's extension.
+
+        The palette is written to a temporary file that then replaces the target, so
+        a palette can be saved back to the .rfxpal file it's mapped from.
+    */
+    juce::Result saveTo (const juce::File& file) const;
+
+    //==============================================================================
+    /** Receives notifications when a palette changes. */
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        /** Called after a batch of changes. Entries in changedRange were modified,
+            added or removed; if the size changed, the range runs to the end.
+        */
+        virtual void paletteChanged (SwatchPalette& palette, juce::Range<int> changedRange) = 0;
+    };
+
+    void addListener (Listener* listener)           { listeners.add (listener); }
+    void removeListener (Listener* listener)        { listeners.remove (listener); }
+
+    /** Holds back notifications while it exists, then sends a single one covering
+        everything that changed. Batches can be nested.
+    */
+    class ScopedBatch
+    {
+    public:
+        explicit ScopedBatch (SwatchPalette& p)     : palette (p)   { ++palette.batchDepth; }
+        ~ScopedBatch()                                              { if (--palette.batchDepth == 0) palette.sendPendingChange(); }
+
+    private:
+        SwatchPalette& palette;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBatch)
+    };
+
+private:
+    //==============================================================================
+    /** The entries, either pointing into the vectors below or into a mapped file. */
+    std::span<const juce::uint32> colours;
+    std::span<const juce::uint32> nameOffsets;
+    std::span<const char> names;
+
+    std::vector<juce::uint32> colourStorage;
+    std::vector<juce::uint32> nameOffsetStorage { 0 };
+    std::vector<char> nameStorage;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+
+    juce::ListenerList<Listener> listeners;
+    int batchDepth = 0;
+    std::optional<juce::Range<int>> pendingChange;
+
+    void makeWritable();
+    void updateViews() noexcept;
+    void changed (juce::Range<int> range);
+    void sendPendingChange();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SwatchPalette)
+};
+
+} // namespace reFX
@@ -7,10 +7,36 @@
  #error "Incorrect use of reFX cpp file"
 #endif
 
+#include <atomic>
+#include <bit>
+#include <charconv>
 #include <locale>
+#include <mutex>
+#include <numeric>
+
+#if defined (__AVX2__)
+ #define REFX_COLOUR_USE_AVX2 1
+#endif
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define REFX_COLOUR_USE_SSE2 1
+ #include <immintrin.h>
+#elif defined (__aarch64__) || defined (_M_ARM64)
+ #define REFX_COLOUR_USE_NEON 1
+ #include <arm_neon.h>
+#endif
 
 #include "refx_colourselector.h"
 
 #include "Source/refx_ColourSelectorLF.cpp"
 #include "Source/refx_DeepColour.cpp"
+#include "Source/refx_ColourConversion.cpp"
+#include "Source/refx_ColourModel.cpp"
+#include "Source/refx_ColourText.cpp"
+#include "Source/refx_SwatchPalette.cpp"
+#include "Source/refx_NearestColourIndex.cpp"
+#include "Source/refx_ImageSampler.cpp"
+#include "Source/refx_PaletteExtractor.cpp"
 #include "Source/refx_ColourSelector.cpp"
+#include "Source/refx_ColourPlane.cpp"
+#include "Source/refx_PolarPlane.cpp"
@@ -13,7 +13,7 @@
   version:              1.0.0
   name:                 reFX Color Picker
   description:
-  minimumCppStandard:   17
+  minimumCppStandard:   20
 
   dependencies:         juce_core juce_gui_basics
 
@@ -24,7 +24,12 @@
 #pragma once
 #define REFX_COLORPICKER_H_INCLUDED
 
+#include <array>
+#include <atomic>
+#include <list>
 #include <optional>
+#include <span>
+#include <string_view>
 #include <unordered_map>
 
 #include <juce_core/juce_core.h>
@@ -32,4 +37,13 @@
 
 #include "Source/refx_ColourSelectorLF.h"
 #include "Source/refx_DeepColour.h"
+#include "Source/refx_ColourConversion.h"
+#include "Source/refx_ColourModel.h"
+#include "Source/refx_ColourText.h"
+#include "Source/refx_SwatchPalette.h"
+#include "Source/refx_NearestColourIndex.h"
+#include "Source/refx_ImageSampler.h"
+#include "Source/refx_PaletteExtractor.h"
 #include "Source/refx_ColourSelector.h"
+#include "Source/refx_ColourPlane.h"
+#include "Source/refx_PolarPlane.h"